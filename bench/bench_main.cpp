@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+#ifndef BENCH_RESULTS_DIR
+#define BENCH_RESULTS_DIR "."
+#endif
+
+// Writes JSON results to bench_results.json in the build directory unless
+// --benchmark_out is given, console output stays human readable.
+int main(int argc, char** argv)
+{
+  std::vector<char*> args(argv, argv + argc);
+  bool has_out = false;
+  for (int i = 1; i < argc; ++i)
+    if (std::strncmp(argv[i], "--benchmark_out=", 16) == 0)
+      has_out = true;
+
+  char out[] = "--benchmark_out=" BENCH_RESULTS_DIR "/bench_results.json";
+  char format[] = "--benchmark_out_format=json";
+  if (!has_out) {
+    args.push_back(out);
+    args.push_back(format);
+  }
+
+  int args_size = args.size();
+  benchmark::Initialize(&args_size, args.data());
+  if (benchmark::ReportUnrecognizedArguments(args_size, args.data()))
+    return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef GRAPH_BENCH_FIXTURE_HPP
+#define GRAPH_BENCH_FIXTURE_HPP
+
+#include "../../test/graph/fixture.hpp"
+
+#include <graph/graph_generators.hpp>
+#include <graph/marching_squares.hpp>
+
+#include <random>
+#include <vector>
+
+// Synthetic, seeded inputs, so that runs of different versions are comparable.
+
+constexpr unsigned bench_seed = 42;
+
+/// Grid with number_of_rows * number_of_rows vertices, every vertex connected to its 8 neighbours.
+inline std::vector<Graph<float2>::Edge> benchGrid(std::size_t number_of_rows)
+{
+  return gridEdges<float2>(number_of_rows, number_of_rows, true);
+}
+
+/// Unit density random points, average degree about 7.
+inline std::vector<Graph<float2>::Edge> benchGeometric(std::size_t number_of_vertices)
+{
+  return randomGeometricEdges<float2>(number_of_vertices, 1.5, bench_seed);
+}
+
+/// Preferential attachment, 4 edges per new vertex.
+inline std::vector<Graph<int>::Edge> benchPowerLaw(std::size_t number_of_vertices)
+{
+  return barabasiAlbertEdges<int>(number_of_vertices, 4, bench_seed);
+}
+
+/// Random solid rectangles on a free background, like a level map.
+inline ImageMatrix benchMap(std::size_t size)
+{
+  std::mt19937 gen(bench_seed);
+  std::uniform_int_distribution<std::size_t> pos(0, size - 1);
+  std::uniform_int_distribution<std::size_t> extent(1, std::max<std::size_t>(1, size / 8));
+
+  std::vector<ImageMatrix::CellType> cells(size * size, ImageMatrix::FREE);
+  for (std::size_t r = 0; r < size / 2; ++r) {
+    const std::size_t x0 = pos(gen), y0 = pos(gen);
+    const std::size_t x1 = std::min(size, x0 + extent(gen)), y1 = std::min(size, y0 + extent(gen));
+    for (std::size_t y = y0; y < y1; ++y)
+      for (std::size_t x = x0; x < x1; ++x)
+        cells[y * size + x] = ImageMatrix::SOLID;
+  }
+  return ImageMatrix(size, size, cells);
+}
+
+#endif // GRAPH_BENCH_FIXTURE_HPP
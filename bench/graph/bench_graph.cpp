@@ -0,0 +1,134 @@
+#include <graph/graph.hpp>
+#include <graph/graphwd.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.hpp"
+
+namespace {
+
+template <typename V>
+void addEdges(benchmark::State& state, const std::vector<typename Graph<V>::Edge>& edges)
+{
+  for (auto _ : state) {
+    Graph<V> g;
+    for (const auto& e : edges)
+      g.addEdge(e.source, e.destination);
+    benchmark::DoNotOptimize(g);
+  }
+  state.SetItemsProcessed(state.iterations() * edges.size());
+}
+
+template <typename V>
+void removeVertices(benchmark::State& state, const std::vector<typename Graph<V>::Edge>& edges)
+{
+  const Graph<V> g(edges);
+  const std::vector<V> vertices = g.vertices();
+  const std::size_t number_of_removals = std::min<std::size_t>(vertices.size(), 64);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    Graph<V> copy(g);
+    state.ResumeTiming();
+    for (std::size_t i = 0; i < number_of_removals; ++i)
+      copy.removeVertex(vertices[i]);
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations() * number_of_removals);
+}
+
+template <typename V>
+void neighboursOfAll(benchmark::State& state, const std::vector<typename Graph<V>::Edge>& edges)
+{
+  const Graph<V> g(edges);
+  const std::vector<V> vertices = g.vertices();
+
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (const auto& v : vertices)
+      sum += g.neighboursOf(v).size();
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * vertices.size());
+}
+
+template <typename V>
+void allEdges(benchmark::State& state, const std::vector<typename Graph<V>::Edge>& edges)
+{
+  const Graph<V> g(edges);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(::edges(g));
+
+  state.SetItemsProcessed(state.iterations() * edges.size());
+}
+
+template <GraphWDLayout L>
+void sumWeightsOfAll(benchmark::State& state, const std::vector<Graph<float2>::Edge>& edges)
+{
+  GraphWD<float2, float, L> g(false);
+  fillGraph(g, edges, [](const float2& a, const float2& b) { return std::abs(a.x - b.x) + std::abs(a.y - b.y); });
+  const std::vector<float2> vertices = g.vertices();
+
+  for (auto _ : state) {
+    float sum = 0;
+    for (const auto& v : vertices)
+      g.forEachEdgeFrom(v, [&sum](const float2&, float w) { sum += w; });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * g.numberOfEdges());
+}
+
+} // anonym namespace
+
+
+static void BM_Graph_addEdge_grid(benchmark::State& state) { addEdges<float2>(state, benchGrid(state.range(0))); }
+static void BM_Graph_addEdge_geometric(benchmark::State& state) { addEdges<float2>(state, benchGeometric(state.range(0))); }
+static void BM_Graph_addEdge_powerlaw(benchmark::State& state) { addEdges<int>(state, benchPowerLaw(state.range(0))); }
+BENCHMARK(BM_Graph_addEdge_grid)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Graph_addEdge_geometric)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Graph_addEdge_powerlaw)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+
+static void BM_Graph_removeVertex_grid(benchmark::State& state) { removeVertices<float2>(state, benchGrid(state.range(0))); }
+static void BM_Graph_removeVertex_powerlaw(benchmark::State& state) { removeVertices<int>(state, benchPowerLaw(state.range(0))); }
+BENCHMARK(BM_Graph_removeVertex_grid)->Arg(32)->Arg(128)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Graph_removeVertex_powerlaw)->Arg(1 << 10)->Arg(1 << 14)->Unit(benchmark::kMillisecond);
+
+static void BM_Graph_neighboursOf_grid(benchmark::State& state) { neighboursOfAll<float2>(state, benchGrid(state.range(0))); }
+static void BM_Graph_neighboursOf_geometric(benchmark::State& state) { neighboursOfAll<float2>(state, benchGeometric(state.range(0))); }
+static void BM_Graph_neighboursOf_powerlaw(benchmark::State& state) { neighboursOfAll<int>(state, benchPowerLaw(state.range(0))); }
+BENCHMARK(BM_Graph_neighboursOf_grid)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Graph_neighboursOf_geometric)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Graph_neighboursOf_powerlaw)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+
+static void BM_Graph_edges_grid(benchmark::State& state) { allEdges<float2>(state, benchGrid(state.range(0))); }
+static void BM_Graph_edges_powerlaw(benchmark::State& state) { allEdges<int>(state, benchPowerLaw(state.range(0))); }
+BENCHMARK(BM_Graph_edges_grid)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Graph_edges_powerlaw)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+
+static void BM_Graph_addEdges_bulk_geometric(benchmark::State& state)
+{
+  const std::vector<Graph<float2>::Edge> edges = benchGeometric(state.range(0));
+  for (auto _ : state) {
+    Graph<float2> g;
+    g.addEdges(edges);
+    benchmark::DoNotOptimize(g);
+  }
+  state.SetItemsProcessed(state.iterations() * edges.size());
+}
+BENCHMARK(BM_Graph_addEdges_bulk_geometric)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMillisecond);
+
+static void BM_Generators_rmat(benchmark::State& state)
+{
+  for (auto _ : state)
+    benchmark::DoNotOptimize(rmatEdges<int>(state.range(0), 16, bench_seed));
+
+  state.SetItemsProcessed(state.iterations() * (16 << state.range(0)));
+}
+BENCHMARK(BM_Generators_rmat)->Arg(12)->Arg(16)->Unit(benchmark::kMillisecond);
+
+/// a relaxation like pass over the weights of every vertex, in each GraphWD layout
+static void BM_GraphWD_forEachEdgeFrom_edgeTo(benchmark::State& state) { sumWeightsOfAll<EDGE_TO_LAYOUT>(state, benchGeometric(state.range(0))); }
+static void BM_GraphWD_forEachEdgeFrom_split(benchmark::State& state) { sumWeightsOfAll<SPLIT_LAYOUT>(state, benchGeometric(state.range(0))); }
+BENCHMARK(BM_GraphWD_forEachEdgeFrom_edgeTo)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_GraphWD_forEachEdgeFrom_split)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 16)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,132 @@
+#include <graph/graph.hpp>
+#include <graph/graph_algorithms.hpp>
+#include <graph/graph_reordering.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.hpp"
+
+
+static void BM_Dijkstra_grid(benchmark::State& state)
+{
+  const std::size_t number_of_rows = state.range(0);
+  const Graph<float2> g(benchGrid(number_of_rows));
+  const float2 source(0, 0);
+  const float2 destination(number_of_rows - 1, number_of_rows - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(dijkstra_shortest_path_to(g, source, destination, std::distanceOf2float2s()));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+BENCHMARK(BM_Dijkstra_grid)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+
+static void BM_Dijkstra_powerlaw(benchmark::State& state)
+{
+  const Graph<int> g(benchPowerLaw(state.range(0)));
+  const int source(0);
+  const int destination(state.range(0) - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(dijkstra_shortest_path_to(g, source, destination, std::distanceOf2ints()));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Dijkstra_powerlaw)->Arg(1 << 10)->Arg(1 << 14)->Unit(benchmark::kMillisecond);
+
+/// the edge lengths inlined instead of called through std::function
+static void BM_Dijkstra_grid_computed(benchmark::State& state)
+{
+  const std::size_t number_of_rows = state.range(0);
+  const Graph<float2> g(benchGrid(number_of_rows));
+  const float2 source(0, 0);
+  const float2 destination(number_of_rows - 1, number_of_rows - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(dijkstraShortestPath(g, source, destination, computedWeight(std::distanceOf2float2s())));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+BENCHMARK(BM_Dijkstra_grid_computed)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/// the edge lengths stored in the graph
+static void BM_Dijkstra_grid_stored(benchmark::State& state)
+{
+  const std::size_t number_of_rows = state.range(0);
+  GraphWD<float2, float, SPLIT_LAYOUT> g(false);
+  fillGraph(g, benchGrid(number_of_rows), std::distanceOf2float2s());
+  const float2 source(0, 0);
+  const float2 destination(number_of_rows - 1, number_of_rows - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(dijkstraShortestPath(g, source, destination));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+BENCHMARK(BM_Dijkstra_grid_stored)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+
+static void BM_AStar_grid_stored(benchmark::State& state)
+{
+  const std::size_t number_of_rows = state.range(0);
+  GraphWD<float2, float, SPLIT_LAYOUT> g(false);
+  fillGraph(g, benchGrid(number_of_rows), std::distanceOf2float2s());
+  const float2 source(0, 0);
+  const float2 destination(number_of_rows - 1, number_of_rows - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(aStarShortestPath(g, source, destination, [&destination](const float2& v) { return distance(v, destination); }));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+BENCHMARK(BM_AStar_grid_stored)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/// the same search over the varint encoded adjacency of a CompressedGraph
+static void BM_Dijkstra_grid_compressed(benchmark::State& state)
+{
+  const std::size_t number_of_rows = state.range(0);
+  const Graph<float2> graph(benchGrid(number_of_rows));
+  const CompressedGraph<float2> g(graph, hilbertOrder(graph));
+  const float2 source(0, 0);
+  const float2 destination(number_of_rows - 1, number_of_rows - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(dijkstraShortestPath(g, source, destination, computedWeight(std::distanceOf2float2s())));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+BENCHMARK(BM_Dijkstra_grid_compressed)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+
+static void BM_ReverseCuthillMcKee_grid(benchmark::State& state)
+{
+  const std::size_t number_of_rows = state.range(0);
+  const Graph<float2> g(benchGrid(number_of_rows));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(reverseCuthillMcKeeOrder(g));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+BENCHMARK(BM_ReverseCuthillMcKee_grid)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/// every edge three times with different lengths, the search relaxes each of them
+static void dijkstraOverParallelEdges(benchmark::State& state, bool collapse)
+{
+  const std::size_t number_of_rows = state.range(0);
+  const std::vector<Graph<float2>::Edge> edges = benchGrid(number_of_rows);
+  GraphWD<float2, float, SPLIT_LAYOUT> g(false);
+  for (int i = 1; i <= 3; ++i)
+    fillGraph(g, edges, [i](const float2& a, const float2& b) { return float(4 - i) * distance(a, b); });
+  if (collapse)
+    g.collapseParallelEdges(KEEP_MIN_WEIGHT);
+  const float2 source(0, 0);
+  const float2 destination(number_of_rows - 1, number_of_rows - 1);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(dijkstraShortestPath(g, source, destination));
+
+  state.SetItemsProcessed(state.iterations() * number_of_rows * number_of_rows);
+}
+static void BM_Dijkstra_grid_parallel(benchmark::State& state) { dijkstraOverParallelEdges(state, false); }
+static void BM_Dijkstra_grid_collapsed(benchmark::State& state) { dijkstraOverParallelEdges(state, true); }
+BENCHMARK(BM_Dijkstra_grid_parallel)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Dijkstra_grid_collapsed)->Arg(32)->Arg(128)->Arg(256)->Unit(benchmark::kMillisecond);
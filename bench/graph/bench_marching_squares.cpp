@@ -0,0 +1,94 @@
+#include <graph/incremental_marching_squares.hpp>
+#include <graph/luminance.hpp>
+#include <graph/marching_squares.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.hpp"
+
+
+static void BM_MarchingSquares(benchmark::State& state)
+{
+  const ImageMatrix image = benchMap(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(marchingSquares(image));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_MarchingSquares)->Arg(16)->Arg(32)->Arg(64)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+static void BM_MarchingSquares_solidMask(benchmark::State& state)
+{
+  const SolidMask mask(benchMap(state.range(0)));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(marchingSquares(mask));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_MarchingSquares_solidMask)->Arg(16)->Arg(32)->Arg(64)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+static void BM_SolidMask_fromImage(benchmark::State& state)
+{
+  const ImageMatrix image = benchMap(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(SolidMask(image).bits_.data());
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_SolidMask_fromImage)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+static void BM_MarchingSquares_parallel(benchmark::State& state)
+{
+  const ImageMatrix image = benchMap(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(parallelMarchingSquares(image));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_MarchingSquares_parallel)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_IncrementalMarchingSquares_edit(benchmark::State& state)
+{
+  IncrementalMarchingSquares ims(benchMap(state.range(0)));
+  std::mt19937 gen(bench_seed);
+  std::uniform_int_distribution<std::size_t> pos(0, state.range(0) - 1);
+  for (auto _ : state) {
+    const size_t2 cell(pos(gen), pos(gen));
+    const bool solid = ims.solidMask().solid(cell.x, cell.y);
+    benchmark::DoNotOptimize(ims.setCell(cell, solid ? ImageMatrix::FREE : ImageMatrix::SOLID));
+  }
+}
+BENCHMARK(BM_IncrementalMarchingSquares_edit)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+namespace {
+
+std::vector<std::uint8_t> benchLuminance(std::size_t size)
+{
+  const ImageMatrix image = benchMap(size);
+  std::vector<std::uint8_t> pixels(size * size);
+  for (std::size_t i = 0; i < pixels.size(); ++i)
+    pixels[i] = image.cells_[i] == ImageMatrix::FREE ? 255 : 0;
+  return pixels;
+}
+
+} // anonym namespace
+
+static void BM_Luminance_toImageMatrix(benchmark::State& state)
+{
+  const std::vector<std::uint8_t> pixels = benchLuminance(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(imageMatrixFromLuminance(state.range(0), state.range(0), pixels.data(), state.range(0)));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_Luminance_toImageMatrix)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+static void BM_Luminance_toSolidMask(benchmark::State& state)
+{
+  const std::vector<std::uint8_t> pixels = benchLuminance(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(solidMaskFromLuminance(state.range(0), state.range(0), pixels.data(), state.range(0)));
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(0));
+}
+BENCHMARK(BM_Luminance_toSolidMask)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,135 @@
+#include <graph/hierarchical_pathfinding.hpp>
+#include <graph/jump_point_search.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.hpp"
+
+namespace {
+
+/// About 20% of the cells covered with small solid blocks, like a large level map.
+ImageMatrix blockMap(std::size_t size)
+{
+  std::mt19937 gen(bench_seed);
+  std::uniform_int_distribution<std::size_t> pos(0, size - 1);
+  std::uniform_int_distribution<std::size_t> extent(1, 8);
+
+  std::vector<ImageMatrix::CellType> cells(size * size, ImageMatrix::FREE);
+  for (std::size_t r = 0; r < size * size / 100; ++r) {
+    const std::size_t x0 = pos(gen), y0 = pos(gen);
+    const std::size_t x1 = std::min(size, x0 + extent(gen)), y1 = std::min(size, y0 + extent(gen));
+    for (std::size_t y = y0; y < y1; ++y)
+      for (std::size_t x = x0; x < x1; ++x)
+        cells[y * size + x] = ImageMatrix::SOLID;
+  }
+  return ImageMatrix(size, size, cells);
+}
+
+/// Goals within max_distance cells of the start along each axis if max_distance > 0.
+std::vector<std::pair<size_t2, size_t2> > randomQueries(const ImageMatrix& image, std::size_t n,
+                                                        std::size_t max_distance = 0)
+{
+  std::mt19937 gen(bench_seed);
+  std::uniform_int_distribution<std::size_t> pos(0, image.width_ * image.height_ - 1);
+  auto freeCell = [&]() {
+    std::size_t i = pos(gen);
+    while (image.cells_[i] != ImageMatrix::FREE)
+      i = pos(gen);
+    return size_t2(i % image.width_, i / image.width_);
+  };
+
+  std::vector<std::pair<size_t2, size_t2> > queries;
+  std::uniform_int_distribution<int> offset(-int(max_distance), int(max_distance));
+  while (queries.size() < n) {
+    const size_t2 start = freeCell();
+    if (max_distance == 0) {
+      queries.push_back(std::make_pair(start, freeCell()));
+      continue;
+    }
+    // wraps around below 0, fails the bounds test
+    const size_t2 goal(int(start.x) + offset(gen), int(start.y) + offset(gen));
+    if (goal.x < image.width_ && goal.y < image.height_ && image.cells_[goal.y * image.width_ + goal.x] == ImageMatrix::FREE)
+      queries.push_back(std::make_pair(start, goal));
+  }
+  return queries;
+}
+
+} // anonym namespace
+
+
+static void BM_HierarchicalPathfinder_build(benchmark::State& state)
+{
+  const ImageMatrix image = blockMap(state.range(0));
+  for (auto _ : state) {
+    HierarchicalPathfinder hpa(image);
+    benchmark::DoNotOptimize(hpa.abstractGraph().empty());
+  }
+}
+BENCHMARK(BM_HierarchicalPathfinder_build)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+static void BM_HierarchicalPathfinder_query(benchmark::State& state)
+{
+  const ImageMatrix image = blockMap(state.range(0));
+  HierarchicalPathfinder hpa(image);
+  const std::vector<std::pair<size_t2, size_t2> > queries = randomQueries(image, 64);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const std::pair<size_t2, size_t2>& q = queries[i++ % queries.size()];
+    benchmark::DoNotOptimize(hpa.findPath(q.first, q.second));
+  }
+}
+BENCHMARK(BM_HierarchicalPathfinder_query)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+/// goals a few clusters away, the cost shall not grow with the map
+static void BM_HierarchicalPathfinder_query_near(benchmark::State& state)
+{
+  const ImageMatrix image = blockMap(state.range(0));
+  HierarchicalPathfinder hpa(image);
+  const std::vector<std::pair<size_t2, size_t2> > queries = randomQueries(image, 64, 40);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const std::pair<size_t2, size_t2>& q = queries[i++ % queries.size()];
+    benchmark::DoNotOptimize(hpa.findPath(q.first, q.second));
+  }
+}
+BENCHMARK(BM_HierarchicalPathfinder_query_near)->Arg(256)->Arg(1024)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+static void BM_JumpPointSearch_query(benchmark::State& state)
+{
+  const ImageMatrix image = blockMap(state.range(0));
+  const JumpPointSearch jps(image);
+  const std::vector<std::pair<size_t2, size_t2> > queries = randomQueries(image, 64);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const std::pair<size_t2, size_t2>& q = queries[i++ % queries.size()];
+    benchmark::DoNotOptimize(jps.findPath(q.first, q.second));
+  }
+}
+BENCHMARK(BM_JumpPointSearch_query)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+static void BM_JumpPointSearchPlus_build(benchmark::State& state)
+{
+  const ImageMatrix image = blockMap(state.range(0));
+  for (auto _ : state) {
+    JumpPointSearchPlus jps_plus(image);
+    benchmark::DoNotOptimize(jps_plus.jumpDistance(0, 0, 0));
+  }
+}
+BENCHMARK(BM_JumpPointSearchPlus_build)->Arg(256)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+static void BM_JumpPointSearchPlus_query(benchmark::State& state)
+{
+  const ImageMatrix image = blockMap(state.range(0));
+  const JumpPointSearchPlus jps_plus(image);
+  const std::vector<std::pair<size_t2, size_t2> > queries = randomQueries(image, 64);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const std::pair<size_t2, size_t2>& q = queries[i++ % queries.size()];
+    benchmark::DoNotOptimize(jps_plus.findPath(q.first, q.second));
+  }
+}
+BENCHMARK(BM_JumpPointSearchPlus_query)->Arg(256)->Arg(1024)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,68 @@
+#include <graph/priority_queue.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.hpp"
+
+namespace {
+
+std::vector<float> randomKeys(std::size_t n)
+{
+  std::mt19937 gen(bench_seed);
+  std::uniform_real_distribution<float> key(0.0f, 1000.0f);
+  std::vector<float> retval(n);
+  for (auto& k : retval)
+    k = key(gen);
+
+  return retval;
+}
+
+} // anonym namespace
+
+
+static void BM_PriorityQueue_push(benchmark::State& state)
+{
+  const std::vector<float> keys = randomKeys(state.range(0));
+  for (auto _ : state) {
+    PriorityQueue<float, int> q;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+      q.push(keys[i], i);
+    benchmark::DoNotOptimize(q);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_PriorityQueue_push)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+
+static void BM_PriorityQueue_pushPop(benchmark::State& state)
+{
+  const std::vector<float> keys = randomKeys(state.range(0));
+  for (auto _ : state) {
+    PriorityQueue<float, int> q;
+    for (std::size_t i = 0; i < keys.size(); ++i)
+      q.push(keys[i], i);
+    while (!q.empty())
+      q.pop();
+    benchmark::DoNotOptimize(q);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_PriorityQueue_pushPop)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+
+static void BM_PriorityQueue_modifyKey(benchmark::State& state)
+{
+  const std::vector<float> keys = randomKeys(state.range(0));
+  PriorityQueue<float, int> q;
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    q.push(keys[i], i);
+
+  std::vector<float> current(keys);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const float new_key = current[i] * 0.5f;
+    q.modifyKey(current[i], i, new_key);
+    current[i] = new_key;
+    i = (i + 1) % keys.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PriorityQueue_modifyKey)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18);
@@ -0,0 +1,279 @@
+#include <graph/quad_tree.hpp>
+#include <graph/loose_quad_tree.hpp>
+#include <graph/spatial_graph.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.hpp"
+
+namespace {
+
+std::vector<float2> randomPoints(std::size_t n, float half_dimension)
+{
+  std::mt19937 gen(bench_seed);
+  std::uniform_real_distribution<float> coord(-half_dimension, half_dimension);
+  std::vector<float2> retval;
+  retval.reserve(n);
+  for (std::size_t i = 0; i < n; ++i)
+    retval.push_back(float2(coord(gen), coord(gen)));
+
+  return retval;
+}
+
+constexpr float half_dimension = 1000.0f;
+
+} // anonym namespace
+
+
+static void BM_QuadTree_insert(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  const AABB<float2> boundary(float2(0, 0), half_dimension);
+  for (auto _ : state) {
+    QuadTree<float2> t(boundary);
+    for (const auto& p : points)
+      t.insert(p);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_QuadTree_insert)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+
+static void BM_QuadTree_bulkLoad(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  const AABB<float2> boundary(float2(0, 0), half_dimension);
+  for (auto _ : state) {
+    QuadTree<float2> t(boundary, points);
+    benchmark::DoNotOptimize(t.size());
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_QuadTree_bulkLoad)->Arg(1 << 10)->Arg(1 << 14)->Arg(1 << 18)->Arg(1 << 22)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+/// state.range(1) is the query box half dimension
+static void BM_QuadTree_queryRange(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  const std::vector<float2> centers = randomPoints(1024, half_dimension);
+  QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension));
+  for (const auto& p : points)
+    t.insert(p);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t.queryRange(AABB<float2>(centers[i], state.range(1))));
+    i = (i + 1) % centers.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QuadTree_queryRange)->Args({1 << 14, 10})->Args({1 << 14, 100})->Args({1 << 18, 10})->Args({1 << 18, 100});
+
+static void BM_QuadTree_queryRange_outputIterator(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  const std::vector<float2> centers = randomPoints(1024, half_dimension);
+  QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension));
+  for (const auto& p : points)
+    t.insert(p);
+
+  std::vector<float2> result;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    result.clear();
+    t.queryRange(AABB<float2>(centers[i], state.range(1)), std::back_inserter(result));
+    benchmark::DoNotOptimize(result.data());
+    i = (i + 1) % centers.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QuadTree_queryRange_outputIterator)->Args({1 << 14, 10})->Args({1 << 14, 100})->Args({1 << 18, 10})->Args({1 << 18, 100});
+
+static void BM_QuadTree_countRange(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  const std::vector<float2> centers = randomPoints(1024, half_dimension);
+  QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension));
+  for (const auto& p : points)
+    t.insert(p);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t.countRange(AABB<float2>(centers[i], state.range(1))));
+    i = (i + 1) % centers.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QuadTree_countRange)->Args({1 << 14, 10})->Args({1 << 14, 100})->Args({1 << 18, 10})->Args({1 << 18, 100});
+
+/// 1024 boxes of half dimension state.range(1), answered together, for the number of points of all of them
+static void BM_QuadTree_countRanges(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  std::vector<AABB<float2> > ranges;
+  for (const auto& c : randomPoints(1024, half_dimension))
+    ranges.push_back(AABB<float2>(c, state.range(1)));
+  const QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension), points);
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(t.countRanges(ranges));
+  state.SetItemsProcessed(state.iterations() * ranges.size());
+}
+BENCHMARK(BM_QuadTree_countRanges)->Args({1 << 14, 10})->Args({1 << 18, 10})->Args({1 << 18, 100})->Unit(benchmark::kMicrosecond);
+
+/// the same boxes, one query each
+static void BM_QuadTree_countRanges_oneByOne(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  std::vector<AABB<float2> > ranges;
+  for (const auto& c : randomPoints(1024, half_dimension))
+    ranges.push_back(AABB<float2>(c, state.range(1)));
+  const QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension), points);
+
+  std::vector<std::size_t> counts(ranges.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < ranges.size(); ++i)
+      counts[i] = t.countRange(ranges[i]);
+    benchmark::DoNotOptimize(counts.data());
+  }
+  state.SetItemsProcessed(state.iterations() * ranges.size());
+}
+BENCHMARK(BM_QuadTree_countRanges_oneByOne)->Args({1 << 14, 10})->Args({1 << 18, 10})->Args({1 << 18, 100})->Unit(benchmark::kMicrosecond);
+
+/// state.range(1) is k
+static void BM_QuadTree_nearestNeighbours(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  const std::vector<float2> centers = randomPoints(1024, half_dimension);
+  QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension));
+  for (const auto& p : points)
+    t.insert(p);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t.nearestNeighbours(centers[i], state.range(1)));
+    i = (i + 1) % centers.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QuadTree_nearestNeighbours)->Args({1 << 14, 1})->Args({1 << 18, 1})->Args({1 << 18, 16});
+
+/// every point takes a small random step, as objects dragged or driving around
+static void BM_QuadTree_move(benchmark::State& state)
+{
+  std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  QuadTree<float2> t(AABB<float2>(float2(0, 0), half_dimension), points);
+  std::mt19937 gen(bench_seed);
+  std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+  for (auto _ : state) {
+    for (auto& p : points) {
+      const float2 to(std::max(-half_dimension, std::min(half_dimension, p.x + step(gen))),
+                      std::max(-half_dimension, std::min(half_dimension, p.y + step(gen))));
+      t.move(p, to);
+      p = to;
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_QuadTree_move)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+
+/// streamed points from a small initial boundary, the root grows on the way
+static void BM_QuadTree_insert_growing(benchmark::State& state)
+{
+  const std::vector<float2> points = randomPoints(state.range(0), half_dimension);
+  for (auto _ : state) {
+    QuadTree<float2> t(AABB<float2>(float2(0, 0), 1), 8, QuadTree<float2>::GROWING_BOUNDS);
+    for (const auto& p : points)
+      t.insert(p);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_QuadTree_insert_growing)->Arg(1 << 14)->Arg(1 << 18)->Unit(benchmark::kMicrosecond);
+
+/// boxes of half dimension up to state.range(1), queried with boxes of 10
+static void BM_LooseQuadTree_queryRange(benchmark::State& state)
+{
+  const std::vector<float2> centers = randomPoints(state.range(0), half_dimension);
+  const std::vector<float2> queries = randomPoints(1024, half_dimension);
+  std::mt19937 gen(bench_seed);
+  std::uniform_real_distribution<float> size(0, state.range(1));
+  LooseQuadTree<float2, int> t(AABB<float2>(float2(0, 0), half_dimension));
+  for (std::size_t i = 0; i < centers.size(); ++i)
+    t.insert(AABB<float2>(centers[i], size(gen)), int(i));
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t.queryRange(AABB<float2>(queries[i], 10)));
+    i = (i + 1) % queries.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LooseQuadTree_queryRange)->Args({1 << 14, 1})->Args({1 << 14, 20})->Args({1 << 18, 1})->Args({1 << 18, 20});
+
+/// a 2000 x 100 map, in a square tree when state.range(0) is 0, in a rectangular one otherwise,
+/// queried with 100 x 10 viewports
+static void BM_QuadTree_countRange_wide(benchmark::State& state)
+{
+  std::mt19937 gen(bench_seed);
+  std::uniform_real_distribution<float> x(-1000, 1000), y(-50, 50);
+  std::vector<float2> points, centers;
+  for (int i = 0; i < (1 << 18); ++i)
+    points.push_back(float2(x(gen), y(gen)));
+  for (int i = 0; i < 1024; ++i)
+    centers.push_back(float2(x(gen), y(gen)));
+
+  const AABB<float2> boundary = state.range(0) ? AABB<float2>(float2(0, 0), 1000, 50) : AABB<float2>(float2(0, 0), 1000);
+  const QuadTree<float2> t(boundary, points);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(t.countRange(AABB<float2>(centers[i], 50, 5)));
+    i = (i + 1) % centers.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_QuadTree_countRange_wide)->Arg(0)->Arg(1);
+
+/// the vertex closest to a random position, as for a mouse click, in a geometric graph of state.range(0) vertices
+static void BM_SpatialGraph_nearestVertex(benchmark::State& state)
+{
+  const Graph<float2> g(benchGeometric(state.range(0)));
+  const float extent = std::sqrt(float(state.range(0)));
+  const SpatialGraph<float2> s(g, AABB<float2>(float2(extent / 2, extent / 2), extent / 2));
+  const std::vector<float2> clicks = randomPoints(1024, extent / 2);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(s.nearestVertices(float2(clicks[i].x + extent / 2, clicks[i].y + extent / 2)));
+    i = (i + 1) % clicks.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpatialGraph_nearestVertex)->Arg(1 << 10)->Arg(1 << 14);
+
+/// the same lookup as a scan over all vertices, for comparison
+static void BM_SpatialGraph_nearestVertex_scan(benchmark::State& state)
+{
+  const Graph<float2> g(benchGeometric(state.range(0)));
+  const float extent = std::sqrt(float(state.range(0)));
+  const std::vector<float2> clicks = randomPoints(1024, extent / 2);
+
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const float2 p(clicks[i].x + extent / 2, clicks[i].y + extent / 2);
+    float best = std::numeric_limits<float>::max();
+    float2 nearest;
+    for (const float2& v : g) {
+      const float d = (v.x - p.x) * (v.x - p.x) + (v.y - p.y) * (v.y - p.y);
+      if (d < best) {
+        best = d;
+        nearest = v;
+      }
+    }
+    benchmark::DoNotOptimize(nearest);
+    i = (i + 1) % clicks.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpatialGraph_nearestVertex_scan)->Arg(1 << 10)->Arg(1 << 14);
@@ -0,0 +1,350 @@
+#ifndef COMPRESSED_GRAPH_HPP
+#define COMPRESSED_GRAPH_HPP
+
+#include "graph.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+/**
+  Read-only, compressed snapshot of a graph for large static inputs.
+
+  - Vertices get dense ids [0, numberOfVertices()) in the order given at construction.
+  - Each adjacency list is sorted and delta encoded: the first neighbour is stored
+    as the zigzag encoded difference to the source id, the rest as the gap to the
+    previous neighbour. Every value is a LEB128 style varint (7 bits per byte,
+    high bit set on all but the last byte) in one contiguous byte array.
+  - \ref neighbour_iterator decodes on the fly, so traversals walk the compressed
+    bytes directly and never inflate an adjacency list.
+
+  Small gaps, which are the norm after a locality improving reordering, take a
+  single byte instead of sizeof(V).
+
+  - V expected to be cheap to copy and hashable, as for \ref Graph
+*/
+template <typename V>
+class CompressedGraph {
+
+public:
+
+  typedef size_t size_type;
+  typedef V value_type;
+  typedef const V& const_reference;
+  typedef std::ptrdiff_t difference_type;
+
+  typedef std::pair<size_type, size_type> id_edge;
+
+  static const size_type npos = size_type(-1);
+
+  class neighbour_iterator : public std::iterator<std::forward_iterator_tag,
+                                                  size_type,
+                                                  difference_type,
+                                                  const size_type*,
+                                                  const size_type&>
+  {
+  friend class CompressedGraph;
+
+  public:
+    typedef neighbour_iterator self_type;
+    typedef const neighbour_iterator& const_reference_self_type;
+
+    neighbour_iterator() : m_pos(0), m_next(0), m_end(0), m_value(0) {}
+
+    const size_type& operator*() const { return m_value; }
+    const size_type* operator->() const { return &m_value; }
+    self_type &operator++() { m_pos = m_next; decode(m_value); return *this; }
+    self_type operator++(int) { self_type tmp(*this); ++(*this); return tmp; }
+    bool operator==(const_reference_self_type o) const { return m_pos == o.m_pos; }
+    bool operator!=(const_reference_self_type o) const { return !(*this == o); }
+
+  private:
+    neighbour_iterator(const std::uint8_t* pos, const std::uint8_t* end, size_type source);
+    void decode(size_type previous);
+
+    const std::uint8_t* m_pos;
+    const std::uint8_t* m_next;
+    const std::uint8_t* m_end;
+    size_type m_value;
+  };
+
+  struct neighbour_range {
+    neighbour_iterator b, e;
+    neighbour_iterator begin() const { return b; }
+    neighbour_iterator end() const { return e; }
+  };
+
+  CompressedGraph() : m_vertices(), m_ids(), m_offsets(1, 0), m_bytes(), m_number_of_edges(0) {}
+  CompressedGraph(const Graph<V>& graph);
+  /// Encodes the already built graph one adjacency list at a time, in the given vertex order.
+  CompressedGraph(const Graph<V>& graph, const std::vector<V>& order);
+  /// Duplicate edges are dropped, an id out of [0, vertices.size()) throws std::out_of_range.
+  CompressedGraph(const std::vector<V>& vertices, std::vector<id_edge> edges);
+  /**
+    Streaming build: reads each id_edge of [first, last) once and encodes a list as soon as
+    the next source starts, so the uncompressed graph is never held in memory.
+
+    - Edges must come sorted by source, std::invalid_argument otherwise
+    - Destinations of a source may come in any order, duplicates are dropped
+    - An id out of [0, vertices.size()) throws std::out_of_range
+  */
+  template <typename InputIt>
+  CompressedGraph(const std::vector<V>& vertices, InputIt first, InputIt last);
+
+  // Capacity
+  bool empty() const noexcept { return m_vertices.empty(); }
+  size_type numberOfVertices() const noexcept { return m_vertices.size(); }
+  size_type numberOfEdges() const noexcept { return m_number_of_edges; }
+  size_type compressedSize() const noexcept { return m_bytes.size(); }
+
+  // Lookup
+  bool contains(const_reference data) const { return m_ids.find(data) != m_ids.end(); }
+  const_reference vertex(size_type id) const { return m_vertices[id]; }
+  size_type id(const_reference data) const { return m_ids.at(data); } // throws std::out_of_range
+  /// The id of data, npos if it is not a vertex: one lookup instead of contains and id.
+  size_type find(const_reference data) const;
+  const std::vector<value_type>& vertices() const noexcept { return m_vertices; }
+
+  size_type degree(size_type id) const;
+  neighbour_range neighbourIds(size_type id) const;
+  std::vector<value_type> neighboursOf(const_reference data) const;
+
+  Graph<V> decompress() const;
+
+private:
+
+  void indexVertices();
+  template <typename InputIt>
+  void appendEdges(InputIt first, InputIt last);
+  /// Encodes ids as the neighbours of the next source id, sorted and deduplicated in place.
+  void appendList(std::vector<size_type>& ids);
+  static void appendVarint(std::vector<std::uint8_t>& bytes, size_type value);
+  static size_type zigzag(size_type value, size_type base);
+  static size_type unzigzag(size_type value, size_type base);
+
+  std::vector<value_type> m_vertices;
+  std::unordered_map<V, size_type> m_ids;
+  std::vector<size_type> m_offsets; // numberOfVertices() + 1 entries into m_bytes
+  std::vector<std::uint8_t> m_bytes;
+  size_type m_number_of_edges;
+};
+
+
+// neighbour_iterator implementation
+
+template <typename V>
+inline CompressedGraph<V>::neighbour_iterator::neighbour_iterator(const std::uint8_t* pos,
+                                                                  const std::uint8_t* end,
+                                                                  size_type source)
+  : m_pos(pos)
+  , m_next(pos)
+  , m_end(end)
+  , m_value(0)
+{
+  if (m_pos == m_end)
+    return;
+
+  size_type raw = 0;
+  int shift = 0;
+  do {
+    raw |= size_type(*m_next & 0x7f) << shift;
+    shift += 7;
+  } while (*m_next++ & 0x80);
+  m_value = CompressedGraph<V>::unzigzag(raw, source);
+}
+
+template <typename V>
+inline void CompressedGraph<V>::neighbour_iterator::decode(size_type previous)
+{
+  if (m_pos == m_end)
+    return;
+
+  size_type gap = 0;
+  int shift = 0;
+  do {
+    gap |= size_type(*m_next & 0x7f) << shift;
+    shift += 7;
+  } while (*m_next++ & 0x80);
+  m_value = previous + gap;
+}
+
+
+// CompressedGraph implementation
+
+template <typename V>
+const typename CompressedGraph<V>::size_type CompressedGraph<V>::npos;
+
+template <typename V>
+inline CompressedGraph<V>::CompressedGraph(const Graph<V>& graph)
+  : CompressedGraph<V>(graph, graph.vertices())
+{}
+
+template <typename V>
+inline CompressedGraph<V>::CompressedGraph(const Graph<V>& graph, const std::vector<V>& order)
+  : m_vertices(order)
+  , m_ids()
+  , m_offsets()
+  , m_bytes()
+  , m_number_of_edges(0)
+{
+  indexVertices();
+
+  std::vector<size_type> ids;
+  for (size_type i = 0; i < m_vertices.size(); ++i) {
+    ids.clear();
+    for (const auto& n : graph.neighboursOf(m_vertices[i]))
+      ids.push_back(m_ids.at(n));
+    appendList(ids);
+  }
+  m_bytes.shrink_to_fit();
+}
+
+template <typename V>
+inline CompressedGraph<V>::CompressedGraph(const std::vector<V>& vertices, std::vector<id_edge> edges)
+  : m_vertices(vertices)
+  , m_ids()
+  , m_offsets()
+  , m_bytes()
+  , m_number_of_edges(0)
+{
+  indexVertices();
+  std::sort(edges.begin(), edges.end());
+  m_bytes.reserve(edges.size()); // at least one byte per edge
+  appendEdges(edges.begin(), edges.end());
+}
+
+template <typename V>
+template <typename InputIt>
+inline CompressedGraph<V>::CompressedGraph(const std::vector<V>& vertices, InputIt first, InputIt last)
+  : m_vertices(vertices)
+  , m_ids()
+  , m_offsets()
+  , m_bytes()
+  , m_number_of_edges(0)
+{
+  indexVertices();
+  appendEdges(first, last);
+}
+
+template <typename V>
+inline typename CompressedGraph<V>::size_type CompressedGraph<V>::degree(size_type id) const
+{
+  // every varint ends in exactly one byte with a clear high bit
+  return std::count_if(m_bytes.begin() + m_offsets[id], m_bytes.begin() + m_offsets[id + 1],
+                       [](std::uint8_t b) { return (b & 0x80) == 0; });
+}
+
+template <typename V>
+inline typename CompressedGraph<V>::neighbour_range CompressedGraph<V>::neighbourIds(size_type id) const
+{
+  const std::uint8_t* first = m_bytes.data() + m_offsets[id];
+  const std::uint8_t* last = m_bytes.data() + m_offsets[id + 1];
+  neighbour_range r = { neighbour_iterator(first, last, id), neighbour_iterator(last, last, id) };
+  return r;
+}
+
+template <typename V>
+inline typename CompressedGraph<V>::size_type CompressedGraph<V>::find(const_reference data) const
+{
+  const auto it = m_ids.find(data);
+  return it == m_ids.end() ? npos : it->second;
+}
+
+template <typename V>
+inline std::vector<V> CompressedGraph<V>::neighboursOf(const_reference data) const
+{
+  std::vector<V> retval;
+  const auto it = m_ids.find(data);
+  if (it == m_ids.end())
+    return retval;
+
+  for (const size_type n : neighbourIds(it->second))
+    retval.push_back(m_vertices[n]);
+
+  return retval;
+}
+
+template <typename V>
+inline Graph<V> CompressedGraph<V>::decompress() const
+{
+  Graph<V> g(m_vertices);
+  for (size_type i = 0; i < m_vertices.size(); ++i)
+    g.setEdges(m_vertices[i], neighboursOf(m_vertices[i]));
+
+  return g;
+}
+
+template <typename V>
+inline void CompressedGraph<V>::indexVertices()
+{
+  m_ids.reserve(m_vertices.size());
+  for (size_type i = 0; i < m_vertices.size(); ++i)
+    m_ids.emplace(m_vertices[i], i);
+
+  m_offsets.reserve(m_vertices.size() + 1);
+  m_offsets.push_back(0);
+}
+
+template <typename V>
+template <typename InputIt>
+inline void CompressedGraph<V>::appendEdges(InputIt first, InputIt last)
+{
+  std::vector<size_type> ids; // destinations of the source being read, m_offsets.size() - 1
+  for (; first != last; ++first) {
+    const id_edge e = *first;
+    if (e.first >= m_vertices.size() || e.second >= m_vertices.size())
+      throw std::out_of_range("CompressedGraph: edge id out of range");
+    if (e.first < m_offsets.size() - 1)
+      throw std::invalid_argument("CompressedGraph: edges not sorted by source");
+
+    for (; m_offsets.size() - 1 < e.first; ids.clear())
+      appendList(ids);
+    ids.push_back(e.second);
+  }
+  for (; m_offsets.size() - 1 < m_vertices.size(); ids.clear())
+    appendList(ids);
+
+  m_bytes.shrink_to_fit();
+}
+
+template <typename V>
+inline void CompressedGraph<V>::appendList(std::vector<size_type>& ids)
+{
+  const size_type source = m_offsets.size() - 1;
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  for (size_type i = 0; i < ids.size(); ++i)
+    appendVarint(m_bytes, i == 0 ? zigzag(ids[i], source) : ids[i] - ids[i - 1]);
+  m_offsets.push_back(m_bytes.size());
+  m_number_of_edges += ids.size();
+}
+
+template <typename V>
+inline void CompressedGraph<V>::appendVarint(std::vector<std::uint8_t>& bytes, size_type value)
+{
+  while (value >= 0x80) {
+    bytes.push_back(std::uint8_t(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(std::uint8_t(value));
+}
+
+template <typename V>
+inline typename CompressedGraph<V>::size_type CompressedGraph<V>::zigzag(size_type value, size_type base)
+{
+  return value >= base ? (value - base) << 1 : ((base - value) << 1) - 1;
+}
+
+template <typename V>
+inline typename CompressedGraph<V>::size_type CompressedGraph<V>::unzigzag(size_type value, size_type base)
+{
+  return (value & 1) ? base - ((value + 1) >> 1) : base + (value >> 1);
+}
+
+#endif // COMPRESSED_GRAPH_HPP
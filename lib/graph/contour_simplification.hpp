@@ -0,0 +1,234 @@
+#ifndef CONTOUR_SIMPLIFICATION_HPP
+#define CONTOUR_SIMPLIFICATION_HPP
+
+#include "graph.hpp"
+#include "marching_squares.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+/**
+  Post-processing of the \ref marchingSquares output.
+
+  - chainSegments joins the segments at their shared ends into polylines: closed
+    ones around obstacles, open ones where a contour runs into the image border.
+  - simplifyContour drops vertices with Ramer-Douglas-Peucker: a vertex stays
+    only if it is farther than tolerance (in cells) from the simplified line.
+    Tolerance 0 removes just the collinear ones.
+  - contourGraph gives the routing / rendering graph of the polylines.
+
+  A staircase of n pixel steps is 2n segments, 2n+1 vertices, and after
+  simplification with tolerance 1 just its two ends.
+*/
+
+struct Contour {
+  std::vector<size_t2> points; // a closed one does not repeat its first point
+  bool closed;
+};
+
+
+namespace detail {
+
+inline std::uint64_t pointKey(const size_t2& p)
+{
+  return (std::uint64_t(p.x) << 32) | std::uint64_t(p.y);
+}
+
+inline double distanceToSegment(const size_t2& p, const size_t2& a, const size_t2& b)
+{
+  const double px = double(p.x) - double(a.x), py = double(p.y) - double(a.y);
+  const double dx = double(b.x) - double(a.x), dy = double(b.y) - double(a.y);
+  const double length2 = dx * dx + dy * dy;
+  if (length2 == 0.0)
+    return std::sqrt(px * px + py * py);
+
+  double t = (px * dx + py * dy) / length2;
+  t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+  const double ex = px - t * dx, ey = py - t * dy;
+  return std::sqrt(ex * ex + ey * ey);
+}
+
+/// Marks in keep the vertices of points[first, last] surviving Ramer-Douglas-Peucker, ends excluded.
+inline void ramerDouglasPeucker(const std::vector<size_t2>& points, std::size_t first, std::size_t last,
+                                double tolerance, std::vector<bool>& keep)
+{
+  // explicit stack, contours of large maps are long
+  std::vector<std::pair<std::size_t, std::size_t> > ranges(1, std::make_pair(first, last));
+  while (!ranges.empty()) {
+    const std::size_t a = ranges.back().first;
+    const std::size_t b = ranges.back().second;
+    ranges.pop_back();
+    if (b <= a + 1)
+      continue;
+
+    double max_distance = -1.0;
+    std::size_t farthest = a;
+    for (std::size_t i = a + 1; i < b; ++i) {
+      const double d = distanceToSegment(points[i], points[a], points[b]);
+      if (d > max_distance) {
+        max_distance = d;
+        farthest = i;
+      }
+    }
+
+    if (max_distance > tolerance) {
+      keep[farthest] = true;
+      ranges.push_back(std::make_pair(a, farthest));
+      ranges.push_back(std::make_pair(farthest, b));
+    }
+  }
+}
+
+} // detail namespace
+
+
+inline std::vector<Contour> chainSegments(const std::vector< std::pair<size_t2, size_t2> >& segments)
+{
+  // segment indices per end point, 2 at a corner, 4 where two contours touch diagonally
+  std::unordered_map<std::uint64_t, std::vector<std::size_t> > incident;
+  incident.reserve(segments.size() * 2);
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    incident[detail::pointKey(segments[i].first)].push_back(i);
+    incident[detail::pointKey(segments[i].second)].push_back(i);
+  }
+
+  std::vector<bool> used(segments.size(), false);
+  std::vector<Contour> contours;
+
+  // p points into segments: size_t2 has a copy constructor but no assignment
+  auto walk = [&](const size_t2* p, std::size_t segment) {
+    Contour c;
+    c.points.push_back(*p);
+    const std::uint64_t start = detail::pointKey(*p);
+    while (true) {
+      used[segment] = true;
+      p = segments[segment].first == *p ? &segments[segment].second : &segments[segment].first;
+
+      const std::vector<std::size_t>& next = incident[detail::pointKey(*p)];
+      segment = segments.size();
+      for (const std::size_t s : next)
+        if (!used[s]) {
+          segment = s;
+          break;
+        }
+
+      if (detail::pointKey(*p) == start && segment == segments.size()) {
+        c.closed = true;
+        break;
+      }
+      c.points.push_back(*p);
+      if (segment == segments.size()) {
+        c.closed = false;
+        break;
+      }
+    }
+    contours.push_back(c);
+  };
+
+  // open contours first, they have to start at one of their ends: a point of odd degree
+  for (std::size_t i = 0; i < segments.size(); ++i)
+    for (int end = 0; end < 2; ++end) {
+      const size_t2* p = end == 0 ? &segments[i].first : &segments[i].second;
+      if (!used[i] && incident[detail::pointKey(*p)].size() % 2 == 1)
+        walk(p, i);
+    }
+
+  for (std::size_t i = 0; i < segments.size(); ++i)
+    if (!used[i])
+      walk(&segments[i].first, i);
+
+  return contours;
+}
+
+inline Contour simplifyContour(const Contour& contour, double tolerance = 0.0)
+{
+  const std::vector<size_t2>& points = contour.points;
+  if (points.size() < 3)
+    return contour;
+
+  std::vector<bool> keep(points.size() + 1, false);
+  Contour retval;
+  retval.closed = contour.closed;
+
+  if (!contour.closed) {
+    keep.front() = true;
+    keep[points.size() - 1] = true;
+    detail::ramerDouglasPeucker(points, 0, points.size() - 1, tolerance, keep);
+  } else {
+    // split the ring at the vertex farthest from the first one, then both halves are open
+    std::vector<size_t2> ring(points);
+    ring.push_back(points.front());
+    std::size_t farthest = 1;
+    for (std::size_t i = 2; i < points.size(); ++i)
+      if (detail::distanceToSegment(points[i], points[0], points[0]) >
+          detail::distanceToSegment(points[farthest], points[0], points[0]))
+        farthest = i;
+
+    keep[0] = true;
+    keep[farthest] = true;
+    detail::ramerDouglasPeucker(ring, 0, farthest, tolerance, keep);
+    detail::ramerDouglasPeucker(ring, farthest, points.size(), tolerance, keep);
+
+    // a polygon needs a third vertex
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < points.size(); ++i)
+      kept += keep[i] ? 1 : 0;
+    if (kept < 3) {
+      std::size_t third = 1;
+      double max_distance = -1.0;
+      for (std::size_t i = 1; i < points.size(); ++i) {
+        const double d = detail::distanceToSegment(points[i], points[0], points[farthest]);
+        if (i != farthest && d > max_distance) {
+          max_distance = d;
+          third = i;
+        }
+      }
+      keep[third] = true;
+    }
+  }
+
+  for (std::size_t i = 0; i < points.size(); ++i)
+    if (keep[i])
+      retval.points.push_back(points[i]);
+
+  // the split vertex of a ring is only kept if it is a corner itself
+  const std::vector<size_t2>& r = retval.points;
+  if (retval.closed && r.size() > 3 && detail::distanceToSegment(r.front(), r.back(), r[1]) <= tolerance)
+    retval.points.erase(retval.points.begin());
+
+  return retval;
+}
+
+inline std::vector<Contour> simplifyContours(const std::vector<Contour>& contours, double tolerance = 0.0)
+{
+  std::vector<Contour> retval;
+  retval.reserve(contours.size());
+  for (const auto& c : contours)
+    retval.push_back(simplifyContour(c, tolerance));
+
+  return retval;
+}
+
+/// Vertices are the contour points, V constructible from the two coordinates.
+template <typename V>
+Graph<V> contourGraph(const std::vector<Contour>& contours)
+{
+  std::vector<typename Graph<V>::Edge> edges;
+  for (const auto& c : contours) {
+    const std::vector<size_t2>& p = c.points;
+    for (std::size_t i = 0; i + 1 < p.size(); ++i)
+      edges.push_back(typename Graph<V>::Edge(V(p[i].x, p[i].y), V(p[i + 1].x, p[i + 1].y)));
+    if (c.closed && p.size() > 2)
+      edges.push_back(typename Graph<V>::Edge(V(p.back().x, p.back().y), V(p.front().x, p.front().y)));
+  }
+
+  Graph<V> g;
+  g.addEdges(edges);
+  return g;
+}
+
+#endif // CONTOUR_SIMPLIFICATION_HPP
@@ -2,6 +2,7 @@
 #define GRAPH_HPP
 
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <algorithm>
@@ -28,6 +29,8 @@
     }
   ~~~
 */
+struct ContourDiff;
+
 template <typename V>
 class Graph {
 
@@ -71,6 +74,7 @@ public:
   void modifyVertex(const_reference old_data, const_reference new_data);
 
   void addEdge(const_reference source, const_reference destination);
+  void addEdges(const std::vector<Edge>& edge_list);
   void setEdges(const_reference source, const std::vector<value_type>& destinations);
   void removeEdge(const_reference source, const_reference destination);
 
@@ -123,9 +127,13 @@ private:
 
   std::vector<value_type>& nonConstNeighboursOf(const_reference data);
   static void eraseEdge(edge_container& v, const_reference data);
+  static void eraseMultiEdges(edge_container& v);
   v_iterator addVertexAndReturnIterator(const_reference data);
 
   v_container m_vertices;
+
+  template <typename T>
+  friend void applyContourDiff(Graph<T>& graph, const ContourDiff& diff);
 };
 
 // Free functions
@@ -202,8 +210,7 @@ template <typename V>
 inline Graph<V>::Graph(const std::vector<Edge>& edge_list)
   : Graph<V>()
 {
-  for (const auto& e : edge_list )
-    addEdge(e.source, e.destination);
+  addEdges(edge_list);
 }
 
 template <typename V>
@@ -269,7 +276,7 @@ inline void Graph<V>::addEdge(const_reference source, const_reference destinatio
   if (source == destination) // no self-edges
     return;
 
-  auto n = neighboursOf(source); // no multiedges
+  const auto& n = neighboursOf(source); // no multiedges
   if (std::find(n.begin(), n.end(), destination) != n.end())
     return;
 
@@ -279,6 +286,36 @@ inline void Graph<V>::addEdge(const_reference source, const_reference destinatio
   destination_it->second.push_back(source);
 }
 
+/// Bulk loading: appends every edge first and removes the multiedges of each
+/// list it appended to once at the end, instead of a duplicate scan per edge.
+template <typename V>
+inline void Graph<V>::addEdges(const std::vector<Edge>& edge_list)
+{
+  const bool was_empty = m_vertices.empty();
+  m_vertices.reserve(m_vertices.size() + edge_list.size());
+
+  // pointers stay valid on rehash, iterators do not; into an empty graph a list is
+  // new to this call exactly when it is still empty, otherwise the set tells
+  std::vector<edge_container*> touched;
+  std::unordered_set<edge_container*> recorded;
+  const auto append = [&](edge_container& list, const_reference data) {
+    if (was_empty ? list.empty() : recorded.insert(&list).second)
+      touched.push_back(&list);
+    list.push_back(data);
+  };
+
+  for (const auto& e : edge_list) {
+    if (e.source == e.destination) // no self-edges
+      continue;
+
+    append(addVertexAndReturnIterator(e.source)->second, e.destination);
+    append(addVertexAndReturnIterator(e.destination)->second, e.source);
+  }
+
+  for (auto& n : touched)
+    eraseMultiEdges(*n);
+}
+
 template <typename V>
 inline void Graph<V>::setEdges(const_reference source, const std::vector<value_type>& destinations)
 {
@@ -337,6 +374,24 @@ inline void Graph<V>::eraseEdge(edge_container& v, const_reference data) {
           v.end());
 }
 
+template <typename V>
+inline void Graph<V>::eraseMultiEdges(edge_container& v) {
+  // keeps the first occurence, V has no ordering, only operator== and hash
+  if (v.size() <= 32) {
+    auto last = v.begin();
+    for (auto it = v.begin(); it != v.end(); ++it)
+      if (std::find(v.begin(), last, *it) == last)
+        *last++ = *it;
+    v.erase(last, v.end());
+  } else {
+    std::unordered_set<V> seen;
+    seen.reserve(v.size());
+    v.erase(std::remove_if(v.begin(), v.end(),
+                           [&seen](const_reference d) { return !seen.insert(d).second; }),
+            v.end());
+  }
+}
+
 template <typename V>
 inline typename Graph<V>::v_iterator Graph<V>::addVertexAndReturnIterator(const_reference data)
 {
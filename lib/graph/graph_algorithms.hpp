@@ -2,7 +2,7 @@
 #define GRAPH_ALGORITHMS_HPP
 
 #include "graph.hpp"
-#include "priority_queue.hpp"
+#include "graph_traits.hpp"
 
 #include <vector>
 #include <unordered_map>
@@ -16,28 +16,324 @@
 #include <type_traits>
 
 
-namespace {
+/**
+  Weight accessors of the shortest path searches: weight(u, v, stored) is the
+  cost of the edge u -> v, stored is the weight kept with the edge, 1 for the
+  edges of an unweighted \ref Graph or \ref CompressedGraph. They are template
+  arguments instead of a std::function, so that the call per relaxed edge is inlined.
+*/
 
-template <typename V, typename W>
-std::vector<V> pathFromPrevList(const V& dest, const std::unordered_map<V, std::pair<W, V> >& dist_prev)
+/// The weight kept with the edge, as in \ref GraphWD.
+struct StoredWeight {
+  template <typename V, typename E>
+  const E& operator()(const V&, const V&, const E& stored) const { return stored; }
+};
+
+/// f(u, v), as the distance of the end points, the stored weight is not used.
+template <typename F>
+struct ComputedWeight {
+  F f;
+
+  template <typename V, typename E>
+  auto operator()(const V& u, const V& v, const E&) -> decltype(std::declval<F&>()(u, v)) { return f(u, v); }
+};
+
+template <typename F>
+ComputedWeight<F> computedWeight(F f)
+{
+  const ComputedWeight<F> retval = { f };
+  return retval;
+}
+
+namespace detail {
+
+/// The type of the path lengths, what WeightF returns.
+template <typename G, typename WeightF>
+struct path_weight {
+  typedef typename graph_traits<G>::vertex_type V;
+  typedef typename std::decay<decltype(std::declval<WeightF&>()(std::declval<const V&>(), std::declval<const V&>(),
+                                       std::declval<const typename graph_traits<G>::weight_type&>()))>::type type;
+};
+
+/// Without a heuristic the best first search is Dijkstra's.
+struct ZeroHeuristic {
+  template <typename V>
+  int operator()(const V&) const { return 0; }
+};
+
+template <typename W, typename K>
+struct SearchEntry {
+  W estimate; // distance + heuristic
+  W distance;
+  K vertex;
+  bool operator>(const SearchEntry& o) const { return estimate > o.estimate; }
+};
+
+constexpr std::size_t search_npos = std::size_t(-1);
+
+/// The distance from the source and the key of the previous vertex on a shortest
+/// path. source is its own previous vertex.
+template <typename W, typename K>
+struct SearchLabel {
+  W distance;
+  K parent;
+};
+
+/**
+  The labels of a best first search, the queue entries and the previous vertices
+  refer to the vertices by a key:
+  - key(v): the key of v
+  - relax(k, distance, parent): sets the label of k if it is not reached yet or
+    distance is shorter, false if neither
+  - reached(k), label(k) and vertex(k) by key, label and vertex of reached ones only
+  - forEachReached(f): f(v, label) for every reached vertex
+
+  The vertices are the keys and the labels are kept in a hash map over them. For a
+  \ref CompressedGraph the ids of its graph_traits<G>::indexMap are the keys and
+  the labels are a vector over them.
+*/
+template <typename G, typename W, typename IndexMap = typename graph_traits<G>::index_map>
+class SearchLabels {
+public:
+
+  typedef typename graph_traits<G>::vertex_type V;
+  typedef V key_type;
+  typedef SearchLabel<W, V> label_type;
+
+  explicit SearchLabels(const G&) : m_labels() {}
+
+  const V& key(const V& v) const { return v; }
+  bool relax(const V& k, const W& distance, const V& parent);
+  bool reached(const V& k) const { return m_labels.find(k) != m_labels.end(); }
+  const label_type& label(const V& k) const { return m_labels.find(k)->second; }
+  const V& vertex(const V& k) const { return k; }
+  template <typename F>
+  void forEachReached(F f) const;
+
+private:
+
+  std::unordered_map<V, label_type> m_labels;
+};
+
+/// A source or dest that is not a vertex is numbered after the vertices.
+template <typename G, typename W, typename V>
+class SearchLabels<G, W, CompressedIndexMap<V> > {
+public:
+
+  typedef std::size_t key_type;
+  typedef SearchLabel<W, std::size_t> label_type;
+
+  explicit SearchLabels(const G& graph) : m_graph(&graph), m_labels(), m_others() {}
+
+  std::size_t key(const V& v);
+  bool relax(std::size_t k, const W& distance, std::size_t parent);
+  bool reached(std::size_t k) const { return k < m_labels.size() && m_labels[k].parent != search_npos; }
+  const label_type& label(std::size_t k) const { return m_labels[k]; }
+  const V& vertex(std::size_t k) const;
+  template <typename F>
+  void forEachReached(F f) const;
+
+private:
+
+  const G* m_graph;
+  std::vector<label_type> m_labels; // grown up to the highest id reached, parent search_npos if not reached
+  std::vector<V> m_others;
+};
+
+/// Best first search from source, until dest is taken from the queue, over all the vertices
+/// reachable from source if dest is null. The queue entries of improved vertices are not
+/// updated but skipped when they come up, an admissible heuristic reopens vertices if needed.
+template <typename G, typename WeightF, typename H>
+SearchLabels<G, typename path_weight<G, WeightF>::type>
+bestFirstSearch(const G& graph,
+                const typename graph_traits<G>::vertex_type& source,
+                const typename graph_traits<G>::vertex_type* dest,
+                WeightF weight, H heuristic)
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  typedef typename path_weight<G, WeightF>::type W;
+  typedef SearchLabels<G, W> labels_type;
+  typedef typename labels_type::key_type K;
+  typedef SearchEntry<W, K> entry;
+
+  labels_type labels(graph);
+  const K s = labels.key(source);
+  labels.relax(s, W(), s);
+  const K d = labels.key(dest != nullptr ? *dest : source);
+
+  std::priority_queue<entry, std::vector<entry>, std::greater<entry> > q;
+  const entry first = { W(heuristic(source)), W(), s };
+  q.push(first);
+
+  while (!q.empty()) {
+    const entry top = q.top();
+    q.pop();
+    if (labels.label(top.vertex).distance < top.distance) // stale
+      continue;
+    if (dest != nullptr && top.vertex == d)
+      break;
+
+    const V& u = labels.vertex(top.vertex);
+    graph_traits<G>::forEachOutEdge(graph, u, [&](const V& v, const typename graph_traits<G>::weight_type& stored) {
+      const W alt = top.distance + weight(u, v, stored);
+      const K k = labels.key(v);
+      if (!labels.relax(k, alt, top.vertex))
+        return;
+      const entry next = { alt + W(heuristic(v)), alt, k };
+      q.push(next);
+    });
+  }
+
+  return labels;
+}
+
+template <typename G, typename W>
+std::vector<typename graph_traits<G>::vertex_type> pathTo(const typename graph_traits<G>::vertex_type& dest,
+                                                          SearchLabels<G, W>& labels)
 {
-  std::vector<V> retval;
-  if (dist_prev.find(dest) == dist_prev.end())
+  std::vector<typename graph_traits<G>::vertex_type> retval;
+  typename SearchLabels<G, W>::key_type k = labels.key(dest);
+  if (!labels.reached(k))
     return retval;
 
-  V it = dest;
-  for (; it != V() ; it = dist_prev.at(it).second) {
-    retval.push_back(it);
+  retval.push_back(dest);
+  while (!(labels.label(k).parent == k)) {
+    k = labels.label(k).parent;
+    retval.push_back(labels.vertex(k));
   }
-  retval.push_back(it);
 
   std::reverse(retval.begin(), retval.end());
   return retval;
 }
 
-} // anonym namespace
+} // detail namespace
 
 
+
+// detail::SearchLabels implementation
+
+template <typename G, typename W, typename IndexMap>
+bool detail::SearchLabels<G, W, IndexMap>::relax(const V& k, const W& distance, const V& parent)
+{
+  // emplace would allocate a node for every edge, most lead to reached vertices
+  const auto it = m_labels.find(k);
+  const label_type l = { distance, parent };
+  if (it == m_labels.end())
+    m_labels.emplace(k, l);
+  else if (distance < it->second.distance)
+    it->second = l;
+  else
+    return false;
+
+  return true;
+}
+
+template <typename G, typename W, typename IndexMap>
+template <typename F>
+void detail::SearchLabels<G, W, IndexMap>::forEachReached(F f) const
+{
+  for (const auto& l : m_labels)
+    f(l.first, l.second);
+}
+
+template <typename G, typename W, typename V>
+std::size_t detail::SearchLabels<G, W, detail::CompressedIndexMap<V> >::key(const V& v)
+{
+  const std::size_t k = m_graph->find(v);
+  if (k != G::npos)
+    return k;
+
+  std::size_t other = 0;
+  while (other < m_others.size() && !(m_others[other] == v))
+    ++other;
+  if (other == m_others.size())
+    m_others.push_back(v);
+  return m_graph->numberOfVertices() + other;
+}
+
+template <typename G, typename W, typename V>
+bool detail::SearchLabels<G, W, detail::CompressedIndexMap<V> >::relax(std::size_t k, const W& distance, std::size_t parent)
+{
+  if (k >= m_labels.size()) {
+    const label_type unreached = { W(), search_npos };
+    m_labels.resize(k + 1, unreached);
+  }
+
+  label_type& l = m_labels[k];
+  if (l.parent != search_npos && !(distance < l.distance))
+    return false;
+
+  l.distance = distance;
+  l.parent = parent;
+  return true;
+}
+
+template <typename G, typename W, typename V>
+const V& detail::SearchLabels<G, W, detail::CompressedIndexMap<V> >::vertex(std::size_t k) const
+{
+  const std::size_t n = m_graph->numberOfVertices();
+  return k < n ? m_graph->vertex(k) : m_others[k - n];
+}
+
+template <typename G, typename W, typename V>
+template <typename F>
+void detail::SearchLabels<G, W, detail::CompressedIndexMap<V> >::forEachReached(F f) const
+{
+  for (std::size_t k = 0; k < m_labels.size(); ++k)
+    if (m_labels[k].parent != search_npos)
+      f(vertex(k), m_labels[k]);
+}
+
+
+
+/// Shortest path from source to dest, both included, empty if dest can not be reached.
+/// G is any graph with a \ref graph_traits, weight(u, v, stored) the cost of an edge, not negative.
+template <typename G, typename WeightF = StoredWeight>
+std::vector<typename graph_traits<G>::vertex_type>
+dijkstraShortestPath(const G& graph,
+                     const typename graph_traits<G>::vertex_type& source,
+                     const typename graph_traits<G>::vertex_type& dest,
+                     WeightF weight = WeightF())
+{
+  auto labels = detail::bestFirstSearch(graph, source, &dest, weight, detail::ZeroHeuristic());
+  return detail::pathTo(dest, labels);
+}
+
+/// The same with A*: heuristic(v) shall not overestimate the cost from v to dest, and the
+/// closer it gets the fewer vertices are visited.
+template <typename G, typename H, typename WeightF = StoredWeight>
+std::vector<typename graph_traits<G>::vertex_type>
+aStarShortestPath(const G& graph,
+                  const typename graph_traits<G>::vertex_type& source,
+                  const typename graph_traits<G>::vertex_type& dest,
+                  H heuristic,
+                  WeightF weight = WeightF())
+{
+  auto labels = detail::bestFirstSearch(graph, source, &dest, weight, heuristic);
+  return detail::pathTo(dest, labels);
+}
+
+/// Single source shortest paths: the distance from source, and the previous vertex on a
+/// shortest path, of every vertex reachable from source. source is its own previous vertex.
+template <typename G, typename WeightF = StoredWeight>
+std::unordered_map<typename graph_traits<G>::vertex_type,
+                   std::pair<typename detail::path_weight<G, WeightF>::type, typename graph_traits<G>::vertex_type> >
+shortestPathsFrom(const G& graph, const typename graph_traits<G>::vertex_type& source, WeightF weight = WeightF())
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  typedef typename detail::path_weight<G, WeightF>::type W;
+  const auto labels = detail::bestFirstSearch(graph, source, static_cast<const V*>(nullptr), weight, detail::ZeroHeuristic());
+
+  std::unordered_map<V, std::pair<W, V> > retval;
+  labels.forEachReached([&](const V& v, const typename detail::SearchLabels<G, W>::label_type& l) {
+    retval.emplace(v, std::make_pair(l.distance, labels.vertex(l.parent)));
+  });
+
+  return retval;
+}
+
+/// Unweighted graph, distanceCompute(u, v) is the cost of an edge.
+/// @note calls through std::function, \ref dijkstraShortestPath inlines the weight.
 template <typename V, typename W>
 std::vector<V>
 dijkstra_shortest_path_to(const Graph<V>& graph,
@@ -45,42 +341,7 @@ dijkstra_shortest_path_to(const Graph<V>& graph,
                           const V& dest,
                           std::function<W(V, V)> distanceCompute)
 {
-  std::unordered_map<V, std::pair<W, V> > dist_prev;
-
-  dist_prev.emplace(source, std::pair<W, V>(W(), V()));
-  PriorityQueue<W, V> q;
-  for (const auto& v : graph.neighboursOf(source)) {
-    const W d = distanceCompute(source, v);
-    q.push(d, v);
-    dist_prev.emplace(v, std::pair<W, V>(d, source));
-  }
-
-  while (!q.empty()) {
-    const V u = q.top().second;
-    q.pop();
-
-    if (u == dest)
-      break;
-
-    for (const auto& v : graph.neighboursOf(u)) {
-      const W d = distanceCompute(u, v);
-      const W alt = dist_prev.at(u).first + d;
-
-      auto& v_ref = dist_prev[v];
-      if (v_ref.first == W()) { // new node
-        v_ref = std::pair<W, V>(alt, u);
-        q.push(alt, v);
-      } else {
-        const W prev_d = v_ref.first;
-        if (alt < prev_d) { // better route
-          v_ref = std::pair<W, V>(alt, u);
-          q.modifyKey(prev_d, v, alt);
-        }
-      }
-    }
-  }
-
-  return pathFromPrevList(dest, dist_prev);
+  return dijkstraShortestPath(graph, source, dest, computedWeight(distanceCompute));
 }
 
 
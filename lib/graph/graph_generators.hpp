@@ -0,0 +1,290 @@
+#ifndef GRAPH_GENERATORS_HPP
+#define GRAPH_GENERATORS_HPP
+
+#include "graph.hpp"
+#include "graphwd.hpp"
+#include "parallel.hpp"
+
+#include <vector>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+
+/**
+  Synthetic graph generators for benchmarks and soak tests.
+
+  Every generator returns an undirected edge list (each connection once, no
+  self edges) to be loaded with \ref fillGraph, which goes through the bulk
+  \ref Graph::addEdges path.
+
+  - Seeded and reproducible: work is cut into fixed size chunks, each with its own
+    std::mt19937 seeded from (seed, chunk index), so the output does not depend
+    on the number of threads.
+  - Parallel where the model allows it, see \ref parallelFor. Barabasi-Albert is
+    inherently sequential.
+
+  Integer vertices (V constructible from std::size_t): erdosRenyiEdges,
+  barabasiAlbertEdges, rmatEdges.
+  Planar vertices (V with a V(x, y) ctor, as for \ref QuadTree): gridEdges,
+  randomGeometricEdges.
+*/
+
+namespace detail {
+
+constexpr std::size_t generator_chunk_size = 1 << 14;
+
+inline std::mt19937 chunkGenerator(unsigned seed, std::size_t chunk)
+{
+  std::seed_seq seq { seed, unsigned(chunk), unsigned(chunk >> 16 >> 16) };
+  return std::mt19937(seq);
+}
+
+/// Concatenates the per chunk results in chunk order.
+template <typename T>
+std::vector<T> concatenate(std::vector<std::vector<T> >& chunks)
+{
+  std::size_t size = 0;
+  for (const auto& c : chunks)
+    size += c.size();
+
+  std::vector<T> retval;
+  retval.reserve(size);
+  for (auto& c : chunks) {
+    retval.insert(retval.end(), c.begin(), c.end());
+    std::vector<T>().swap(c);
+  }
+  return retval;
+}
+
+} // detail namespace
+
+
+/// G(n, p): every pair connected with probability p, O(n + m) by geometric skipping.
+template <typename V>
+std::vector<typename Graph<V>::Edge> erdosRenyiEdges(std::size_t number_of_vertices, double p, unsigned seed)
+{
+  typedef typename Graph<V>::Edge Edge;
+  const std::size_t chunk_size = detail::generator_chunk_size / 16;
+  if (p <= 0.0)
+    return std::vector<Edge>();
+
+  std::vector<std::vector<Edge> > chunks((number_of_vertices + chunk_size - 1) / chunk_size);
+
+  const double log_q = std::log(1.0 - p);
+  parallelFor(number_of_vertices, chunk_size, [&](std::size_t begin, std::size_t end) {
+    std::mt19937 gen = detail::chunkGenerator(seed, begin / chunk_size);
+    std::uniform_real_distribution<double> r(0.0, 1.0);
+    std::vector<Edge>& edges = chunks[begin / chunk_size];
+
+    // pairs (v, w) with w < v, skipping over the unconnected ones
+    for (std::size_t v = begin; v < end; ++v) {
+      for (double w = -1.0; ; ) {
+        w += (p >= 1.0) ? 1.0 : 1.0 + std::floor(std::log(1.0 - r(gen)) / log_q);
+        if (w >= double(v))
+          break;
+        edges.push_back(Edge(V(v), V(std::size_t(w))));
+      }
+    }
+  });
+  return detail::concatenate(chunks);
+}
+
+/// Preferential attachment: starting from a clique of edges_per_vertex + 1 vertices, every
+/// new vertex connects to edges_per_vertex distinct vertices chosen proportionally to their degree.
+template <typename V>
+std::vector<typename Graph<V>::Edge> barabasiAlbertEdges(std::size_t number_of_vertices, std::size_t edges_per_vertex, unsigned seed)
+{
+  typedef typename Graph<V>::Edge Edge;
+  std::vector<Edge> retval;
+  const std::size_t m0 = std::min(number_of_vertices, edges_per_vertex + 1);
+  if (m0 == 0)
+    return retval;
+
+  retval.reserve(m0 * (m0 - 1) / 2 + (number_of_vertices - m0) * edges_per_vertex);
+  std::vector<std::size_t> endpoints; // every vertex listed once per incident edge
+  endpoints.reserve(2 * retval.capacity());
+
+  for (std::size_t v = 0; v < m0; ++v)
+    for (std::size_t w = 0; w < v; ++w) {
+      retval.push_back(Edge(V(v), V(w)));
+      endpoints.push_back(v);
+      endpoints.push_back(w);
+    }
+
+  std::mt19937 gen = detail::chunkGenerator(seed, 0);
+  std::vector<std::size_t> targets;
+  for (std::size_t v = m0; v < number_of_vertices; ++v) {
+    targets.clear();
+    std::uniform_int_distribution<std::size_t> pick(0, endpoints.size() - 1);
+    while (targets.size() < edges_per_vertex) {
+      const std::size_t w = endpoints[pick(gen)];
+      if (std::find(targets.begin(), targets.end(), w) == targets.end())
+        targets.push_back(w);
+    }
+    for (const std::size_t w : targets) {
+      retval.push_back(Edge(V(v), V(w)));
+      endpoints.push_back(v);
+      endpoints.push_back(w);
+    }
+  }
+  return retval;
+}
+
+/// R-MAT (recursive matrix, the Graph500 Kronecker generator) over 2^scale vertices with
+/// edge_factor * 2^scale sampled edges. Self edges and duplicates are removed, so the
+/// result is sorted and slightly smaller.
+template <typename V>
+std::vector<typename Graph<V>::Edge> rmatEdges(unsigned scale, std::size_t edge_factor, unsigned seed,
+                                               double a = 0.57, double b = 0.19, double c = 0.19)
+{
+  typedef std::pair<std::size_t, std::size_t> id_pair;
+  const std::size_t number_of_samples = edge_factor << scale;
+  const std::size_t chunk_size = detail::generator_chunk_size;
+  std::vector<std::vector<id_pair> > chunks((number_of_samples + chunk_size - 1) / chunk_size);
+
+  parallelFor(number_of_samples, chunk_size, [&](std::size_t begin, std::size_t end) {
+    std::mt19937 gen = detail::chunkGenerator(seed, begin / chunk_size);
+    std::uniform_real_distribution<double> r(0.0, 1.0);
+    std::vector<id_pair>& pairs = chunks[begin / chunk_size];
+    pairs.reserve(end - begin);
+
+    for (std::size_t i = begin; i < end; ++i) {
+      std::size_t u = 0, v = 0;
+      for (unsigned bit = 0; bit < scale; ++bit) {
+        const double q = r(gen);
+        const bool down = q >= a + b;                   // quadrant c or d
+        const bool right = (q >= a && q < a + b) || q >= a + b + c; // quadrant b or d
+        u = (u << 1) | (down ? 1 : 0);
+        v = (v << 1) | (right ? 1 : 0);
+      }
+      if (u != v)
+        pairs.push_back(u < v ? id_pair(u, v) : id_pair(v, u));
+    }
+  });
+
+  std::vector<id_pair> pairs = detail::concatenate(chunks);
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  std::vector<typename Graph<V>::Edge> retval;
+  retval.reserve(pairs.size());
+  for (const auto& p : pairs)
+    retval.push_back(typename Graph<V>::Edge(V(p.first), V(p.second)));
+
+  return retval;
+}
+
+/// number_of_columns * number_of_rows lattice points V(x, y), connected to their 4
+/// (or with diagonals 8) neighbours.
+template <typename V>
+std::vector<typename Graph<V>::Edge> gridEdges(std::size_t number_of_columns, std::size_t number_of_rows, bool diagonals = false)
+{
+  typedef typename Graph<V>::Edge Edge;
+  std::vector<std::vector<Edge> > chunks(number_of_rows);
+
+  parallelFor(number_of_rows, 1, [&](std::size_t y, std::size_t) {
+    std::vector<Edge>& edges = chunks[y];
+    for (std::size_t x = 0; x < number_of_columns; ++x) {
+      const V p(x, y);
+      if (x + 1 < number_of_columns)
+        edges.push_back(Edge(p, V(x + 1, y)));
+      if (y + 1 < number_of_rows)
+        edges.push_back(Edge(p, V(x, y + 1)));
+      if (diagonals && y + 1 < number_of_rows) {
+        if (x + 1 < number_of_columns)
+          edges.push_back(Edge(p, V(x + 1, y + 1)));
+        if (x > 0)
+          edges.push_back(Edge(p, V(x - 1, y + 1)));
+      }
+    }
+  });
+  return detail::concatenate(chunks);
+}
+
+/// number_of_vertices uniform random points V(x, y) in a square of side
+/// sqrt(number_of_vertices) (unit density), connected when closer than radius.
+/// The average degree is about pi * radius^2, no edges for a radius that is not positive.
+template <typename V>
+std::vector<typename Graph<V>::Edge> randomGeometricEdges(std::size_t number_of_vertices, double radius, unsigned seed)
+{
+  typedef typename Graph<V>::Edge Edge;
+  if (!(radius > 0))
+    return std::vector<Edge>();
+
+  const double side = std::sqrt(double(number_of_vertices));
+  const std::size_t chunk_size = detail::generator_chunk_size;
+
+  std::vector<double> xs(number_of_vertices), ys(number_of_vertices);
+  parallelFor(number_of_vertices, chunk_size, [&](std::size_t begin, std::size_t end) {
+    std::mt19937 gen = detail::chunkGenerator(seed, begin / chunk_size);
+    std::uniform_real_distribution<double> coord(0.0, side);
+    for (std::size_t i = begin; i < end; ++i) {
+      xs[i] = coord(gen);
+      ys[i] = coord(gen);
+    }
+  });
+
+  // bucket the points into cells of at least radius, only neighbouring cells have to be compared;
+  // no more cells per row than sqrt(number_of_vertices), a tiny radius leaves them unit sized
+  const std::size_t cells = std::max<std::size_t>(1, std::size_t(std::min(side / radius, side)));
+  const double cell_size = side / cells;
+  std::vector<std::size_t> bucket_of(number_of_vertices);
+  std::vector<std::size_t> bucket_begin(cells * cells + 1, 0);
+  for (std::size_t i = 0; i < number_of_vertices; ++i) {
+    const std::size_t cx = std::min(cells - 1, std::size_t(xs[i] / cell_size));
+    const std::size_t cy = std::min(cells - 1, std::size_t(ys[i] / cell_size));
+    bucket_of[i] = cy * cells + cx;
+    ++bucket_begin[bucket_of[i] + 1];
+  }
+  for (std::size_t b = 0; b < cells * cells; ++b)
+    bucket_begin[b + 1] += bucket_begin[b];
+
+  std::vector<std::size_t> sorted(number_of_vertices);
+  std::vector<std::size_t> fill(bucket_begin.begin(), bucket_begin.end() - 1);
+  for (std::size_t i = 0; i < number_of_vertices; ++i)
+    sorted[fill[bucket_of[i]]++] = i;
+
+  const double radius2 = radius * radius;
+  std::vector<std::vector<Edge> > chunks(cells);
+  parallelFor(cells, 1, [&](std::size_t cy, std::size_t) {
+    std::vector<Edge>& edges = chunks[cy];
+    for (std::size_t cx = 0; cx < cells; ++cx)
+      for (std::size_t pi = bucket_begin[cy * cells + cx]; pi < bucket_begin[cy * cells + cx + 1]; ++pi) {
+        const std::size_t p = sorted[pi];
+        for (std::size_t ny = (cy > 0 ? cy - 1 : 0); ny <= std::min(cells - 1, cy + 1); ++ny)
+          for (std::size_t nx = (cx > 0 ? cx - 1 : 0); nx <= std::min(cells - 1, cx + 1); ++nx)
+            for (std::size_t qi = bucket_begin[ny * cells + nx]; qi < bucket_begin[ny * cells + nx + 1]; ++qi) {
+              const std::size_t q = sorted[qi];
+              const double dx = xs[p] - xs[q], dy = ys[p] - ys[q];
+              if (p < q && dx * dx + dy * dy < radius2)
+                edges.push_back(Edge(V(xs[p], ys[p]), V(xs[q], ys[q])));
+            }
+      }
+  });
+  return detail::concatenate(chunks);
+}
+
+
+/// Loads the generated edges through the bulk path.
+template <typename V>
+void fillGraph(Graph<V>& graph, const std::vector<typename Graph<V>::Edge>& edges)
+{
+  graph.addEdges(edges);
+}
+
+/// Loads the generated edges, weighted by weight(source, destination). An undirected
+/// \ref GraphWD stores both directions, a directed one only source -> destination.
+template <typename V, typename E, GraphWDLayout L, typename F>
+void fillGraph(GraphWD<V, E, L>& graph, const std::vector<typename Graph<V>::Edge>& edges, F weight)
+{
+  std::vector<typename GraphWD<V, E, L>::Edge> weighted;
+  weighted.reserve(edges.size());
+  for (const auto& e : edges)
+    weighted.push_back(typename GraphWD<V, E, L>::Edge(e.source, e.destination, weight(e.source, e.destination)));
+
+  graph.addEdges(weighted);
+}
+
+#endif // GRAPH_GENERATORS_HPP
@@ -0,0 +1,248 @@
+#ifndef GRAPH_REORDERING_HPP
+#define GRAPH_REORDERING_HPP
+
+#include "graph.hpp"
+#include "compressed_graph.hpp"
+#include "graph_traits.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+/**
+  Vertex orderings for cache locality.
+
+  The iteration order of \ref Graph is whatever the hashing of std::unordered_map
+  gives, so neighbours end up scattered over memory. The functions below compute
+  a permutation of the vertices (a \ref std::vector listing every vertex once,
+  position = new dense id) which can be fed into \ref CompressedGraph. They take
+  any graph with a \ref graph_traits.
+
+  - reverseCuthillMcKeeOrder: BFS from a minimal degree vertex of each component,
+    neighbours queued by increasing degree, the whole order reversed. Minimizes
+    bandwidth.
+  - degreeSortOrder: highest degree first, packs the hubs of power-law graphs together.
+  - hilbertOrder: vertices sorted along a Hilbert curve over their bounding box.
+    V shall have x and y members, as for \ref QuadTree.
+*/
+
+struct OrderingMetrics {
+  std::size_t bandwidth;   // max |id(source) - id(destination)| over the edges
+  double average_gap;      // mean |id(source) - id(destination)| over the edges
+};
+
+template <typename V>
+struct Reordering {
+  CompressedGraph<V> graph;
+  OrderingMetrics before; // with the iteration order of the input graph
+  OrderingMetrics after;
+};
+
+
+namespace detail {
+
+template <typename V>
+std::unordered_map<V, std::size_t> idsOf(const std::vector<V>& order)
+{
+  std::unordered_map<V, std::size_t> ids;
+  ids.reserve(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+    ids.emplace(order[i], i);
+
+  return ids;
+}
+
+// Hilbert index of (x, y) on a 2^order x 2^order grid
+inline std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y, int order)
+{
+  std::uint64_t d = 0;
+  for (std::uint32_t s = std::uint32_t(1) << (order - 1); s > 0; s >>= 1) {
+    const std::uint32_t rx = (x & s) ? 1 : 0;
+    const std::uint32_t ry = (y & s) ? 1 : 0;
+    d += std::uint64_t(s) * s * ((3 * rx) ^ ry);
+
+    // rotate the quadrant
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+/// The vertices at their index, the iteration order for the hashed graphs.
+template <typename G>
+std::vector<typename graph_traits<G>::vertex_type>
+verticesByIndex(const G& graph, const typename graph_traits<G>::index_map& index)
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  std::vector<V> retval(index.size());
+  graph_traits<G>::forEachVertex(graph, [&](const V& v) { retval[index(v)] = v; });
+  return retval;
+}
+
+template <typename G>
+std::vector<std::size_t> outDegrees(const G& graph, const std::vector<typename graph_traits<G>::vertex_type>& vertices)
+{
+  std::vector<std::size_t> retval;
+  retval.reserve(vertices.size());
+  for (const auto& v : vertices)
+    retval.push_back(graph_traits<G>::outDegree(graph, v));
+
+  return retval;
+}
+
+} // detail namespace
+
+
+template <typename G>
+OrderingMetrics orderingMetrics(const G& graph, const std::vector<typename graph_traits<G>::vertex_type>& order)
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  const std::unordered_map<V, std::size_t> ids = detail::idsOf(order);
+
+  OrderingMetrics m = { 0, 0.0 };
+  std::size_t number_of_edges = 0;
+  double sum = 0.0;
+  for (std::size_t i = 0; i < order.size(); ++i)
+    graph_traits<G>::forEachOutEdge(graph, order[i], [&](const V& n, const typename graph_traits<G>::weight_type&) {
+      const std::size_t j = ids.at(n);
+      const std::size_t gap = i > j ? i - j : j - i;
+      m.bandwidth = std::max(m.bandwidth, gap);
+      sum += gap;
+      ++number_of_edges;
+    });
+
+  if (number_of_edges > 0)
+    m.average_gap = sum / number_of_edges;
+
+  return m;
+}
+
+template <typename G>
+std::vector<typename graph_traits<G>::vertex_type> reverseCuthillMcKeeOrder(const G& graph)
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  const typename graph_traits<G>::index_map index = graph_traits<G>::indexMap(graph);
+  const std::vector<V> vertices = detail::verticesByIndex(graph, index);
+  const std::vector<std::size_t> degrees = detail::outDegrees(graph, vertices);
+  const auto by_degree = [&degrees](std::size_t a, std::size_t b) { return degrees[a] < degrees[b]; };
+
+  std::vector<std::size_t> starts(vertices.size());
+  for (std::size_t i = 0; i < starts.size(); ++i)
+    starts[i] = i;
+  std::stable_sort(starts.begin(), starts.end(), by_degree);
+
+  std::vector<std::size_t> order;
+  order.reserve(vertices.size());
+  std::vector<bool> visited(vertices.size(), false);
+
+  std::vector<std::size_t> neighbours;
+  for (const std::size_t start : starts) {
+    if (visited[start])
+      continue;
+    visited[start] = true;
+
+    // the order vector doubles as the BFS queue
+    std::size_t head = order.size();
+    order.push_back(start);
+    for (; head < order.size(); ++head) {
+      neighbours.clear();
+      graph_traits<G>::forEachOutEdge(graph, vertices[order[head]],
+                                      [&](const V& n, const typename graph_traits<G>::weight_type&) {
+        const std::size_t i = index(n);
+        if (!visited[i]) {
+          visited[i] = true;
+          neighbours.push_back(i);
+        }
+      });
+
+      std::stable_sort(neighbours.begin(), neighbours.end(), by_degree);
+      order.insert(order.end(), neighbours.begin(), neighbours.end());
+    }
+  }
+
+  std::vector<V> retval;
+  retval.reserve(order.size());
+  for (auto it = order.rbegin(); it != order.rend(); ++it)
+    retval.push_back(vertices[*it]);
+
+  return retval;
+}
+
+template <typename G>
+std::vector<typename graph_traits<G>::vertex_type> degreeSortOrder(const G& graph)
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  const std::vector<V> vertices = detail::verticesByIndex(graph, graph_traits<G>::indexMap(graph));
+  const std::vector<std::size_t> degrees = detail::outDegrees(graph, vertices);
+
+  std::vector<std::size_t> order(vertices.size());
+  for (std::size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&degrees](std::size_t a, std::size_t b) { return degrees[a] > degrees[b]; });
+
+  std::vector<V> retval;
+  retval.reserve(order.size());
+  for (const std::size_t i : order)
+    retval.push_back(vertices[i]);
+
+  return retval;
+}
+
+template <typename G>
+std::vector<typename graph_traits<G>::vertex_type> hilbertOrder(const G& graph)
+{
+  typedef typename graph_traits<G>::vertex_type V;
+  std::vector<V> order;
+  order.reserve(graph_traits<G>::numberOfVertices(graph));
+  graph_traits<G>::forEachVertex(graph, [&order](const V& v) { order.push_back(v); });
+  if (order.empty())
+    return order;
+
+  double min_x = order.front().x, max_x = min_x;
+  double min_y = order.front().y, max_y = min_y;
+  for (const V& v : order) {
+    min_x = std::min<double>(min_x, v.x); max_x = std::max<double>(max_x, v.x);
+    min_y = std::min<double>(min_y, v.y); max_y = std::max<double>(max_y, v.y);
+  }
+
+  constexpr int bits = 16;
+  constexpr double cells = (1 << bits) - 1;
+  const double extent = std::max(max_x - min_x, max_y - min_y);
+  const double scale = extent > 0.0 ? cells / extent : 0.0;
+
+  std::vector<std::pair<std::uint64_t, std::size_t> > keys;
+  keys.reserve(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    const std::uint32_t x = std::uint32_t((order[i].x - min_x) * scale);
+    const std::uint32_t y = std::uint32_t((order[i].y - min_y) * scale);
+    keys.emplace_back(detail::hilbertIndex(x, y, bits), i);
+  }
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<V> retval;
+  retval.reserve(order.size());
+  for (const auto& k : keys)
+    retval.push_back(order[k.second]);
+
+  return retval;
+}
+
+/// Permutes the graph into dense ids of the given order and reports the locality metrics.
+template <typename V>
+Reordering<V> reorder(const Graph<V>& graph, const std::vector<V>& order)
+{
+  Reordering<V> r = { CompressedGraph<V>(graph, order),
+                      orderingMetrics(graph, graph.vertices()),
+                      orderingMetrics(graph, order) };
+  return r;
+}
+
+#endif // GRAPH_REORDERING_HPP
@@ -0,0 +1,212 @@
+#ifndef GRAPH_TRAITS_HPP
+#define GRAPH_TRAITS_HPP
+
+#include "graph.hpp"
+#include "graphwd.hpp"
+#include "compressed_graph.hpp"
+
+#include <unordered_map>
+
+#include <cstddef>
+
+/**
+  Compile time interface of the graph containers. \ref Graph, \ref GraphWD and
+  \ref CompressedGraph differ in their API (free functions or members, neighbours
+  by reference or by copy, vertices or dense ids), the generic algorithms, as
+  \ref dijkstraShortestPath or \ref reverseCuthillMcKeeOrder, only go through
+  graph_traits<G>, and a new storage plugs in with a specialization of it:
+
+  - vertex_type, and weight_type: the weight kept with an edge, int for the
+    unweighted graphs, whose edges all weight 1
+  - numberOfVertices(g)
+  - forEachVertex(g, f): f(v) for every vertex
+  - forEachOutEdge(g, u, f): f(v, stored weight) for every edge u -> v, none if
+    u is not a vertex
+  - outDegree(g, u): the number of edges leaving u, parallel edges included
+  - index_map and indexMap(g): index(v) numbers the vertices in [0, numberOfVertices()),
+    so that data per vertex fits into a std::vector. A \ref CompressedGraph hands out
+    its dense ids, the others number their vertices into a hash map, in O(n).
+
+  The vertices and the out edges are visited instead of returned as ranges: no
+  container has to build an iterator over (destination, weight) pairs, and f is
+  inlined into the loop over the native storage.
+*/
+template <typename G>
+struct graph_traits;
+
+namespace detail {
+
+/// Numbers the vertices in iteration order.
+template <typename V>
+class HashedIndexMap {
+public:
+
+  template <typename G>
+  explicit HashedIndexMap(const G& graph);
+
+  std::size_t operator()(const V& v) const { return m_ids.at(v); } // throws std::out_of_range
+  std::size_t size() const { return m_ids.size(); }
+
+private:
+
+  std::unordered_map<V, std::size_t> m_ids;
+};
+
+/// The dense ids of a \ref CompressedGraph, nothing is built.
+template <typename V>
+class CompressedIndexMap {
+public:
+
+  explicit CompressedIndexMap(const CompressedGraph<V>& graph) : m_graph(&graph) {}
+
+  std::size_t operator()(const V& v) const { return m_graph->id(v); } // throws std::out_of_range
+  std::size_t size() const { return m_graph->numberOfVertices(); }
+
+private:
+
+  const CompressedGraph<V>* m_graph;
+};
+
+} // detail namespace
+
+
+template <typename V>
+struct graph_traits<Graph<V> > {
+  typedef Graph<V> graph_type;
+  typedef V vertex_type;
+  typedef int weight_type;
+  typedef detail::HashedIndexMap<V> index_map;
+
+  static std::size_t numberOfVertices(const graph_type& g);
+  template <typename F> static void forEachVertex(const graph_type& g, F f);
+  template <typename F> static void forEachOutEdge(const graph_type& g, const V& u, F f);
+  static std::size_t outDegree(const graph_type& g, const V& u) { return g.neighboursOf(u).size(); }
+  static index_map indexMap(const graph_type& g) { return index_map(g); }
+};
+
+template <typename V, typename E, GraphWDLayout L>
+struct graph_traits<GraphWD<V, E, L> > {
+  typedef GraphWD<V, E, L> graph_type;
+  typedef V vertex_type;
+  typedef E weight_type;
+  typedef detail::HashedIndexMap<V> index_map;
+
+  static std::size_t numberOfVertices(const graph_type& g) { return g.numberOfVertices(); }
+  template <typename F> static void forEachVertex(const graph_type& g, F f);
+  template <typename F> static void forEachOutEdge(const graph_type& g, const V& u, F f) { g.forEachEdgeFrom(u, f); }
+  static std::size_t outDegree(const graph_type& g, const V& u);
+  static index_map indexMap(const graph_type& g) { return index_map(g); }
+};
+
+template <typename V>
+struct graph_traits<CompressedGraph<V> > {
+  typedef CompressedGraph<V> graph_type;
+  typedef V vertex_type;
+  typedef int weight_type;
+  typedef detail::CompressedIndexMap<V> index_map;
+
+  static std::size_t numberOfVertices(const graph_type& g) { return g.numberOfVertices(); }
+  template <typename F> static void forEachVertex(const graph_type& g, F f);
+  template <typename F> static void forEachOutEdge(const graph_type& g, const V& u, F f);
+  static std::size_t outDegree(const graph_type& g, const V& u);
+  static index_map indexMap(const graph_type& g) { return index_map(g); }
+};
+
+
+
+// HashedIndexMap implementation
+
+template <typename V>
+template <typename G>
+detail::HashedIndexMap<V>::HashedIndexMap(const G& graph)
+  : m_ids()
+{
+  m_ids.reserve(graph_traits<G>::numberOfVertices(graph));
+  graph_traits<G>::forEachVertex(graph, [this](const V& v) { m_ids.emplace(v, m_ids.size()); });
+}
+
+
+
+// graph_traits<Graph> implementation
+
+template <typename V>
+std::size_t graph_traits<Graph<V> >::numberOfVertices(const graph_type& g)
+{
+  // numberOfVertices(g) copies the vertices
+  std::size_t n = 0;
+  for (auto it = g.begin(); it != g.end(); ++it)
+    ++n;
+
+  return n;
+}
+
+template <typename V>
+template <typename F>
+void graph_traits<Graph<V> >::forEachVertex(const graph_type& g, F f)
+{
+  for (auto it = g.begin(); it != g.end(); ++it)
+    f(*it);
+}
+
+template <typename V>
+template <typename F>
+void graph_traits<Graph<V> >::forEachOutEdge(const graph_type& g, const V& u, F f)
+{
+  const weight_type unweighted = 1;
+  for (const V& v : g.neighboursOf(u))
+    f(v, unweighted);
+}
+
+
+
+// graph_traits<GraphWD> implementation
+
+template <typename V, typename E, GraphWDLayout L>
+template <typename F>
+void graph_traits<GraphWD<V, E, L> >::forEachVertex(const graph_type& g, F f)
+{
+  for (auto it = g.cbegin(); it != g.cend(); ++it)
+    f(*it);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+std::size_t graph_traits<GraphWD<V, E, L> >::outDegree(const graph_type& g, const V& u)
+{
+  std::size_t n = 0;
+  g.forEachEdgeFrom(u, [&n](const V&, const E&) { ++n; });
+  return n;
+}
+
+
+
+// graph_traits<CompressedGraph> implementation
+
+template <typename V>
+template <typename F>
+void graph_traits<CompressedGraph<V> >::forEachVertex(const graph_type& g, F f)
+{
+  for (const V& v : g.vertices())
+    f(v);
+}
+
+template <typename V>
+template <typename F>
+void graph_traits<CompressedGraph<V> >::forEachOutEdge(const graph_type& g, const V& u, F f)
+{
+  const std::size_t u_id = g.find(u);
+  if (u_id == graph_type::npos)
+    return;
+
+  const weight_type unweighted = 1;
+  for (const std::size_t id : g.neighbourIds(u_id))
+    f(g.vertex(id), unweighted);
+}
+
+template <typename V>
+std::size_t graph_traits<CompressedGraph<V> >::outDegree(const graph_type& g, const V& u)
+{
+  const std::size_t u_id = g.find(u);
+  return u_id == graph_type::npos ? 0 : g.degree(u_id);
+}
+
+#endif // GRAPH_TRAITS_HPP
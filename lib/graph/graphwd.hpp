@@ -6,11 +6,41 @@
 #include <set>
 
 #include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
 
 // weighed, directed
 
+/// How GraphWD keeps the edges leaving a vertex.
+enum GraphWDLayout {
+  EDGE_TO_LAYOUT, ///< one vector of (iterator to the destination in the vertex map, weight)
+  SPLIT_LAYOUT    ///< the destinations and the weights in two parallel vectors
+};
+
+/// What GraphWD::collapseParallelEdges keeps of the edges between the same two vertices.
+enum ParallelEdgeMerge {
+  KEEP_MIN_WEIGHT, ///< the lightest edge, as for the shortest paths
+  KEEP_MAX_WEIGHT,
+  SUM_WEIGHTS      ///< one edge weighting the sum, as for capacities
+};
+
+/**
+  With SPLIT_LAYOUT the edges of a vertex are two contiguous arrays: a loop over
+  the weights reads nothing else, and an edge costs sizeof(V) + sizeof(E) instead
+  of an iterator (a node pointer) padded next to the weight. Removing a vertex of
+  an undirected graph looks its neighbours up by value instead of following the
+  iterators. Both layouts have the same interface and edge order.
+
+  Parallel edges are allowed. collapseParallelEdges merges them into one edge per
+  (source, destination) and orders the edges of every vertex by the hash of their
+  destination, so a relaxation visits each neighbour once and weight(source,
+  destination) is a binary search. Adding an edge afterwards drops the order,
+  weight() scans again until the next collapse.
+*/
 template <typename V,
-          typename E = int>
+          typename E = int,
+          GraphWDLayout L = EDGE_TO_LAYOUT>
 class GraphWD {
 
 public:
@@ -30,9 +60,14 @@ private:
 
   struct EdgeTo;
 
-  // @todo switch to std::unordered_map<V, std::pair<std::vector<V>, std::vector<E>>> for quicker neighbours & weights
-  // also turning the graph into unordered, weighted, with no multi & self edges by default
-  typedef std::unordered_map<V, std::vector<EdgeTo> > v_container;
+  struct SplitEdges {
+    std::vector<V> destinations;
+    std::vector<E> weights; // of the edge to destinations[i]
+  };
+
+  // @todo turn the graph into unordered, weighted, with no multi & self edges by default
+  typedef typename std::conditional<L == SPLIT_LAYOUT, SplitEdges, std::vector<EdgeTo> >::type edge_container;
+  typedef std::unordered_map<V, edge_container> v_container;
   typedef typename v_container::iterator v_iterator;
   typedef typename v_container::const_iterator v_const_iterator;
 
@@ -72,13 +107,13 @@ public:
   typedef Edge& edge_reference;
 
 
-  GraphWD(bool isdirected = true) : m_directed(isdirected), m_vertices() {}
-  GraphWD(const GraphWD<V, E>& o) : m_directed(o.m_directed), m_vertices(o.m_vertices) {}
+  GraphWD(bool isdirected = true) : m_directed(isdirected), m_collapsed(false), m_vertices() {}
+  GraphWD(const GraphWD<V, E, L>& o) : m_directed(o.m_directed), m_collapsed(o.m_collapsed), m_vertices(o.m_vertices) {}
   GraphWD(std::initializer_list<V> vertex_list);
   GraphWD(std::initializer_list<Edge> edge_list);
 
-  GraphWD<V, E>& operator=(GraphWD<V, E> o) { swap(o); return *this; }
-  void swap(GraphWD& o) { std::swap (m_directed, o.m_directed); std::swap(m_vertices, o.m_vertices); }
+  GraphWD<V, E, L>& operator=(GraphWD<V, E, L> o) { swap(o); return *this; }
+  void swap(GraphWD& o);
 
   // Properties
   bool directed() const { return m_directed; }
@@ -96,15 +131,26 @@ public:
   void addVertex(const_reference data);
   void removeVertex(const_reference data);
   void addEdge(const_reference source, const_reference destination, const_weight_reference weight = weight_type());
+  void addEdges(const std::vector<Edge>& edge_list);
   void removeEdge(const_reference source, const_reference destination, const_weight_reference weight = weight_type());
   void removeEdges(const_reference source, const_reference destination);
+  /// One edge per (source, destination), its weight merged from the parallel edges.
+  void collapseParallelEdges(ParallelEdgeMerge merge = KEEP_MIN_WEIGHT);
 
   // Lookup
   bool contains(const_reference data) const { return m_vertices.find(data) != m_vertices.end(); }
   std::vector<value_type> vertices() const;
   std::vector<value_type> neighboursOf(const_reference data) const;
   std::vector<weight_type> weights(const_reference source, const_reference destination) const;
+  /// The weight of the edge source -> destination, of the first one if they are parallel,
+  /// nullptr if there is none. Points into the graph until it changes.
+  const weight_type* weight(const_reference source, const_reference destination) const;
   std::vector<Edge> edges() const;
+  template <typename F> void forEachEdgeFrom(const_reference source, F f) const;
+  /// SPLIT_LAYOUT only: the destinations and the weights of the edges leaving source,
+  /// parallel arrays, empty ones if source is not a vertex.
+  const std::vector<value_type>& destinationsFrom(const_reference source) const;
+  const std::vector<weight_type>& weightsFrom(const_reference source) const;
 
   // iterators
 
@@ -153,32 +199,66 @@ public:
 
 private:
 
+  // the parts depending on the layout, overloaded on the edge container
+
+  static size_type numberOfEdges(const std::vector<EdgeTo>& v) { return v.size(); }
+  static size_type numberOfEdges(const SplitEdges& v) { return v.destinations.size(); }
+  static void pushEdge(std::vector<EdgeTo>& v, v_iterator destination, const_weight_reference weight);
+  static void pushEdge(SplitEdges& v, v_iterator destination, const_weight_reference weight);
+  /// Calls f(destination, weight) for the edges of v.
+  template <typename F> static void forEachEdge(const std::vector<EdgeTo>& v, F f);
+  template <typename F> static void forEachEdge(const SplitEdges& v, F f);
+  /// Erases the edges to data from its neighbours, in an undirected graph.
+  void eraseBackEdges(std::vector<EdgeTo>& v, const_reference data);
+  void eraseBackEdges(SplitEdges& v, const_reference data);
+
   static void eraseEdge(typename std::vector<EdgeTo>& v, const_reference data);
   static void eraseEdge(typename std::vector<EdgeTo>& v, const_reference data, const_weight_reference weight);
+  static void eraseEdge(SplitEdges& v, const_reference data);
+  static void eraseEdge(SplitEdges& v, const_reference data, const_weight_reference weight);
+  /// Keeps the edges of v for which keep(destination, weight) holds, in order.
+  template <typename F> static void keepEdges(SplitEdges& v, F keep);
+
+  static const V& destinationAt(const std::vector<EdgeTo>& v, size_type i) { return v[i].m_destination->first; }
+  static const V& destinationAt(const SplitEdges& v, size_type i) { return v.destinations[i]; }
+  static const E& weightAt(const std::vector<EdgeTo>& v, size_type i) { return v[i].m_weight; }
+  static const E& weightAt(const SplitEdges& v, size_type i) { return v.weights[i]; }
+  static E& weightAt(std::vector<EdgeTo>& v, size_type i) { return v[i].m_weight; }
+  static E& weightAt(SplitEdges& v, size_type i) { return v.weights[i]; }
+  static void copyEdge(std::vector<EdgeTo>& to, const std::vector<EdgeTo>& from, size_type i) { to.push_back(from[i]); }
+  static void copyEdge(SplitEdges& to, const SplitEdges& from, size_type i);
+  static void reserveEdges(std::vector<EdgeTo>& v, size_type n) { v.reserve(n); }
+  static void reserveEdges(SplitEdges& v, size_type n) { v.destinations.reserve(n); v.weights.reserve(n); }
+
+  static std::size_t hashOf(const V& v) { return std::hash<V>()(v); }
+  static void mergeWeight(E& into, const E& weight, ParallelEdgeMerge merge);
+  /// Merges the parallel edges of v, orders them by destination hash.
+  static void collapseEdges(edge_container& v, ParallelEdgeMerge merge);
 
   bool m_directed;
+  bool m_collapsed; // no parallel edges, the edges of a vertex ordered by destination hash
   v_container m_vertices;
 };
 
 
 // Edge
 
-template <typename V, typename E>
-inline GraphWD<V, E>::Edge::Edge(const_reference s, const_reference d, const_weight_reference w)
+template <typename V, typename E, GraphWDLayout L>
+inline GraphWD<V, E, L>::Edge::Edge(const_reference s, const_reference d, const_weight_reference w)
   : source(s)
   , destination(d)
   , weight(w)
 {}
 
-template <typename V, typename E>
-inline GraphWD<V, E>::Edge::Edge(const Edge& o)
+template <typename V, typename E, GraphWDLayout L>
+inline GraphWD<V, E, L>::Edge::Edge(const Edge& o)
   : source(o.source)
   , destination(o.destination)
   , weight(o.weight)
 {}
 
-template <typename V, typename E>
-inline void GraphWD<V, E>::Edge::swap(Edge& o)
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::Edge::swap(Edge& o)
 {
   std::swap(source, o.source);
   std::swap(destination, o.destination);
@@ -187,21 +267,21 @@ inline void GraphWD<V, E>::Edge::swap(Edge& o)
 
 
 // EdgeTo
-template <typename V, typename E>
-inline GraphWD<V, E>::EdgeTo::EdgeTo(v_iterator destination, const_weight_reference weight)
+template <typename V, typename E, GraphWDLayout L>
+inline GraphWD<V, E, L>::EdgeTo::EdgeTo(v_iterator destination, const_weight_reference weight)
   : m_destination(destination)
   , m_weight(weight)
 {}
 
-template <typename V, typename E>
-inline void GraphWD<V, E>::EdgeTo::swap(EdgeTo& o)
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::EdgeTo::swap(EdgeTo& o)
 {
   std::swap(m_destination, o.m_destination);
   std::swap(m_weight, o.m_weight);
 }
 
-template <typename V, typename E>
-inline bool GraphWD<V, E>::EdgeTo::operator==(const EdgeTo& other) const
+template <typename V, typename E, GraphWDLayout L>
+inline bool GraphWD<V, E, L>::EdgeTo::operator==(const EdgeTo& other) const
 {
   return m_destination == other.m_destination &&
          m_weight == other.m_weight;
@@ -209,44 +289,52 @@ inline bool GraphWD<V, E>::EdgeTo::operator==(const EdgeTo& other) const
 
 // GraphWD
 
-template <typename V, typename E>
-GraphWD<V, E>::GraphWD(std::initializer_list<V> vertex_list)
-  : GraphWD<V, E>()
+template <typename V, typename E, GraphWDLayout L>
+GraphWD<V, E, L>::GraphWD(std::initializer_list<V> vertex_list)
+  : GraphWD<V, E, L>()
 {
   for(const V& v : vertex_list)
     addVertex(v);
 }
 
-template <typename V, typename E>
-GraphWD<V, E>::GraphWD(std::initializer_list<Edge> edge_list)
-  : GraphWD<V, E>()
+template <typename V, typename E, GraphWDLayout L>
+GraphWD<V, E, L>::GraphWD(std::initializer_list<Edge> edge_list)
+  : GraphWD<V, E, L>()
 {
   for (const Edge& e : edge_list )
     addEdge(e.source, e.destination, e.weight);
 }
 
-template <typename V, typename E>
-inline typename GraphWD<V, E>::size_type GraphWD<V, E>::numberOfEdges() const
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::swap(GraphWD& o)
+{
+  std::swap(m_directed, o.m_directed);
+  std::swap(m_collapsed, o.m_collapsed);
+  std::swap(m_vertices, o.m_vertices);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline typename GraphWD<V, E, L>::size_type GraphWD<V, E, L>::numberOfEdges() const
 {
   int sum = 0;
   for (const auto& v : m_vertices)
-    sum += v.second.size();
+    sum += numberOfEdges(v.second);
 
   return sum;
 }
 
-template <typename V, typename E>
-inline void GraphWD<V, E>::addVertex(const_reference data)
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::addVertex(const_reference data)
 {
   if (m_vertices.find(data) != m_vertices.end())
     return;
 
-  std::pair<V, std::vector<GraphWD<V, E>::EdgeTo> > p(data, std::vector<EdgeTo>());
+  std::pair<V, edge_container> p(data, edge_container());
   m_vertices.insert(p);
 }
 
-template <typename V, typename E>
-inline void GraphWD<V, E>::removeVertex(const_reference data)
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::removeVertex(const_reference data)
 {
   v_iterator it = m_vertices.find(data);
   if (it == m_vertices.end())
@@ -256,14 +344,13 @@ inline void GraphWD<V, E>::removeVertex(const_reference data)
     for (auto &v : m_vertices)
         eraseEdge(v.second, data);
   else
-    for (EdgeTo& n : it->second)
-      eraseEdge(n.m_destination->second, data);
+    eraseBackEdges(it->second, data);
 
   m_vertices.erase(it);
 }
 
-template <typename V, typename E>
-void GraphWD<V, E>::addEdge(const_reference source, const_reference destination, const_weight_reference weight)
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::addEdge(const_reference source, const_reference destination, const_weight_reference weight)
 {
   addVertex(source);
   addVertex(destination);
@@ -271,13 +358,23 @@ void GraphWD<V, E>::addEdge(const_reference source, const_reference destination,
   v_iterator source_it = m_vertices.find(source);
   v_iterator destination_it = m_vertices.find(destination);
 
-  source_it->second.push_back(GraphWD<V, E>::EdgeTo(destination_it, weight));
+  pushEdge(source_it->second, destination_it, weight);
   if (!m_directed && source != destination)
-    destination_it->second.push_back(GraphWD<V, E>::EdgeTo(source_it, weight));
+    pushEdge(destination_it->second, source_it, weight);
+  m_collapsed = false;
 }
 
-template <typename V, typename E>
-inline void GraphWD<V, E>::removeEdge(const_reference source, const_reference destination, const_weight_reference weight)
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::addEdges(const std::vector<Edge>& edge_list)
+{
+  // a single allocation for the buckets, instead of rehashing along the way
+  m_vertices.reserve(m_vertices.size() + edge_list.size());
+  for (const Edge& e : edge_list)
+    addEdge(e.source, e.destination, e.weight);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::removeEdge(const_reference source, const_reference destination, const_weight_reference weight)
 {
   v_iterator source_it = m_vertices.find(source);
   if (source_it == m_vertices.end())
@@ -292,8 +389,8 @@ inline void GraphWD<V, E>::removeEdge(const_reference source, const_reference de
     eraseEdge(destination_it->second, source, weight);
 }
 
-template <typename V, typename E>
-inline void GraphWD<V, E>::removeEdges(const_reference source, const_reference destination)
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::removeEdges(const_reference source, const_reference destination)
 {
   v_iterator source_it = m_vertices.find(source);
   if (source_it == m_vertices.end())
@@ -308,8 +405,17 @@ inline void GraphWD<V, E>::removeEdges(const_reference source, const_reference d
     eraseEdge(destination_it->second, source);
 }
 
-template <typename V, typename E>
-inline std::vector<typename GraphWD<V, E>::value_type> GraphWD<V, E>::vertices() const
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::collapseParallelEdges(ParallelEdgeMerge merge)
+{
+  // the back edge of an undirected edge merges the same weights in the same order
+  for (auto& v : m_vertices)
+    collapseEdges(v.second, merge);
+  m_collapsed = true;
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline std::vector<typename GraphWD<V, E, L>::value_type> GraphWD<V, E, L>::vertices() const
 {
   std::vector<value_type> retval;
   for (const auto& v : m_vertices)
@@ -318,24 +424,25 @@ inline std::vector<typename GraphWD<V, E>::value_type> GraphWD<V, E>::vertices()
   return retval;
 }
 
-template <typename V, typename E>
-std::vector<typename GraphWD<V, E>::value_type> GraphWD<V, E>::neighboursOf(const_reference data) const
+template <typename V, typename E, GraphWDLayout L>
+std::vector<typename GraphWD<V, E, L>::value_type> GraphWD<V, E, L>::neighboursOf(const_reference data) const
 {
   typename std::vector<value_type> retval;
   v_const_iterator vertex_it = m_vertices.find(data);
-  if (vertex_it == m_vertices.end() || vertex_it->second.empty())
+  if (vertex_it == m_vertices.end() || numberOfEdges(vertex_it->second) == 0)
     return retval;
 
   std::set<value_type> tmp;
-  for (const EdgeTo& e : vertex_it->second)
-    if (tmp.insert(e.m_destination->first).second)
-      retval.push_back(e.m_destination->first);
+  forEachEdge(vertex_it->second, [&](const_reference destination, const_weight_reference) {
+    if (tmp.insert(destination).second)
+      retval.push_back(destination);
+  });
 
   return retval;
 }
 
-template <typename V, typename E>
-std::vector<E> GraphWD<V, E>::weights(const_reference source, const_reference destination) const
+template <typename V, typename E, GraphWDLayout L>
+std::vector<E> GraphWD<V, E, L>::weights(const_reference source, const_reference destination) const
 {
   std::vector<E> retval;
   v_const_iterator vertex_it = m_vertices.find(source);
@@ -345,36 +452,234 @@ std::vector<E> GraphWD<V, E>::weights(const_reference source, const_reference de
   if (m_vertices.find(destination) == m_vertices.end())
     return retval;
 
-  for (const EdgeTo& e : vertex_it->second)
-    if (e.m_destination->first == destination)
-      retval.push_back(e.m_weight);
+  forEachEdge(vertex_it->second, [&](const_reference d, const_weight_reference weight) {
+    if (d == destination)
+      retval.push_back(weight);
+  });
 
   return retval;
 }
 
-template <typename V, typename E>
-inline std::vector<typename GraphWD<V, E>::Edge> GraphWD<V, E>::edges() const
+template <typename V, typename E, GraphWDLayout L>
+const E* GraphWD<V, E, L>::weight(const_reference source, const_reference destination) const
 {
-  std::vector<typename GraphWD<V, E>::Edge> retval;
+  v_const_iterator vertex_it = m_vertices.find(source);
+  if (vertex_it == m_vertices.end())
+    return nullptr;
+
+  const edge_container& v = vertex_it->second;
+  const size_type n = numberOfEdges(v);
+  size_type i = 0;
+  if (m_collapsed) {
+    // lower bound of the hash, then the few edges colliding with it
+    const std::size_t h = hashOf(destination);
+    size_type count = n;
+    while (count > 0) {
+      const size_type step = count / 2;
+      if (hashOf(destinationAt(v, i + step)) < h) {
+        i += step + 1;
+        count -= step + 1;
+      } else {
+        count = step;
+      }
+    }
+    for (; i < n && hashOf(destinationAt(v, i)) == h; ++i)
+      if (destinationAt(v, i) == destination)
+        return &weightAt(v, i);
+    return nullptr;
+  }
+
+  for (; i < n; ++i)
+    if (destinationAt(v, i) == destination)
+      return &weightAt(v, i);
+  return nullptr;
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline std::vector<typename GraphWD<V, E, L>::Edge> GraphWD<V, E, L>::edges() const
+{
+  std::vector<typename GraphWD<V, E, L>::Edge> retval;
   for (const auto& v : m_vertices)
-    for (const auto& e : v.second)
-      retval.push_back(GraphWD<V, E>::Edge(v.first, (e.m_destination)->first, e.m_weight));
+    forEachEdge(v.second, [&](const_reference destination, const_weight_reference weight) {
+      retval.push_back(GraphWD<V, E, L>::Edge(v.first, destination, weight));
+    });
 
   return retval;
 }
 
-template <typename V, typename E>
-void GraphWD<V, E>::eraseEdge(typename std::vector<EdgeTo>& v, const_reference data) {
+/// Calls f(destination, weight) for every edge leaving source, without copying.
+template <typename V, typename E, GraphWDLayout L>
+template <typename F>
+inline void GraphWD<V, E, L>::forEachEdgeFrom(const_reference source, F f) const
+{
+  v_const_iterator vertex_it = m_vertices.find(source);
+  if (vertex_it == m_vertices.end())
+    return;
+
+  forEachEdge(vertex_it->second, f);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+const std::vector<typename GraphWD<V, E, L>::value_type>& GraphWD<V, E, L>::destinationsFrom(const_reference source) const
+{
+  static_assert(L == SPLIT_LAYOUT, "GraphWD::destinationsFrom needs SPLIT_LAYOUT, use forEachEdgeFrom with EDGE_TO_LAYOUT");
+  static const std::vector<value_type> none;
+  v_const_iterator vertex_it = m_vertices.find(source);
+  return vertex_it == m_vertices.end() ? none : vertex_it->second.destinations;
+}
+
+template <typename V, typename E, GraphWDLayout L>
+const std::vector<E>& GraphWD<V, E, L>::weightsFrom(const_reference source) const
+{
+  static_assert(L == SPLIT_LAYOUT, "GraphWD::weightsFrom needs SPLIT_LAYOUT, use forEachEdgeFrom with EDGE_TO_LAYOUT");
+  static const std::vector<weight_type> none;
+  v_const_iterator vertex_it = m_vertices.find(source);
+  return vertex_it == m_vertices.end() ? none : vertex_it->second.weights;
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::pushEdge(std::vector<EdgeTo>& v, v_iterator destination, const_weight_reference weight)
+{
+  v.push_back(EdgeTo(destination, weight));
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::pushEdge(SplitEdges& v, v_iterator destination, const_weight_reference weight)
+{
+  v.destinations.push_back(destination->first);
+  v.weights.push_back(weight);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::copyEdge(SplitEdges& to, const SplitEdges& from, size_type i)
+{
+  to.destinations.push_back(from.destinations[i]);
+  to.weights.push_back(from.weights[i]);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+template <typename F>
+inline void GraphWD<V, E, L>::forEachEdge(const std::vector<EdgeTo>& v, F f)
+{
+  for (const EdgeTo& e : v)
+    f(e.m_destination->first, e.m_weight);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+template <typename F>
+inline void GraphWD<V, E, L>::forEachEdge(const SplitEdges& v, F f)
+{
+  const V* destinations = v.destinations.data();
+  const E* weights = v.weights.data();
+  const std::size_t n = v.weights.size();
+  for (std::size_t i = 0; i < n; ++i)
+    f(destinations[i], weights[i]);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::eraseBackEdges(std::vector<EdgeTo>& v, const_reference data)
+{
+  // a copy, a self edge is erased from v on the way
+  const std::vector<EdgeTo> neighbours(v);
+  for (const EdgeTo& n : neighbours)
+    eraseEdge(n.m_destination->second, data);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::eraseBackEdges(SplitEdges& v, const_reference data)
+{
+  // a copy, a self edge is erased from v on the way
+  const std::vector<V> neighbours(v.destinations);
+  for (const V& n : neighbours)
+    eraseEdge(m_vertices.find(n)->second, data);
+}
+
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::eraseEdge(typename std::vector<EdgeTo>& v, const_reference data) {
   v.erase(std::remove_if(v.begin(), v.end(),
                          [&data](const EdgeTo& e) { return e.m_destination->first == data; } ),
           v.end());
 }
 
-template <typename V, typename E>
-void GraphWD<V, E>::eraseEdge(typename std::vector<EdgeTo>& v, const_reference data, const_weight_reference weight ) {
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::eraseEdge(typename std::vector<EdgeTo>& v, const_reference data, const_weight_reference weight ) {
     v.erase(std::remove_if(v.begin(), v.end(),
                            [&data, &weight](const EdgeTo& e) { return e.m_destination->first == data && e.m_weight == weight; } ),
             v.end());
 }
 
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::eraseEdge(SplitEdges& v, const_reference data) {
+  keepEdges(v, [&data](const_reference d, const_weight_reference) { return !(d == data); });
+}
+
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::eraseEdge(SplitEdges& v, const_reference data, const_weight_reference weight) {
+  keepEdges(v, [&data, &weight](const_reference d, const_weight_reference w) { return !(d == data && w == weight); });
+}
+
+template <typename V, typename E, GraphWDLayout L>
+template <typename F>
+void GraphWD<V, E, L>::keepEdges(SplitEdges& v, F keep) {
+  // remove_if over both arrays in step
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < v.destinations.size(); ++i)
+    if (keep(v.destinations[i], v.weights[i])) {
+      if (kept != i) {
+        v.destinations[kept] = std::move(v.destinations[i]);
+        v.weights[kept] = std::move(v.weights[i]);
+      }
+      ++kept;
+    }
+  v.destinations.erase(v.destinations.begin() + kept, v.destinations.end());
+  v.weights.erase(v.weights.begin() + kept, v.weights.end());
+}
+
+template <typename V, typename E, GraphWDLayout L>
+inline void GraphWD<V, E, L>::mergeWeight(E& into, const E& weight, ParallelEdgeMerge merge)
+{
+  switch (merge) {
+    case KEEP_MIN_WEIGHT: if (weight < into) into = weight; break;
+    case KEEP_MAX_WEIGHT: if (into < weight) into = weight; break;
+    case SUM_WEIGHTS: into = into + weight; break;
+  }
+}
+
+template <typename V, typename E, GraphWDLayout L>
+void GraphWD<V, E, L>::collapseEdges(edge_container& v, ParallelEdgeMerge merge)
+{
+  const size_type n = numberOfEdges(v);
+  std::vector<std::size_t> hashes(n);
+  std::vector<size_type> order(n);
+  for (size_type i = 0; i < n; ++i) {
+    hashes[i] = hashOf(destinationAt(v, i));
+    order[i] = i;
+  }
+  // stable, the parallel edges are merged in the order they were added
+  std::stable_sort(order.begin(), order.end(), [&hashes](size_type a, size_type b) { return hashes[a] < hashes[b]; });
+
+  edge_container collapsed;
+  reserveEdges(collapsed, n);
+  std::vector<std::size_t> collapsed_hashes;
+  collapsed_hashes.reserve(n);
+  size_type run = 0; // the first collapsed edge with the hash of the current one
+  for (const size_type i : order) {
+    const size_type kept = collapsed_hashes.size();
+    if (kept == 0 || collapsed_hashes.back() != hashes[i])
+      run = kept;
+
+    size_type k = run;
+    while (k < kept && !(destinationAt(collapsed, k) == destinationAt(v, i)))
+      ++k;
+    if (k < kept) {
+      mergeWeight(weightAt(collapsed, k), weightAt(v, i), merge);
+    } else {
+      copyEdge(collapsed, v, i);
+      collapsed_hashes.push_back(hashes[i]);
+    }
+  }
+
+  std::swap(v, collapsed);
+}
+
 #endif // GRAPHWD_HPP
@@ -0,0 +1,732 @@
+#ifndef HIERARCHICAL_PATHFINDING_HPP
+#define HIERARCHICAL_PATHFINDING_HPP
+
+#include "graphwd.hpp"
+#include "marching_squares.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace detail {
+
+constexpr std::size_t hpa_npos = std::numeric_limits<std::size_t>::max();
+constexpr std::size_t hpa_landmarks = 16;
+constexpr float hpa_weight = 1.1f; // of the A* estimate on the abstract graph
+
+/// The 8 moves of the grid, row by row; move 7 - i undoes move i.
+constexpr int hpa_dx[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+constexpr int hpa_dy[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+inline std::uint8_t hpaMove(int dx, int dy)
+{
+  const int i = (dy + 1) * 3 + dx + 1;
+  return std::uint8_t(i > 4 ? i - 1 : i);
+}
+
+} // detail namespace
+
+
+/**
+  Hierarchical path-finding A* (HPA*, Botea et al.) over an \ref ImageMatrix.
+
+  Grid model: FREE cells are walkable, 8-connected, straight steps cost 1,
+  diagonal ones sqrt(2) and may not cut a blocked corner.
+
+  Preprocessing:
+  - the image is split into cluster_size x cluster_size clusters,
+  - along every border of two neighbouring clusters the maximal runs of walkable
+    cell pairs are entrances, a run shorter than 6 gets one transition in its
+    middle, a longer one two at its ends. A transition is two abstract nodes,
+    one on each side, joined with a cost 1 edge,
+  - the abstract nodes get ids cluster by cluster, the clusters in Z-order, so the
+    nodes of nearby clusters and their edges are close in memory,
+  - the abstract nodes of a cluster are connected with their cluster-local
+    shortest distances, the moves of each such path are kept, one byte per cell,
+  - the exact abstract distances from 16 landmarks, picked farthest first, are
+    kept per node for the ALT lower bound (Goldberg and Harrelson).
+  The abstract graph is an undirected \ref GraphWD over the node ids, kept for
+  inspection. The queries read a copy of its adjacency in flat arrays indexed by id.
+
+  Query: start and goal are connected to the abstract nodes of their clusters with
+  one cluster-local search each, and A* runs on the abstract graph with the larger
+  of the octile and the landmark bound, weighted by 1.1. The cells come from the
+  stored moves of the abstract edges and from the two endpoint searches, no other
+  search is done. The search state over the abstract nodes is generation stamped,
+  a query only touches the nodes it visits.
+
+  The result is near-optimal: paths only cross clusters at transitions, as in the
+  paper, and the weighted A* may return an abstract route up to 10% longer than the
+  shortest one, about 2% on average on random block maps, for settling several
+  times fewer nodes.
+
+  The image is referenced, not copied, and shall outlive the pathfinder; building
+  one from a temporary does not compile. findPath reuses the search state of the
+  pathfinder, hence is not const.
+*/
+class HierarchicalPathfinder {
+
+public:
+
+  typedef GraphWD<std::size_t, float> abstract_graph;
+
+  HierarchicalPathfinder(const ImageMatrix& image_matrix, std::size_t cluster_size = 16);
+  HierarchicalPathfinder(ImageMatrix&&, std::size_t = 16) = delete;
+
+  /// Cells from start to goal (both included), consecutive cells are 8-neighbours.
+  /// Empty if the goal can not be reached or an endpoint is not walkable.
+  std::vector<size_t2> findPath(const size_t2& start, const size_t2& goal);
+
+  /// Length of a cell path in the grid metric.
+  static float pathLength(const std::vector<size_t2>& path);
+
+  /// Vertices are abstract node ids, see \ref cellOfNode.
+  const abstract_graph& abstractGraph() const { return m_graph; }
+  size_t2 cellOfNode(std::size_t id) const { return size_t2(m_nodes[id] % m_image.width_, m_nodes[id] / m_image.width_); }
+  std::size_t clusterSize() const { return m_cluster_size; }
+
+private:
+
+  // binary heap with lazy deletion: stale entries are skipped when popped
+  typedef std::pair<float, std::size_t> open_entry;
+  typedef std::priority_queue<open_entry, std::vector<open_entry>, std::greater<open_entry> > open_list;
+
+  struct Box { std::size_t x0, y0, x1, y1; }; // half-open cell range [x0, x1) x [y0, y1)
+
+  /// Collected while building, before the flat adjacency exists.
+  struct AbstractEdge {
+    std::size_t a, b;
+    float cost;
+    std::size_t path; // stored moves from a to b, hpa_npos for a transition
+  };
+
+  /// Per query search state of an abstract node or of the virtual start and goal
+  /// ones, valid if its stamp is the generation of the current query.
+  /// One struct per node, a relaxation reads a single cache line.
+  struct Label {
+    float cost;
+    float estimate;    // lower bound to the goal, computed once when the node is reached
+    unsigned stamp;
+    std::size_t parent;
+  };
+
+  struct QueryState {
+    std::vector<Label> labels;
+    unsigned generation;
+
+    QueryState() : labels(), generation(0) {}
+    void begin(std::size_t n);
+  };
+
+  bool walkable(std::size_t x, std::size_t y) const { return m_image.cells_[y * m_image.width_ + x] == ImageMatrix::FREE; }
+  std::size_t clusterOf(std::size_t cell) const;
+  Box clusterBox(std::size_t cluster) const;
+  std::size_t localIndex(const Box& box, std::size_t cell) const;
+
+  void addTransitions(std::size_t x, std::size_t y, std::size_t dx, std::size_t dy, std::size_t length,
+                      std::vector<AbstractEdge>& edges);
+  void addTransition(std::size_t a, std::size_t b, std::vector<AbstractEdge>& edges);
+  void numberByCluster(std::vector<AbstractEdge>& edges);
+  void connectCluster(std::size_t cluster, std::vector<AbstractEdge>& edges);
+  void buildAdjacency(const std::vector<AbstractEdge>& edges);
+  void buildLandmarks();
+
+  /// Shortest paths from source restricted to box: Dijkstra settling the whole box
+  /// if target is hpa_npos, A* stopping at target otherwise. dist and prev are
+  /// indexed by cell index relative to the box.
+  void localSearch(const Box& box, std::size_t source, std::size_t target,
+                   std::vector<float>& dist, std::vector<std::size_t>& prev) const;
+  /// Dijkstra over the whole abstract graph.
+  void abstractSearch(std::size_t source, std::vector<float>& dist) const;
+
+  /// Appends the cells of a prev chain in box from cell up to the root of the search,
+  /// cell excluded, or if reversed the same cells from the root down to cell, root excluded.
+  void appendChain(const Box& box, const std::vector<std::size_t>& prev, std::size_t cell, bool reversed,
+                   std::vector<size_t2>& path) const;
+  /// Appends the cells after u of the abstract edge e from u to v.
+  void appendEdge(std::size_t u, std::size_t v, std::size_t e, std::vector<size_t2>& path) const;
+
+  const ImageMatrix& m_image;
+  const std::size_t m_cluster_size;
+  const std::size_t m_clusters_x;
+  const std::size_t m_clusters_y;
+  abstract_graph m_graph;
+  std::vector<std::size_t> m_nodes;                       // cell index of each abstract node
+  std::vector<float> m_node_xs;                           // cell coordinates of each abstract node
+  std::vector<float> m_node_ys;
+  std::vector<std::vector<std::size_t> > m_cluster_nodes; // abstract nodes per cluster, ascending ids
+  std::vector<std::size_t> m_edge_offsets;  // edges of node id in [m_edge_offsets[id], m_edge_offsets[id + 1])
+  std::vector<std::size_t> m_edge_targets;
+  std::vector<float> m_edge_costs;
+  std::vector<std::size_t> m_edge_paths;    // stored moves of each edge, hpa_npos for a transition
+  std::vector<std::size_t> m_path_offsets;  // moves of path p in [m_path_offsets[p], m_path_offsets[p + 1])
+  std::vector<std::uint8_t> m_path_moves;   // from the lower node id to the higher one
+  std::size_t m_landmark_count;
+  std::vector<float> m_landmark_dists;      // m_landmark_count distances per node, infinity if unreachable
+  QueryState m_query;
+};
+
+
+// HierarchicalPathfinder implementation
+
+inline HierarchicalPathfinder::HierarchicalPathfinder(const ImageMatrix& image_matrix, std::size_t cluster_size)
+  : m_image(image_matrix)
+  , m_cluster_size(std::max<std::size_t>(cluster_size, 1))
+  , m_clusters_x((image_matrix.width_ + m_cluster_size - 1) / m_cluster_size)
+  , m_clusters_y((image_matrix.height_ + m_cluster_size - 1) / m_cluster_size)
+  , m_graph(false)
+  , m_nodes()
+  , m_node_xs()
+  , m_node_ys()
+  , m_cluster_nodes(m_clusters_x * m_clusters_y)
+  , m_edge_offsets()
+  , m_edge_targets()
+  , m_edge_costs()
+  , m_edge_paths()
+  , m_path_offsets(1, 0)
+  , m_path_moves()
+  , m_landmark_count(0)
+  , m_landmark_dists()
+  , m_query()
+{
+  const std::size_t width = m_image.width_;
+  const std::size_t height = m_image.height_;
+  std::vector<AbstractEdge> edges;
+
+  // vertical borders, between clusters left and right
+  for (std::size_t x = m_cluster_size; x < width; x += m_cluster_size)
+    for (std::size_t y0 = 0; y0 < height; y0 += m_cluster_size)
+      addTransitions(x - 1, y0, 0, 1, std::min(m_cluster_size, height - y0), edges);
+
+  // horizontal borders, between clusters above and below
+  for (std::size_t y = m_cluster_size; y < height; y += m_cluster_size)
+    for (std::size_t x0 = 0; x0 < width; x0 += m_cluster_size)
+      addTransitions(x0, y - 1, 1, 0, std::min(m_cluster_size, width - x0), edges);
+
+  numberByCluster(edges);
+  for (std::size_t c = 0; c < m_cluster_nodes.size(); ++c)
+    connectCluster(c, edges);
+
+  buildAdjacency(edges);
+  buildLandmarks();
+}
+
+inline std::vector<size_t2> HierarchicalPathfinder::findPath(const size_t2& start, const size_t2& goal)
+{
+  std::vector<size_t2> path;
+  const std::size_t width = m_image.width_;
+  if (start.x >= width || start.y >= m_image.height_ || goal.x >= width || goal.y >= m_image.height_ ||
+      !walkable(start.x, start.y) || !walkable(goal.x, goal.y))
+    return path;
+
+  const std::size_t s = start.y * width + start.x;
+  const std::size_t g = goal.y * width + goal.x;
+  const std::size_t start_cluster = clusterOf(s);
+  const std::size_t goal_cluster = clusterOf(g);
+  const Box start_box = clusterBox(start_cluster);
+  const Box goal_box = clusterBox(goal_cluster);
+
+  std::vector<float> start_dist, goal_dist;
+  std::vector<std::size_t> start_prev, goal_prev;
+
+  if (start_cluster == goal_cluster) {
+    localSearch(start_box, s, g, start_dist, start_prev);
+    if (start_dist[localIndex(start_box, g)] != std::numeric_limits<float>::infinity()) {
+      path.push_back(start);
+      appendChain(start_box, start_prev, g, true, path);
+      return path;
+    }
+  }
+
+  // A* on the abstract graph, start and goal join it as two virtual nodes
+  const std::size_t n = m_nodes.size();
+  const std::size_t k = m_landmark_count;
+  const std::size_t s_id = n, g_id = n + 1;
+
+  QueryState& state = m_query;
+  state.begin(n + 2);
+  const unsigned generation = state.generation;
+  auto costOf = [&](std::size_t id) {
+    return state.labels[id].stamp == generation ? state.labels[id].cost : std::numeric_limits<float>::infinity();
+  };
+
+  // the goal is joined to the abstract nodes of its cluster, which have consecutive ids,
+  // and its landmark distances are the ones through them
+  const std::vector<std::size_t>& goal_nodes = m_cluster_nodes[goal_cluster];
+  const std::size_t goal_first = goal_nodes.empty() ? 0 : goal_nodes.front();
+  std::vector<float> to_goal(goal_nodes.size());
+  float goal_landmarks[detail::hpa_landmarks];
+  std::fill(goal_landmarks, goal_landmarks + k, std::numeric_limits<float>::infinity());
+  localSearch(goal_box, g, detail::hpa_npos, goal_dist, goal_prev);
+  for (std::size_t i = 0; i < goal_nodes.size(); ++i) {
+    to_goal[i] = goal_dist[localIndex(goal_box, m_nodes[goal_nodes[i]])];
+    for (std::size_t l = 0; l < k; ++l)
+      goal_landmarks[l] = std::min(goal_landmarks[l], m_landmark_dists[goal_nodes[i] * k + l] + to_goal[i]);
+  }
+  // the landmarks share one component: a node reaches all of them or none
+  const bool use_landmarks = k > 0 && goal_landmarks[0] != std::numeric_limits<float>::infinity();
+
+  // larger of the octile distance, from the cached coordinates, and the landmark bounds
+  // |d(L, goal) - d(L, v)|, infinite for a node the goal's component does not hold;
+  // weighted, the bound is not admissible any more
+  const float gx = float(goal.x), gy = float(goal.y);
+  auto estimate = [&](std::size_t id) {
+    if (id == g_id)
+      return 0.0f;
+    const float dx = std::abs(m_node_xs[id] - gx);
+    const float dy = std::abs(m_node_ys[id] - gy);
+    float h = std::max(dx, dy) + (std::sqrt(2.0f) - 1.0f) * std::min(dx, dy);
+    if (use_landmarks) {
+      const float* dists = m_landmark_dists.data() + id * k;
+      for (std::size_t l = 0; l < k; ++l) {
+        const float bound = std::abs(goal_landmarks[l] - dists[l]);
+        h = bound > h ? bound : h;
+      }
+    }
+    return h * detail::hpa_weight;
+  };
+
+  open_list q;
+  auto relax = [&](std::size_t u, std::size_t v, float w) {
+    const float alt = state.labels[u].cost + w;
+    if (alt < costOf(v)) {
+      Label& l = state.labels[v];
+      if (l.stamp != generation)
+        l.estimate = estimate(v);
+      l.cost = alt;
+      l.parent = u;
+      l.stamp = generation;
+      q.push(open_entry(alt + l.estimate, v));
+    }
+  };
+
+  state.labels[s_id].cost = 0.0f;
+  state.labels[s_id].parent = detail::hpa_npos;
+  state.labels[s_id].stamp = generation;
+  localSearch(start_box, s, detail::hpa_npos, start_dist, start_prev);
+  for (const std::size_t id : m_cluster_nodes[start_cluster])
+    relax(s_id, id, start_dist[localIndex(start_box, m_nodes[id])]);
+
+  while (!q.empty()) {
+    const open_entry top = q.top();
+    q.pop();
+    const std::size_t u = top.second;
+    const Label& l = state.labels[u];
+    if (top.first > l.cost + l.estimate + 1e-3f) // stale
+      continue;
+    if (u == g_id)
+      break;
+
+    for (std::size_t e = m_edge_offsets[u]; e < m_edge_offsets[u + 1]; ++e)
+      relax(u, m_edge_targets[e], m_edge_costs[e]);
+    if (u - goal_first < to_goal.size() && to_goal[u - goal_first] != std::numeric_limits<float>::infinity())
+      relax(u, g_id, to_goal[u - goal_first]);
+  }
+
+  if (costOf(g_id) == std::numeric_limits<float>::infinity())
+    return path;
+
+  std::vector<std::size_t> abstract_path; // abstract nodes only, without start and goal
+  for (std::size_t id = state.labels[g_id].parent; id != s_id; id = state.labels[id].parent)
+    abstract_path.push_back(id);
+  std::reverse(abstract_path.begin(), abstract_path.end());
+
+  // refinement: the endpoint searches for the first and last steps, the stored moves between
+  path.push_back(start);
+  appendChain(start_box, start_prev, m_nodes[abstract_path.front()], true, path);
+  for (std::size_t i = 0; i + 1 < abstract_path.size(); ++i) {
+    const std::size_t u = abstract_path[i], v = abstract_path[i + 1];
+    std::size_t best = detail::hpa_npos;
+    for (std::size_t e = m_edge_offsets[u]; e < m_edge_offsets[u + 1]; ++e)
+      if (m_edge_targets[e] == v && (best == detail::hpa_npos || m_edge_costs[e] < m_edge_costs[best]))
+        best = e;
+    appendEdge(u, v, best, path);
+  }
+  appendChain(goal_box, goal_prev, m_nodes[abstract_path.back()], false, path);
+  return path;
+}
+
+inline void HierarchicalPathfinder::QueryState::begin(std::size_t n)
+{
+  const Label unset = { 0.0f, 0.0f, 0, detail::hpa_npos };
+  if (labels.size() != n) {
+    labels.assign(n, unset);
+    generation = 0;
+  }
+
+  if (++generation == 0) { // wrapped around, the old stamps could match again
+    std::fill(labels.begin(), labels.end(), unset);
+    generation = 1;
+  }
+}
+
+inline float HierarchicalPathfinder::pathLength(const std::vector<size_t2>& path)
+{
+  float length = 0.0f;
+  for (std::size_t i = 0; i + 1 < path.size(); ++i)
+    length += (path[i].x != path[i + 1].x && path[i].y != path[i + 1].y) ? std::sqrt(2.0f) : 1.0f;
+
+  return length;
+}
+
+inline std::size_t HierarchicalPathfinder::clusterOf(std::size_t cell) const
+{
+  const std::size_t x = cell % m_image.width_;
+  const std::size_t y = cell / m_image.width_;
+  return (y / m_cluster_size) * m_clusters_x + x / m_cluster_size;
+}
+
+inline HierarchicalPathfinder::Box HierarchicalPathfinder::clusterBox(std::size_t cluster) const
+{
+  const std::size_t x0 = (cluster % m_clusters_x) * m_cluster_size;
+  const std::size_t y0 = (cluster / m_clusters_x) * m_cluster_size;
+  const Box b = { x0, y0, std::min(x0 + m_cluster_size, m_image.width_), std::min(y0 + m_cluster_size, m_image.height_) };
+  return b;
+}
+
+inline std::size_t HierarchicalPathfinder::localIndex(const Box& box, std::size_t cell) const
+{
+  return (cell / m_image.width_ - box.y0) * (box.x1 - box.x0) + cell % m_image.width_ - box.x0;
+}
+
+/// Border cells (x, y) + i * (dx, dy), i in [0, length), paired with their neighbour
+/// across the border: to the right for a vertical border (dy == 1), below otherwise.
+inline void HierarchicalPathfinder::addTransitions(std::size_t x, std::size_t y,
+                                                   std::size_t dx, std::size_t dy,
+                                                   std::size_t length,
+                                                   std::vector<AbstractEdge>& edges)
+{
+  const std::size_t width = m_image.width_;
+  const std::size_t across = dy == 1 ? 1 : width; // index offset to the other side
+
+  std::size_t i = 0;
+  while (i < length) {
+    const std::size_t cell = (y + i * dy) * width + x + i * dx;
+    if (!walkable(cell % width, cell / width) || !walkable((cell + across) % width, (cell + across) / width)) {
+      ++i;
+      continue;
+    }
+
+    std::size_t run = 1;
+    while (i + run < length) {
+      const std::size_t c = cell + run * (dy * width + dx);
+      if (!walkable(c % width, c / width) || !walkable((c + across) % width, (c + across) / width))
+        break;
+      ++run;
+    }
+
+    const std::size_t step = dy * width + dx;
+    if (run < 6) {
+      const std::size_t mid = cell + (run / 2) * step;
+      addTransition(mid, mid + across, edges);
+    } else {
+      addTransition(cell, cell + across, edges);
+      const std::size_t last = cell + (run - 1) * step;
+      addTransition(last, last + across, edges);
+    }
+    i += run;
+  }
+}
+
+inline void HierarchicalPathfinder::addTransition(std::size_t a, std::size_t b, std::vector<AbstractEdge>& edges)
+{
+  std::size_t ids[2];
+  for (int i = 0; i < 2; ++i) {
+    const std::size_t cell = i == 0 ? a : b;
+    std::vector<std::size_t>& cluster_nodes = m_cluster_nodes[clusterOf(cell)];
+    const auto it = std::find_if(cluster_nodes.begin(), cluster_nodes.end(),
+                                 [this, cell](std::size_t id) { return m_nodes[id] == cell; });
+    if (it != cluster_nodes.end()) {
+      ids[i] = *it;
+    } else {
+      ids[i] = m_nodes.size();
+      m_nodes.push_back(cell);
+      cluster_nodes.push_back(ids[i]);
+    }
+  }
+  const AbstractEdge e = { ids[0], ids[1], 1.0f, detail::hpa_npos };
+  edges.push_back(e);
+}
+
+/// Renumbers the nodes cluster by cluster, the clusters in Z-order (Morton code).
+inline void HierarchicalPathfinder::numberByCluster(std::vector<AbstractEdge>& edges)
+{
+  std::vector<std::pair<std::size_t, std::size_t> > order(m_cluster_nodes.size()); // Morton code, cluster
+  for (std::size_t c = 0; c < order.size(); ++c) {
+    std::size_t code = 0;
+    const std::size_t cx = c % m_clusters_x, cy = c / m_clusters_x;
+    for (std::size_t bit = 0; bit < 32; ++bit)
+      code |= ((cx >> bit) & 1) << (2 * bit) | ((cy >> bit) & 1) << (2 * bit + 1);
+    order[c] = std::make_pair(code, c);
+  }
+  std::sort(order.begin(), order.end());
+
+  std::vector<std::size_t> new_ids(m_nodes.size());
+  std::vector<std::size_t> nodes;
+  nodes.reserve(m_nodes.size());
+  for (const auto& o : order)
+    for (std::size_t& id : m_cluster_nodes[o.second]) {
+      new_ids[id] = nodes.size();
+      nodes.push_back(m_nodes[id]);
+      id = new_ids[id];
+    }
+  m_nodes.swap(nodes);
+
+  for (AbstractEdge& e : edges) {
+    e.a = new_ids[e.a];
+    e.b = new_ids[e.b];
+  }
+}
+
+inline void HierarchicalPathfinder::connectCluster(std::size_t cluster, std::vector<AbstractEdge>& edges)
+{
+  const std::vector<std::size_t>& cluster_nodes = m_cluster_nodes[cluster];
+  const Box box = clusterBox(cluster);
+  const std::size_t width = m_image.width_;
+
+  std::vector<float> dist;
+  std::vector<std::size_t> prev;
+  for (std::size_t i = 0; i < cluster_nodes.size(); ++i) {
+    const std::size_t from = m_nodes[cluster_nodes[i]];
+    localSearch(box, from, detail::hpa_npos, dist, prev);
+    for (std::size_t j = i + 1; j < cluster_nodes.size(); ++j) {
+      const std::size_t to = m_nodes[cluster_nodes[j]];
+      const float d = dist[localIndex(box, to)];
+      if (d == std::numeric_limits<float>::infinity())
+        continue;
+
+      // the ids ascend, the moves run from the lower id to the higher one
+      const std::size_t first = m_path_moves.size();
+      for (std::size_t c = to; c != from; c = prev[localIndex(box, c)]) {
+        const std::size_t p = prev[localIndex(box, c)];
+        m_path_moves.push_back(detail::hpaMove(int(c % width) - int(p % width), int(c / width) - int(p / width)));
+      }
+      std::reverse(m_path_moves.begin() + first, m_path_moves.end());
+
+      const AbstractEdge e = { cluster_nodes[i], cluster_nodes[j], d, m_path_offsets.size() - 1 };
+      edges.push_back(e);
+      m_path_offsets.push_back(m_path_moves.size());
+    }
+  }
+}
+
+/// The inspection graph and the flat copies of it the queries read.
+inline void HierarchicalPathfinder::buildAdjacency(const std::vector<AbstractEdge>& edges)
+{
+  const std::size_t n = m_nodes.size();
+  m_node_xs.resize(n);
+  m_node_ys.resize(n);
+  for (std::size_t id = 0; id < n; ++id) {
+    m_node_xs[id] = float(m_nodes[id] % m_image.width_);
+    m_node_ys[id] = float(m_nodes[id] / m_image.width_);
+    m_graph.addVertex(id);
+  }
+
+  m_edge_offsets.assign(n + 1, 0);
+  for (const AbstractEdge& e : edges) {
+    m_graph.addEdge(e.a, e.b, e.cost);
+    ++m_edge_offsets[e.a + 1];
+    ++m_edge_offsets[e.b + 1];
+  }
+  for (std::size_t id = 0; id < n; ++id)
+    m_edge_offsets[id + 1] += m_edge_offsets[id];
+
+  m_edge_targets.resize(m_edge_offsets[n]);
+  m_edge_costs.resize(m_edge_offsets[n]);
+  m_edge_paths.resize(m_edge_offsets[n]);
+  std::vector<std::size_t> fill(m_edge_offsets.begin(), m_edge_offsets.end() - 1);
+  for (const AbstractEdge& e : edges)
+    for (int i = 0; i < 2; ++i) {
+      const std::size_t slot = fill[i == 0 ? e.a : e.b]++;
+      m_edge_targets[slot] = i == 0 ? e.b : e.a;
+      m_edge_costs[slot] = e.cost;
+      m_edge_paths[slot] = e.path;
+    }
+}
+
+/// Farthest first: the first landmark is the node farthest from a node of the largest
+/// component, every next one the node farthest from all landmarks picked so far.
+inline void HierarchicalPathfinder::buildLandmarks()
+{
+  const std::size_t n = m_nodes.size();
+  m_landmark_count = std::min(detail::hpa_landmarks, n);
+  m_landmark_dists.assign(n * m_landmark_count, std::numeric_limits<float>::infinity());
+  if (n == 0)
+    return;
+
+  // components, to not spend the landmarks on an island
+  std::vector<std::size_t> component(n, detail::hpa_npos);
+  std::size_t root = 0, root_size = 0;
+  std::vector<std::size_t> stack;
+  for (std::size_t id = 0; id < n; ++id) {
+    if (component[id] != detail::hpa_npos)
+      continue;
+    std::size_t size = 0;
+    component[id] = id;
+    stack.push_back(id);
+    while (!stack.empty()) {
+      const std::size_t u = stack.back();
+      stack.pop_back();
+      ++size;
+      for (std::size_t e = m_edge_offsets[u]; e < m_edge_offsets[u + 1]; ++e)
+        if (component[m_edge_targets[e]] == detail::hpa_npos) {
+          component[m_edge_targets[e]] = id;
+          stack.push_back(m_edge_targets[e]);
+        }
+    }
+    if (size > root_size) {
+      root = id;
+      root_size = size;
+    }
+  }
+
+  std::vector<float> dist;
+  std::vector<float> nearest(n, std::numeric_limits<float>::infinity()); // to the picked landmarks
+  abstractSearch(root, dist);
+  for (std::size_t l = 0; l < m_landmark_count; ++l) {
+    std::size_t landmark = root;
+    for (std::size_t id = 0; id < n; ++id)
+      if (dist[id] != std::numeric_limits<float>::infinity() && dist[id] > dist[landmark])
+        landmark = id;
+
+    abstractSearch(landmark, dist);
+    for (std::size_t id = 0; id < n; ++id) {
+      m_landmark_dists[id * m_landmark_count + l] = dist[id];
+      nearest[id] = std::min(nearest[id], dist[id]);
+    }
+    dist = nearest;
+  }
+}
+
+inline void HierarchicalPathfinder::localSearch(const Box& box, std::size_t source, std::size_t target,
+                                                std::vector<float>& dist, std::vector<std::size_t>& prev) const
+{
+  const std::size_t width = m_image.width_;
+  const std::size_t box_width = box.x1 - box.x0;
+  const std::size_t box_height = box.y1 - box.y0;
+  dist.assign(box_width * box_height, std::numeric_limits<float>::infinity());
+  prev.assign(box_width * box_height, std::numeric_limits<std::size_t>::max());
+
+  auto local = [&](std::size_t cell) { return localIndex(box, cell); };
+
+  const bool directed = target != detail::hpa_npos;
+  const std::size_t tx = target % width, ty = target / width;
+  auto heuristic = [&](std::size_t x, std::size_t y) {
+    if (!directed)
+      return 0.0f;
+    const float dx = x > tx ? x - tx : tx - x;
+    const float dy = y > ty ? y - ty : ty - y;
+    return std::max(dx, dy) + (std::sqrt(2.0f) - 1.0f) * std::min(dx, dy);
+  };
+
+  open_list q;
+  dist[local(source)] = 0.0f;
+  q.push(open_entry(heuristic(source % width, source / width), source));
+  while (!q.empty()) {
+    const std::size_t u = q.top().second;
+    const std::size_t ux = u % width, uy = u / width;
+    const float du = dist[local(u)];
+    if (q.top().first > du + heuristic(ux, uy) + 1e-3f) { // stale
+      q.pop();
+      continue;
+    }
+    q.pop();
+    if (u == target)
+      return;
+
+    for (int dy = -1; dy <= 1; ++dy)
+      for (int dx = -1; dx <= 1; ++dx) {
+        if (dx == 0 && dy == 0)
+          continue;
+        const std::size_t vx = ux + dx, vy = uy + dy; // wraps around below 0, fails the box test
+        if (vx < box.x0 || vx >= box.x1 || vy < box.y0 || vy >= box.y1 || !walkable(vx, vy))
+          continue;
+        if (dx != 0 && dy != 0 && (!walkable(vx, uy) || !walkable(ux, vy))) // no corner cutting
+          continue;
+
+        const float alt = du + ((dx != 0 && dy != 0) ? std::sqrt(2.0f) : 1.0f);
+        const std::size_t v = vy * width + vx;
+        if (alt < dist[local(v)]) {
+          dist[local(v)] = alt;
+          prev[local(v)] = u;
+          q.push(open_entry(alt + heuristic(vx, vy), v));
+        }
+      }
+  }
+}
+
+inline void HierarchicalPathfinder::abstractSearch(std::size_t source, std::vector<float>& dist) const
+{
+  dist.assign(m_nodes.size(), std::numeric_limits<float>::infinity());
+
+  open_list q;
+  dist[source] = 0.0f;
+  q.push(open_entry(0.0f, source));
+  while (!q.empty()) {
+    const open_entry top = q.top();
+    q.pop();
+    const std::size_t u = top.second;
+    if (top.first > dist[u]) // stale
+      continue;
+
+    for (std::size_t e = m_edge_offsets[u]; e < m_edge_offsets[u + 1]; ++e) {
+      const float alt = dist[u] + m_edge_costs[e];
+      if (alt < dist[m_edge_targets[e]]) {
+        dist[m_edge_targets[e]] = alt;
+        q.push(open_entry(alt, m_edge_targets[e]));
+      }
+    }
+  }
+}
+
+inline void HierarchicalPathfinder::appendChain(const Box& box, const std::vector<std::size_t>& prev,
+                                                std::size_t cell, bool reversed,
+                                                std::vector<size_t2>& path) const
+{
+  const std::size_t width = m_image.width_;
+  const std::size_t first = path.size();
+  for (std::size_t c = reversed ? cell : prev[localIndex(box, cell)];
+       c != detail::hpa_npos;
+       c = prev[localIndex(box, c)])
+    path.push_back(size_t2(c % width, c / width));
+
+  if (reversed) {
+    path.pop_back(); // the root
+    std::reverse(path.begin() + first, path.end());
+  }
+}
+
+inline void HierarchicalPathfinder::appendEdge(std::size_t u, std::size_t v, std::size_t e,
+                                               std::vector<size_t2>& path) const
+{
+  const std::size_t width = m_image.width_;
+  const std::size_t p = m_edge_paths[e];
+  if (p == detail::hpa_npos) { // transition between neighbouring cells
+    path.push_back(cellOfNode(v));
+    return;
+  }
+
+  std::size_t x = m_nodes[u] % width, y = m_nodes[u] / width;
+  if (u < v) {
+    for (std::size_t i = m_path_offsets[p]; i < m_path_offsets[p + 1]; ++i) {
+      x += detail::hpa_dx[m_path_moves[i]];
+      y += detail::hpa_dy[m_path_moves[i]];
+      path.push_back(size_t2(x, y));
+    }
+  } else {
+    for (std::size_t i = m_path_offsets[p + 1]; i-- > m_path_offsets[p]; ) {
+      x += detail::hpa_dx[7 - m_path_moves[i]];
+      y += detail::hpa_dy[7 - m_path_moves[i]];
+      path.push_back(size_t2(x, y));
+    }
+  }
+}
+
+#endif // HIERARCHICAL_PATHFINDING_HPP
@@ -0,0 +1,350 @@
+#ifndef INCREMENTAL_MARCHING_SQUARES_HPP
+#define INCREMENTAL_MARCHING_SQUARES_HPP
+
+#include "graph.hpp"
+#include "marching_squares.hpp"
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <algorithm>
+#include <utility>
+
+/**
+  Keeps the contour of a changing \ref ImageMatrix, see \ref marchingSquares.
+
+  The segments are maximal runs along a row (horizontal) or a column (vertical).
+  Changing a cell changes the 2x2 masks of at most 4 cells, which lie on 2 rows
+  and 2 columns. Only the segments of those lines that contain one of the changed
+  cells, as start, inner cell or end, can change, so just these are looked up,
+  re-traced and compared. Re-tracing classifies the changed positions only and
+  follows the stored runs everywhere else, its cost does not grow with the length
+  of the runs.
+
+  The edits come back as a \ref ContourDiff, ready for \ref applyContourDiff.
+*/
+
+struct ContourDiff {
+  typedef std::pair<size_t2, size_t2> segment;
+
+  std::vector<segment> added;
+  std::vector<segment> removed; // a segment removed and added back by the same edit is in neither
+};
+
+
+class IncrementalMarchingSquares {
+
+public:
+
+  typedef std::pair<size_t2, size_t2> segment;
+  typedef std::pair<size_t2, ImageMatrix::CellType> cell_change;
+
+  explicit IncrementalMarchingSquares(const ImageMatrix& image_matrix);
+  explicit IncrementalMarchingSquares(const SolidMask& solid_mask);
+
+  ContourDiff setCells(const std::vector<cell_change>& changes);
+  ContourDiff setCell(const size_t2& cell, ImageMatrix::CellType type) { return setCells(std::vector<cell_change>(1, cell_change(cell, type))); }
+
+  /// All current segments, in the order marchingSquares gives them.
+  std::vector<segment> segments() const;
+  std::size_t numberOfSegments() const;
+  const SolidMask& solidMask() const { return m_mask; }
+
+private:
+
+  // start -> end of the runs, of a row for horizontal and of a column for vertical segments
+  typedef std::map<std::size_t, std::size_t> line_segments;
+
+  enum Class { NONE, START, CONTINUATION };
+
+  void build();
+  Class classify(bool horizontal, std::size_t x, std::size_t y) const;
+
+  /// A line being re-traced: only the changed positions are classified again, every other one
+  /// keeps the class the stored runs and the lead give it.
+  struct LineEdit {
+    bool horizontal;
+    std::size_t line;
+    const line_segments& stored;
+    std::size_t lead;
+    const std::set<std::size_t>& changed;
+  };
+
+  Class classAt(const LineEdit& edit, std::size_t q) const;
+  /// First position from q on that is no continuation, whole unchanged stretches are skipped.
+  std::size_t continuationEnd(const LineEdit& edit, std::size_t q) const;
+  /// Runs of the line containing position p after the edit: starting at p, or running into p from before.
+  void runsThrough(const LineEdit& edit, std::size_t p, std::set<std::pair<std::size_t, std::size_t> >& runs) const;
+  void storedRunsThrough(const line_segments& stored, std::size_t p, std::set<std::pair<std::size_t, std::size_t> >& runs) const;
+
+  SolidMask m_mask;
+  std::vector<line_segments> m_rows;    // horizontal segments per y
+  std::vector<line_segments> m_columns; // vertical segments per x
+  // per line, the end of the continuations running in from position 0: they have no start,
+  // so marchingSquares emits no run for them
+  std::vector<std::size_t> m_row_leads;
+  std::vector<std::size_t> m_column_leads;
+};
+
+
+/// Applies a diff to the graph of the contour: vertices are the segment ends,
+/// V constructible from the two coordinates. Vertices left without edges are removed.
+/// Every edge of the contour graph has its back edge, so no list refers to such a
+/// vertex and its entry is erased alone, without the scan of \ref Graph::removeVertex.
+template <typename V>
+void applyContourDiff(Graph<V>& graph, const ContourDiff& diff)
+{
+  for (const auto& s : diff.removed) {
+    const V a(s.first.x, s.first.y);
+    const V b(s.second.x, s.second.y);
+    graph.removeEdge(a, b);
+    for (const V& v : {a, b}) {
+      const auto it = graph.m_vertices.find(v);
+      if (it != graph.m_vertices.end() && it->second.empty())
+        graph.m_vertices.erase(it);
+    }
+  }
+
+  for (const auto& s : diff.added)
+    graph.addEdge(V(s.first.x, s.first.y), V(s.second.x, s.second.y));
+}
+
+
+// IncrementalMarchingSquares implementation
+
+inline IncrementalMarchingSquares::IncrementalMarchingSquares(const ImageMatrix& image_matrix)
+  : m_mask(image_matrix)
+  , m_rows(image_matrix.height_)
+  , m_columns(image_matrix.width_)
+  , m_row_leads(image_matrix.height_, 1)
+  , m_column_leads(image_matrix.width_, 1)
+{
+  build();
+}
+
+inline IncrementalMarchingSquares::IncrementalMarchingSquares(const SolidMask& solid_mask)
+  : m_mask(solid_mask)
+  , m_rows(solid_mask.height_)
+  , m_columns(solid_mask.width_)
+  , m_row_leads(solid_mask.height_, 1)
+  , m_column_leads(solid_mask.width_, 1)
+{
+  build();
+}
+
+inline ContourDiff IncrementalMarchingSquares::setCells(const std::vector<cell_change>& changes)
+{
+  const std::size_t width = m_mask.width_;
+  const std::size_t height = m_mask.height_;
+
+  // changed mask positions per line, a mask at (x, y) covers cells x-1..x, y-1..y
+  std::map<std::size_t, std::set<std::size_t> > rows, columns;
+  for (const auto& c : changes) {
+    const std::size_t x = c.first.x, y = c.first.y;
+    const bool solid = c.second != ImageMatrix::FREE;
+    if (x >= width || y >= height || m_mask.solid(x, y) == solid)
+      continue;
+
+    m_mask.set(x, y, solid);
+    for (std::size_t my = std::max<std::size_t>(y, 1); my <= y + 1 && my < height; ++my)
+      for (std::size_t mx = std::max<std::size_t>(x, 1); mx <= x + 1 && mx < width; ++mx) {
+        rows[my].insert(mx);
+        columns[mx].insert(my);
+      }
+  }
+
+  ContourDiff diff;
+  typedef std::set<std::pair<std::size_t, std::size_t> > run_set;
+  for (int pass = 0; pass < 2; ++pass) {
+    const bool horizontal = pass == 0;
+    for (const auto& line : horizontal ? rows : columns) {
+      line_segments& stored = horizontal ? m_rows[line.first] : m_columns[line.first];
+      std::size_t& lead = horizontal ? m_row_leads[line.first] : m_column_leads[line.first];
+      const LineEdit edit = { horizontal, line.first, stored, lead, line.second };
+
+      run_set before, after;
+      for (const std::size_t p : line.second) {
+        storedRunsThrough(stored, p, before);
+        runsThrough(edit, p, after);
+      }
+      const std::size_t new_lead = continuationEnd(edit, 1);
+
+      auto toSegment = [horizontal, &line](const std::pair<std::size_t, std::size_t>& r) {
+        return horizontal ? segment(size_t2(r.first, line.first), size_t2(r.second, line.first))
+                          : segment(size_t2(line.first, r.first), size_t2(line.first, r.second));
+      };
+
+      for (const auto& r : before)
+        if (after.find(r) == after.end()) {
+          stored.erase(r.first);
+          diff.removed.push_back(toSegment(r));
+        }
+      for (const auto& r : after)
+        if (before.find(r) == before.end()) {
+          stored[r.first] = r.second;
+          diff.added.push_back(toSegment(r));
+        }
+      lead = new_lead;
+    }
+  }
+
+  return diff;
+}
+
+inline std::vector<IncrementalMarchingSquares::segment> IncrementalMarchingSquares::segments() const
+{
+  // (y, x, vertical) is the emission order of marchingSquares
+  std::vector<std::pair<std::pair<std::size_t, std::size_t>, std::pair<int, std::size_t> > > keys;
+  keys.reserve(numberOfSegments());
+  for (std::size_t y = 0; y < m_rows.size(); ++y)
+    for (const auto& s : m_rows[y])
+      keys.push_back(std::make_pair(std::make_pair(y, s.first), std::make_pair(0, s.second)));
+  for (std::size_t x = 0; x < m_columns.size(); ++x)
+    for (const auto& s : m_columns[x])
+      keys.push_back(std::make_pair(std::make_pair(s.first, x), std::make_pair(1, s.second)));
+  std::sort(keys.begin(), keys.end());
+
+  std::vector<segment> retval;
+  retval.reserve(keys.size());
+  for (const auto& k : keys) {
+    const std::size_t y = k.first.first, x = k.first.second;
+    retval.push_back(k.second.first == 0 ? segment(size_t2(x, y), size_t2(k.second.second, y))
+                                         : segment(size_t2(x, y), size_t2(x, k.second.second)));
+  }
+  return retval;
+}
+
+inline std::size_t IncrementalMarchingSquares::numberOfSegments() const
+{
+  std::size_t n = 0;
+  for (const auto& r : m_rows)
+    n += r.size();
+  for (const auto& c : m_columns)
+    n += c.size();
+
+  return n;
+}
+
+inline void IncrementalMarchingSquares::build()
+{
+  for (const auto& s : marchingSquares(m_mask)) {
+    if (s.first.y == s.second.y)
+      m_rows[s.first.y].emplace(s.first.x, s.second.x);
+    else
+      m_columns[s.first.x].emplace(s.first.y, s.second.y);
+  }
+
+  for (std::size_t y = 1; y < m_mask.height_; ++y)
+    while (m_row_leads[y] < m_mask.width_ && classify(true, m_row_leads[y], y) == CONTINUATION)
+      ++m_row_leads[y];
+  for (std::size_t x = 1; x < m_mask.width_; ++x)
+    while (m_column_leads[x] < m_mask.height_ && classify(false, x, m_column_leads[x]) == CONTINUATION)
+      ++m_column_leads[x];
+}
+
+/// Same rule as detail::maskPlanes, for a single cell.
+inline IncrementalMarchingSquares::Class IncrementalMarchingSquares::classify(bool horizontal, std::size_t x, std::size_t y) const
+{
+  const bool tl = m_mask.solid(x - 1, y - 1), t = m_mask.solid(x, y - 1);
+  const bool l = m_mask.solid(x - 1, y),      c = m_mask.solid(x, y);
+  const bool h = t != c;
+  const bool v = l != c;
+
+  if (horizontal ? !h : !v)
+    return NONE;
+
+  const bool continues = horizontal ? (tl == t && !v) : (tl == l && !h);
+  return continues ? CONTINUATION : START;
+}
+
+inline IncrementalMarchingSquares::Class IncrementalMarchingSquares::classAt(const LineEdit& edit, std::size_t q) const
+{
+  if (edit.changed.count(q))
+    return edit.horizontal ? classify(true, q, edit.line) : classify(false, edit.line, q);
+
+  auto it = edit.stored.upper_bound(q);
+  if (it != edit.stored.begin() && q < (--it)->second)
+    return it->first == q ? START : CONTINUATION;
+  return q < edit.lead ? CONTINUATION : NONE;
+}
+
+inline std::size_t IncrementalMarchingSquares::continuationEnd(const LineEdit& edit, std::size_t q) const
+{
+  const std::size_t length = edit.horizontal ? m_mask.width_ : m_mask.height_;
+  while (q < length) {
+    if (edit.changed.count(q)) {
+      if (classAt(edit, q) != CONTINUATION)
+        break;
+      ++q;
+      continue;
+    }
+
+    // an unchanged continuation goes on to the end of its stored run or of the lead
+    std::size_t stretch_end = edit.lead;
+    auto it = edit.stored.upper_bound(q);
+    if (it != edit.stored.begin() && q < (--it)->second) {
+      if (it->first == q)
+        break;
+      stretch_end = it->second;
+    }
+    if (q >= stretch_end)
+      break;
+
+    const auto c = edit.changed.lower_bound(q);
+    q = c != edit.changed.end() && *c < stretch_end ? *c : stretch_end;
+  }
+  return std::min(q, length);
+}
+
+inline void IncrementalMarchingSquares::runsThrough(const LineEdit& edit, std::size_t p,
+                                                    std::set<std::pair<std::size_t, std::size_t> >& runs) const
+{
+  const Class at_p = classAt(edit, p);
+  if (at_p == START)
+    runs.insert(std::make_pair(p, continuationEnd(edit, p + 1)));
+
+  // the run holding p as inner cell or as its end: back to its start, an unchanged continuation
+  // goes back to the start of its stored run or of the lead, or to the previous changed position
+  std::size_t q = at_p == CONTINUATION ? p : p - 1;
+  if (q < 1)
+    return;
+
+  Class at_q = q == p ? at_p : classAt(edit, q);
+  while (at_q == CONTINUATION && q > 1) {
+    if (edit.changed.count(q)) {
+      at_q = classAt(edit, --q);
+      continue;
+    }
+    std::size_t stretch_start = 1;
+    auto it = edit.stored.upper_bound(q);
+    if (it != edit.stored.begin() && q < (--it)->second)
+      stretch_start = it->first;
+    auto c = edit.changed.lower_bound(q);
+    q = c != edit.changed.begin() && *--c >= stretch_start ? *c : stretch_start;
+    at_q = classAt(edit, q);
+  }
+
+  if (at_q == START)
+    runs.insert(std::make_pair(q, continuationEnd(edit, q + 1)));
+}
+
+inline void IncrementalMarchingSquares::storedRunsThrough(const line_segments& stored, std::size_t p,
+                                                          std::set<std::pair<std::size_t, std::size_t> >& runs) const
+{
+  auto it = stored.upper_bound(p);
+  if (it == stored.begin())
+    return;
+
+  --it;
+  if (it->second >= p)
+    runs.insert(*it);
+
+  if (it->first == p && it != stored.begin()) { // p may also end the run before
+    --it;
+    if (it->second == p)
+      runs.insert(*it);
+  }
+}
+
+#endif // INCREMENTAL_MARCHING_SQUARES_HPP
@@ -0,0 +1,376 @@
+#ifndef JUMP_POINT_SEARCH_HPP
+#define JUMP_POINT_SEARCH_HPP
+
+#include "marching_squares.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+/**
+  Jump Point Search (Harabor & Grastien) directly on an \ref ImageMatrix.
+
+  Same grid model as \ref HierarchicalPathfinder: FREE cells are walkable,
+  8-connected, straight steps cost 1, diagonal ones sqrt(2), no cutting of
+  blocked corners. No graph is built: the search only ever stores the few jump
+  points it expands.
+
+  - JumpPointSearch scans the grid at query time, no memory per cell.
+  - JumpPointSearchPlus (JPS+, Rabin) precomputes for every cell and each of the
+    8 directions the distance to the next jump point or wall, 16 bytes per cell,
+    so a query never scans.
+
+  Both return the jump points of an optimal path, start and goal included:
+  consecutive ones are on a common row, column or diagonal, see \ref expandJumpPath.
+*/
+
+
+namespace detail {
+
+// N, NE, E, SE, S, SW, W, NW: even directions are straight, odd ones diagonal
+const int jps_dx[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+const int jps_dy[8] = { -1, -1, 0, 1, 1, 1, 0, -1 };
+
+inline int jpsDirection(std::ptrdiff_t dx, std::ptrdiff_t dy)
+{
+  const int sx = (dx > 0) - (dx < 0);
+  const int sy = (dy > 0) - (dy < 0);
+  for (int d = 0; d < 8; ++d)
+    if (jps_dx[d] == sx && jps_dy[d] == sy)
+      return d;
+
+  return -1;
+}
+
+/// Calls f(d) for the directions worth searching after arriving by travel
+/// direction dir, all of them at the start (dir < 0).
+template <typename F>
+void jpsPrunedDirections(int dir, F f)
+{
+  if (dir < 0) {
+    for (int d = 0; d < 8; ++d)
+      f(d);
+  } else if (dir % 2 == 0) { // straight: ahead, the two diagonals and the two sides
+    for (int o : { 0, 1, 7, 2, 6 })
+      f((dir + o) % 8);
+  } else {                   // diagonal: ahead and its two components
+    for (int o : { 0, 1, 7 })
+      f((dir + o) % 8);
+  }
+}
+
+inline float jpsOctile(std::ptrdiff_t dx, std::ptrdiff_t dy)
+{
+  const float ax = std::abs(dx), ay = std::abs(dy);
+  return std::max(ax, ay) + (std::sqrt(2.0f) - 1.0f) * std::min(ax, ay);
+}
+
+/// A* over jump points. successors(x, y, dir, out) appends to out every jump point
+/// reachable from (x, y), arrived at by travel direction dir, in a straight or diagonal line.
+template <typename Successors>
+std::vector<size_t2> jpsAStar(const ImageMatrix& m, const size_t2& start, const size_t2& goal, Successors successors)
+{
+  std::vector<size_t2> path;
+  const std::size_t width = m.width_;
+  if (start.x >= width || start.y >= m.height_ || goal.x >= width || goal.y >= m.height_ ||
+      m.cells_[start.y * width + start.x] != ImageMatrix::FREE ||
+      m.cells_[goal.y * width + goal.x] != ImageMatrix::FREE)
+    return path;
+
+  const std::size_t s = start.y * width + start.x;
+  const std::size_t g = goal.y * width + goal.x;
+  auto heuristic = [&](std::size_t x, std::size_t y) {
+    return jpsOctile(std::ptrdiff_t(x) - std::ptrdiff_t(goal.x), std::ptrdiff_t(y) - std::ptrdiff_t(goal.y));
+  };
+
+  // binary heap with lazy deletion: stale entries are skipped when popped
+  typedef std::pair<float, std::size_t> open_entry;
+  std::priority_queue<open_entry, std::vector<open_entry>, std::greater<open_entry> > q;
+  std::unordered_map<std::size_t, std::pair<float, std::size_t> > dist_prev;
+
+  std::vector<std::pair<std::size_t, std::size_t> > next;
+  dist_prev.emplace(s, std::make_pair(0.0f, s));
+  q.push(open_entry(heuristic(start.x, start.y), s));
+  while (!q.empty()) {
+    const open_entry top = q.top();
+    q.pop();
+    const std::size_t u = top.second;
+    const std::size_t ux = u % width, uy = u / width;
+    const std::pair<float, std::size_t> u_dist_prev = dist_prev.at(u);
+    if (top.first > u_dist_prev.first + heuristic(ux, uy) + 1e-3f) // stale
+      continue;
+
+    if (u == g)
+      break;
+
+    const std::size_t p = u_dist_prev.second;
+    const int dir = u == s ? -1 : jpsDirection(std::ptrdiff_t(ux) - std::ptrdiff_t(p % width),
+                                               std::ptrdiff_t(uy) - std::ptrdiff_t(p / width));
+    next.clear();
+    successors(ux, uy, dir, next);
+    for (const auto& n : next) {
+      const std::size_t vx = n.first, vy = n.second;
+      const std::size_t v = vy * width + vx;
+      const float alt = u_dist_prev.first + jpsOctile(std::ptrdiff_t(vx) - std::ptrdiff_t(ux),
+                                                      std::ptrdiff_t(vy) - std::ptrdiff_t(uy));
+      auto it = dist_prev.find(v);
+      if (it == dist_prev.end() || alt < it->second.first) {
+        dist_prev[v] = std::make_pair(alt, u);
+        q.push(open_entry(alt + heuristic(vx, vy), v));
+      }
+    }
+  }
+
+  if (dist_prev.find(g) == dist_prev.end())
+    return path;
+
+  for (std::size_t n = g; n != s; n = dist_prev.at(n).second)
+    path.push_back(size_t2(n % width, n / width));
+  path.push_back(start);
+
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+} // detail namespace
+
+
+/// Every cell of a path given by its jump points.
+inline std::vector<size_t2> expandJumpPath(const std::vector<size_t2>& jump_points)
+{
+  std::vector<size_t2> cells;
+  if (jump_points.empty())
+    return cells;
+
+  cells.push_back(jump_points.front());
+  for (std::size_t i = 1; i < jump_points.size(); ++i) {
+    const int dir = detail::jpsDirection(std::ptrdiff_t(jump_points[i].x) - std::ptrdiff_t(jump_points[i - 1].x),
+                                         std::ptrdiff_t(jump_points[i].y) - std::ptrdiff_t(jump_points[i - 1].y));
+    size_t2 c = jump_points[i - 1];
+    while (!(c == jump_points[i])) {
+      c.x += detail::jps_dx[dir];
+      c.y += detail::jps_dy[dir];
+      cells.push_back(c);
+    }
+  }
+  return cells;
+}
+
+
+class JumpPointSearch {
+
+public:
+
+  /// The image is referenced, not copied, and shall outlive the search.
+  explicit JumpPointSearch(const ImageMatrix& image_matrix) : m_image(image_matrix) {}
+  explicit JumpPointSearch(ImageMatrix&&) = delete;
+
+  /// Jump points from start to goal, empty if there is no path.
+  std::vector<size_t2> findPath(const size_t2& start, const size_t2& goal) const;
+
+private:
+
+  bool walkable(std::ptrdiff_t x, std::ptrdiff_t y) const;
+
+  /// Scans from (x, y) in direction dir, true and the jump point in (jx, jy) if one is found.
+  bool jump(std::ptrdiff_t x, std::ptrdiff_t y, int dir, const size_t2& goal,
+            std::ptrdiff_t& jx, std::ptrdiff_t& jy) const;
+
+  const ImageMatrix& m_image;
+};
+
+
+class JumpPointSearchPlus {
+
+public:
+
+  /// Precomputes the jump distances, throws std::length_error for images with a side over 32767.
+  /// The image is referenced, not copied, and shall outlive the search.
+  explicit JumpPointSearchPlus(const ImageMatrix& image_matrix);
+  explicit JumpPointSearchPlus(ImageMatrix&&) = delete;
+
+  /// Jump points from start to goal, empty if there is no path.
+  std::vector<size_t2> findPath(const size_t2& start, const size_t2& goal) const;
+
+  /// Steps from (x, y) in direction dir (N, NE, E, ... NW as 0..7) to the next jump
+  /// point if positive, to the last free cell before a wall negated otherwise.
+  int jumpDistance(std::size_t x, std::size_t y, int dir) const { return m_distances[(y * m_image.width_ + x) * 8 + dir]; }
+
+private:
+
+  bool walkable(std::ptrdiff_t x, std::ptrdiff_t y) const;
+  bool canStep(std::ptrdiff_t x, std::ptrdiff_t y, int dir) const;
+  bool forced(std::ptrdiff_t x, std::ptrdiff_t y, int dir) const;
+
+  const ImageMatrix& m_image;
+  std::vector<std::int16_t> m_distances; // 8 per cell
+};
+
+
+// JumpPointSearch implementation
+
+inline std::vector<size_t2> JumpPointSearch::findPath(const size_t2& start, const size_t2& goal) const
+{
+  return detail::jpsAStar(m_image, start, goal, [&](std::size_t x, std::size_t y, int dir,
+                                                    std::vector<std::pair<std::size_t, std::size_t> >& out) {
+    detail::jpsPrunedDirections(dir, [&](int d) {
+      std::ptrdiff_t jx, jy;
+      if (jump(x, y, d, goal, jx, jy))
+        out.push_back(std::make_pair(jx, jy));
+    });
+  });
+}
+
+inline bool JumpPointSearch::walkable(std::ptrdiff_t x, std::ptrdiff_t y) const
+{
+  return x >= 0 && y >= 0 && std::size_t(x) < m_image.width_ && std::size_t(y) < m_image.height_ &&
+         m_image.cells_[y * m_image.width_ + x] == ImageMatrix::FREE;
+}
+
+inline bool JumpPointSearch::jump(std::ptrdiff_t x, std::ptrdiff_t y, int dir, const size_t2& goal,
+                                  std::ptrdiff_t& jx, std::ptrdiff_t& jy) const
+{
+  const int dx = detail::jps_dx[dir];
+  const int dy = detail::jps_dy[dir];
+  while (true) {
+    if (!walkable(x + dx, y + dy))
+      return false;
+    if (dx != 0 && dy != 0 && (!walkable(x + dx, y) || !walkable(x, y + dy)))
+      return false;
+
+    x += dx;
+    y += dy;
+    if (std::size_t(x) == goal.x && std::size_t(y) == goal.y)
+      break;
+
+    if (dy == 0) {
+      if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) || (walkable(x, y + 1) && !walkable(x - dx, y + 1)))
+        break;
+    } else if (dx == 0) {
+      if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) || (walkable(x + 1, y) && !walkable(x + 1, y - dy)))
+        break;
+    } else {
+      std::ptrdiff_t ix, iy;
+      if (jump(x, y, detail::jpsDirection(dx, 0), goal, ix, iy) ||
+          jump(x, y, detail::jpsDirection(0, dy), goal, ix, iy))
+        break;
+    }
+  }
+
+  jx = x;
+  jy = y;
+  return true;
+}
+
+
+// JumpPointSearchPlus implementation
+
+inline JumpPointSearchPlus::JumpPointSearchPlus(const ImageMatrix& image_matrix)
+  : m_image(image_matrix)
+  , m_distances()
+{
+  const std::ptrdiff_t width = m_image.width_;
+  const std::ptrdiff_t height = m_image.height_;
+  if (width > std::numeric_limits<std::int16_t>::max() || height > std::numeric_limits<std::int16_t>::max())
+    throw std::length_error("JumpPointSearchPlus: image side over 32767");
+
+  m_distances.assign(m_image.width_ * m_image.height_ * 8, 0);
+
+  // A cell's distance in direction dir follows from the one of its successor in
+  // dir, so every direction is swept starting from the side it points to:
+  // straight ones first, since the diagonal ones look at them.
+  for (int pass = 0; pass < 2; ++pass)
+    for (int dir = pass; dir < 8; dir += 2) {
+      const int dx = detail::jps_dx[dir];
+      const int dy = detail::jps_dy[dir];
+      for (std::ptrdiff_t j = 0; j < height; ++j) {
+        const std::ptrdiff_t y = dy > 0 ? height - 1 - j : j;
+        for (std::ptrdiff_t i = 0; i < width; ++i) {
+          const std::ptrdiff_t x = dx > 0 ? width - 1 - i : i;
+          if (!walkable(x, y))
+            continue;
+
+          std::int16_t& distance = m_distances[(y * width + x) * 8 + dir];
+          if (!canStep(x, y, dir)) {
+            distance = 0;
+            continue;
+          }
+
+          const std::ptrdiff_t nx = x + dx, ny = y + dy;
+          const bool jump_point = dir % 2 == 0
+            ? forced(nx, ny, dir)
+            : (jumpDistance(nx, ny, (dir + 7) % 8) > 0 || jumpDistance(nx, ny, (dir + 1) % 8) > 0);
+
+          const int next = jumpDistance(nx, ny, dir);
+          distance = jump_point ? 1 : (next > 0 ? next + 1 : next - 1);
+        }
+      }
+    }
+}
+
+inline std::vector<size_t2> JumpPointSearchPlus::findPath(const size_t2& start, const size_t2& goal) const
+{
+  const std::ptrdiff_t gx = goal.x, gy = goal.y;
+  return detail::jpsAStar(m_image, start, goal, [&](std::size_t ux, std::size_t uy, int dir,
+                                                    std::vector<std::pair<std::size_t, std::size_t> >& out) {
+    const std::ptrdiff_t x = ux, y = uy;
+    detail::jpsPrunedDirections(dir, [&](int d) {
+      const int dx = detail::jps_dx[d];
+      const int dy = detail::jps_dy[d];
+      const int distance = jumpDistance(ux, uy, d);
+      const std::ptrdiff_t reach = std::abs(distance);
+      const std::ptrdiff_t to_gx = (gx - x) * dx; // steps towards the goal along the axes
+      const std::ptrdiff_t to_gy = (gy - y) * dy;
+
+      if (d % 2 == 0) {
+        const bool goal_ahead = dx == 0 ? (gx == x && to_gy > 0) : (gy == y && to_gx > 0);
+        const std::ptrdiff_t goal_steps = dx == 0 ? to_gy : to_gx;
+        if (goal_ahead && goal_steps <= reach)
+          out.push_back(std::make_pair(gx, gy));
+        else if (distance > 0)
+          out.push_back(std::make_pair(x + dx * distance, y + dy * distance));
+      } else {
+        // the goal row or column is crossed before the jump: stop there, a straight jump follows
+        const std::ptrdiff_t steps = std::min(to_gx, to_gy);
+        if (to_gx > 0 && to_gy > 0 && steps <= reach)
+          out.push_back(std::make_pair(x + dx * steps, y + dy * steps));
+        else if (distance > 0)
+          out.push_back(std::make_pair(x + dx * distance, y + dy * distance));
+      }
+    });
+  });
+}
+
+inline bool JumpPointSearchPlus::walkable(std::ptrdiff_t x, std::ptrdiff_t y) const
+{
+  return x >= 0 && y >= 0 && std::size_t(x) < m_image.width_ && std::size_t(y) < m_image.height_ &&
+         m_image.cells_[y * m_image.width_ + x] == ImageMatrix::FREE;
+}
+
+inline bool JumpPointSearchPlus::canStep(std::ptrdiff_t x, std::ptrdiff_t y, int dir) const
+{
+  const int dx = detail::jps_dx[dir];
+  const int dy = detail::jps_dy[dir];
+  return walkable(x + dx, y + dy) && (dx == 0 || dy == 0 || (walkable(x + dx, y) && walkable(x, y + dy)));
+}
+
+/// (x, y) entered in straight direction dir has a neighbour only reachable through it.
+inline bool JumpPointSearchPlus::forced(std::ptrdiff_t x, std::ptrdiff_t y, int dir) const
+{
+  const int dx = detail::jps_dx[dir];
+  const int dy = detail::jps_dy[dir];
+  if (dy == 0)
+    return (walkable(x, y - 1) && !walkable(x - dx, y - 1)) || (walkable(x, y + 1) && !walkable(x - dx, y + 1));
+
+  return (walkable(x - 1, y) && !walkable(x - 1, y - dy)) || (walkable(x + 1, y) && !walkable(x + 1, y - dy));
+}
+
+#endif // JUMP_POINT_SEARCH_HPP
@@ -0,0 +1,392 @@
+#ifndef LOOSE_QUAD_TREE_HPP
+#define LOOSE_QUAD_TREE_HPP
+
+#include "quad_tree.hpp"
+
+#include <vector>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+/**
+  Loose quad tree of objects with extent: a box and a value of type T each.
+
+  The loose boundary of a node is its quad doubled. An object is kept in the
+  deepest node whose quad holds the object's center and whose half dimensions
+  are at least the object's, so the object is inside the loose boundary. Unlike
+  splitting an object up among all the nodes it overlaps, it is kept in exactly
+  one node, and a query looks at the nodes whose loose boundary intersects.
+
+  The node pool is the one of \ref QuadTree: children are consecutive, the
+  boundaries are halved on the way down. The objects of a node are chained in
+  one vector. A node holding more than leaf_capacity objects is split, the
+  objects small enough move down; a node whose subtree falls below
+  leaf_capacity objects is merged back.
+
+  Objects centered outside of the boundary stay in the root, so nothing is
+  dropped, but they are tested by every query.
+
+  T has to be copyable, and comparable with == for remove.
+
+  Segments, as the edges of \ref marchingSquares, are kept by their bounding
+  box with insertSegment, forEachSegmentIntersecting tests the segments
+  themselves against the range.
+*/
+template <typename P, typename T>
+class LooseQuadTree {
+public:
+
+  typedef typename P::value_type value_type;
+  typedef std::size_t size_type;
+
+  static const size_type max_depth = 32;
+
+  explicit LooseQuadTree(const AABB<P>& boundary, size_type leaf_capacity = 8);
+
+  void insert(const AABB<P>& box, const T& value);
+  /// Removes one object with an equal box and value, false if there is none.
+  bool remove(const AABB<P>& box, const T& value);
+
+  /// Calls f(box, value) for every object whose box intersects range.
+  template <typename F> void forEachIntersecting(const AABB<P>& range, F f) const;
+  std::vector<T> queryRange(const AABB<P>& range) const;
+
+  AABB<P> boundary() const { return AABB<P>(P(m_root.x, m_root.y), m_root.hx, m_root.hy); }
+  size_type size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  size_type leafCapacity() const { return m_leaf_capacity; }
+  size_type numberOfNodes() const { return m_nodes.size() - m_number_of_free_nodes; }
+  void clear();
+
+private:
+
+  typedef std::uint32_t index_type;
+  typedef detail::Quad<P> Quad;
+
+  struct Node {
+    index_type first_child; // quad_npos for a leaf
+    index_type first_item;  // chain of the objects of this node
+    index_type count;       // of this node
+    index_type total;       // of the subtree
+  };
+
+  struct Item {
+    value_type x, y, hx, hy;
+    T value;
+    index_type next; // in the chain of the node, or of the free ones
+  };
+
+  struct StackEntry {
+    index_type node;
+    Quad quad;
+  };
+
+  static bool fitsInto(const Item& item, const Quad& child) { return item.hx <= child.hx && item.hy <= child.hy; }
+  static bool intersects(const Item& item, const AABB<P>& range);
+
+  /// The node an object with that box belongs to, with its depth and the nodes on the way.
+  index_type findNode(const Item& item, index_type* path, size_type& depth, Quad& quad) const;
+
+  void link(index_type node, index_type item);
+  void split(index_type node, const Quad& quad, size_type depth);
+  void merge(index_type node);
+  index_type allocateChildren();
+  void freeChildren(index_type first_child);
+
+  Quad m_root;
+  size_type m_leaf_capacity;
+  size_type m_size;
+  std::vector<Node> m_nodes;
+  std::vector<Item> m_items;
+  index_type m_free_item;
+  index_type m_free_children; // empty leaves, chained through the first_child of the first one
+  size_type m_number_of_free_nodes;
+};
+
+
+
+// LooseQuadTree implementation
+
+template <typename P, typename T>
+const typename LooseQuadTree<P, T>::size_type LooseQuadTree<P, T>::max_depth;
+
+template <typename P, typename T>
+LooseQuadTree<P, T>::LooseQuadTree(const AABB<P>& boundary, size_type leaf_capacity)
+  : m_root()
+  , m_leaf_capacity(std::max<size_type>(leaf_capacity, 1))
+  , m_size(0)
+  , m_nodes()
+  , m_items()
+  , m_free_item(detail::quad_npos)
+  , m_free_children(detail::quad_npos)
+  , m_number_of_free_nodes(0)
+{
+  m_root.x = boundary.m_center.x;
+  m_root.y = boundary.m_center.y;
+  m_root.hx = boundary.m_halfWidth;
+  m_root.hy = boundary.m_halfHeight;
+  clear();
+}
+
+template <typename P, typename T>
+void LooseQuadTree<P, T>::clear()
+{
+  m_size = 0;
+  const Node root = { detail::quad_npos, detail::quad_npos, 0, 0 };
+  m_nodes.assign(1, root);
+  m_items.clear();
+  m_free_item = detail::quad_npos;
+  m_free_children = detail::quad_npos;
+  m_number_of_free_nodes = 0;
+}
+
+template <typename P, typename T>
+void LooseQuadTree<P, T>::insert(const AABB<P>& box, const T& value)
+{
+  const Item item = { box.m_center.x, box.m_center.y, box.m_halfWidth, box.m_halfHeight, value, detail::quad_npos };
+  index_type slot = m_free_item;
+  if (slot == detail::quad_npos) {
+    slot = index_type(m_items.size());
+    m_items.push_back(item);
+  } else {
+    m_free_item = m_items[slot].next;
+    m_items[slot] = item;
+  }
+
+  index_type path[max_depth + 1];
+  size_type depth = 0;
+  Quad quad = m_root;
+  const index_type node = findNode(item, path, depth, quad);
+  for (size_type d = 0; d <= depth; ++d)
+    ++m_nodes[path[d]].total;
+  link(node, slot);
+  ++m_size;
+
+  if (m_nodes[node].first_child == detail::quad_npos && m_nodes[node].count > m_leaf_capacity &&
+      depth < max_depth && quad.divisible())
+    split(node, quad, depth);
+}
+
+template <typename P, typename T>
+bool LooseQuadTree<P, T>::remove(const AABB<P>& box, const T& value)
+{
+  const Item item = { box.m_center.x, box.m_center.y, box.m_halfWidth, box.m_halfHeight, value, detail::quad_npos };
+  index_type path[max_depth + 1];
+  size_type depth = 0;
+  Quad quad = m_root;
+  const index_type node = findNode(item, path, depth, quad);
+
+  index_type* prev = &m_nodes[node].first_item;
+  while (*prev != detail::quad_npos) {
+    const Item& i = m_items[*prev];
+    if (i.x == item.x && i.y == item.y && i.hx == item.hx && i.hy == item.hy && i.value == value)
+      break;
+    prev = &m_items[*prev].next;
+  }
+  if (*prev == detail::quad_npos)
+    return false;
+
+  const index_type slot = *prev;
+  *prev = m_items[slot].next;
+  m_items[slot].next = m_free_item;
+  m_free_item = slot;
+  --m_nodes[node].count;
+  --m_size;
+  for (size_type d = 0; d <= depth; ++d)
+    --m_nodes[path[d]].total;
+
+  // the topmost node that fell below the capacity takes over all objects below it
+  for (size_type d = 0; d <= depth; ++d)
+    if (m_nodes[path[d]].first_child != detail::quad_npos && m_nodes[path[d]].total < m_leaf_capacity) {
+      merge(path[d]);
+      break;
+    }
+
+  return true;
+}
+
+template <typename P, typename T>
+template <typename F>
+void LooseQuadTree<P, T>::forEachIntersecting(const AABB<P>& range, F f) const
+{
+  // depth first, a level leaves at most 3 siblings behind on the stack
+  StackEntry stack[3 * max_depth + 4];
+  std::size_t top = 0;
+  const StackEntry root = { 0, m_root };
+  stack[top++] = root;
+  while (top > 0) {
+    const StackEntry e = stack[--top];
+    const Node& n = m_nodes[e.node];
+
+    for (index_type i = n.first_item; i != detail::quad_npos; i = m_items[i].next) {
+      const Item& item = m_items[i];
+      if (intersects(item, range))
+        f(AABB<P>(P(item.x, item.y), item.hx, item.hy), item.value);
+    }
+
+    if (n.first_child == detail::quad_npos)
+      continue;
+    for (index_type i = 0; i < 4; ++i) {
+      const index_type child = n.first_child + 3 - i;
+      if (m_nodes[child].total == 0)
+        continue;
+      const Quad quad = e.quad.child(3 - i);
+      Quad loose = quad;
+      loose.hx *= 2;
+      loose.hy *= 2;
+      if (!loose.intersects(range))
+        continue;
+      const StackEntry next = { child, quad };
+      stack[top++] = next;
+    }
+  }
+}
+
+template <typename P, typename T>
+std::vector<T> LooseQuadTree<P, T>::queryRange(const AABB<P>& range) const
+{
+  std::vector<T> retval;
+  forEachIntersecting(range, [&retval](const AABB<P>&, const T& value) { retval.push_back(value); });
+  return retval;
+}
+
+template <typename P, typename T>
+bool LooseQuadTree<P, T>::intersects(const Item& item, const AABB<P>& range)
+{
+  return (std::fabs(item.x - range.m_center.x) <= item.hx + range.m_halfWidth) &&
+         (std::fabs(item.y - range.m_center.y) <= item.hy + range.m_halfHeight);
+}
+
+template <typename P, typename T>
+typename LooseQuadTree<P, T>::index_type
+LooseQuadTree<P, T>::findNode(const Item& item, index_type* path, size_type& depth, Quad& quad) const
+{
+  const P center(item.x, item.y);
+  index_type node = 0;
+  path[0] = 0;
+  if (!m_root.contains(center))
+    return node;
+
+  while (m_nodes[node].first_child != detail::quad_npos) {
+    const std::size_t i = quad.quadrant(center);
+    const Quad child = quad.child(i);
+    if (!fitsInto(item, child))
+      break;
+    node = m_nodes[node].first_child + index_type(i);
+    quad = child;
+    path[++depth] = node;
+  }
+  return node;
+}
+
+template <typename P, typename T>
+void LooseQuadTree<P, T>::link(index_type node, index_type item)
+{
+  m_items[item].next = m_nodes[node].first_item;
+  m_nodes[node].first_item = item;
+  ++m_nodes[node].count;
+}
+
+template <typename P, typename T>
+void LooseQuadTree<P, T>::split(index_type node, const Quad& quad, size_type depth)
+{
+  const index_type first_child = allocateChildren();
+  m_nodes[node].first_child = first_child;
+
+  // the objects small enough, and centered inside (not so in the root), move down
+  index_type item = m_nodes[node].first_item;
+  m_nodes[node].first_item = detail::quad_npos;
+  m_nodes[node].count = 0;
+  while (item != detail::quad_npos) {
+    const index_type next = m_items[item].next;
+    const P center(m_items[item].x, m_items[item].y);
+    const std::size_t i = quad.quadrant(center);
+    if (quad.contains(center) && fitsInto(m_items[item], quad.child(i))) {
+      link(first_child + index_type(i), item);
+      ++m_nodes[first_child + i].total;
+    } else {
+      link(node, item);
+    }
+    item = next;
+  }
+
+  for (index_type i = 0; i < 4; ++i)
+    if (m_nodes[first_child + i].count > m_leaf_capacity && depth + 1 < max_depth && quad.child(i).divisible())
+      split(first_child + i, quad.child(i), depth + 1);
+}
+
+template <typename P, typename T>
+void LooseQuadTree<P, T>::merge(index_type node)
+{
+  index_type stack[3 * max_depth + 4];
+  std::size_t top = 0;
+  stack[top++] = m_nodes[node].first_child;
+  while (top > 0) {
+    const index_type first_child = stack[--top];
+    for (index_type i = 0; i < 4; ++i) {
+      const Node child = m_nodes[first_child + i];
+      if (child.first_child != detail::quad_npos)
+        stack[top++] = child.first_child;
+      for (index_type item = child.first_item; item != detail::quad_npos; ) {
+        const index_type next = m_items[item].next;
+        link(node, item);
+        item = next;
+      }
+    }
+    freeChildren(first_child);
+  }
+
+  m_nodes[node].first_child = detail::quad_npos;
+}
+
+template <typename P, typename T>
+typename LooseQuadTree<P, T>::index_type LooseQuadTree<P, T>::allocateChildren()
+{
+  const Node leaf = { detail::quad_npos, detail::quad_npos, 0, 0 };
+  if (m_free_children == detail::quad_npos) {
+    m_nodes.insert(m_nodes.end(), 4, leaf);
+    return index_type(m_nodes.size() - 4);
+  }
+
+  const index_type first_child = m_free_children;
+  m_free_children = m_nodes[first_child].first_child;
+  m_number_of_free_nodes -= 4;
+  std::fill(m_nodes.begin() + first_child, m_nodes.begin() + first_child + 4, leaf);
+  return first_child;
+}
+
+template <typename P, typename T>
+void LooseQuadTree<P, T>::freeChildren(index_type first_child)
+{
+  const Node leaf = { detail::quad_npos, detail::quad_npos, 0, 0 };
+  std::fill(m_nodes.begin() + first_child, m_nodes.begin() + first_child + 4, leaf);
+  m_nodes[first_child].first_child = m_free_children;
+  m_free_children = first_child;
+  m_number_of_free_nodes += 4;
+}
+
+template <typename P>
+void insertSegment(LooseQuadTree<P, std::pair<P, P> >& tree, const P& a, const P& b)
+{
+  tree.insert(boundingBox(a, b), std::make_pair(a, b));
+}
+
+template <typename P>
+bool removeSegment(LooseQuadTree<P, std::pair<P, P> >& tree, const P& a, const P& b)
+{
+  return tree.remove(boundingBox(a, b), std::make_pair(a, b));
+}
+
+/// Calls f(a, b) for every segment crossing or touching range.
+template <typename P, typename F>
+void forEachSegmentIntersecting(const LooseQuadTree<P, std::pair<P, P> >& tree, const AABB<P>& range, F f)
+{
+  tree.forEachIntersecting(range, [&](const AABB<P>&, const std::pair<P, P>& s) {
+    if (range.intersectsSegment(s.first, s.second))
+      f(s.first, s.second);
+  });
+}
+
+
+#endif // LOOSE_QUAD_TREE_HPP
@@ -0,0 +1,96 @@
+#ifndef LUMINANCE_HPP
+#define LUMINANCE_HPP
+
+#include "marching_squares.hpp"
+
+#include <vector>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+  Thresholds 8 bit luminance, as decoded from a grayscale map image, into cells:
+  black (below 16) is SOLID, white (from 240) FREE, everything between DESTROYABLE.
+
+  Loaders decode a row of pixels at a time and threshold it straight into its
+  place in a preallocated buffer, with luminanceToCells for the cells of an
+  \ref ImageMatrix, or with luminanceToSolidBits for a row of a \ref SolidMask,
+  a bit for every not FREE pixel. The latter compares 16 pixels per SSE2
+  instruction and packs them with a movemask, where available.
+*/
+
+namespace detail {
+
+enum { luminance_solid_below = 16, luminance_free_from = 240 };
+
+} // detail namespace
+
+
+inline ImageMatrix::CellType cellOfLuminance(std::uint8_t luminance)
+{
+  // branch free, so that the loop over a row vectorizes
+  return ImageMatrix::CellType(ImageMatrix::DESTROYABLE
+           - (luminance < detail::luminance_solid_below) * (ImageMatrix::DESTROYABLE - ImageMatrix::SOLID)
+           - (luminance >= detail::luminance_free_from) * (ImageMatrix::DESTROYABLE - ImageMatrix::FREE));
+}
+
+inline void luminanceToCells(const std::uint8_t* luminance, std::size_t n, ImageMatrix::CellType* cells)
+{
+  for (std::size_t i = 0; i < n; ++i)
+    cells[i] = cellOfLuminance(luminance[i]);
+}
+
+/// Writes the (n + 63) / 64 words of a row, the bits past n are cleared.
+inline void luminanceToSolidBits(const std::uint8_t* luminance, std::size_t n, SolidMask::word_type* words)
+{
+  std::size_t x = 0;
+
+#if defined(__SSE2__)
+  const __m128i free_from = _mm_set1_epi8(char(detail::luminance_free_from));
+  for (; x + SolidMask::word_bits <= n; x += SolidMask::word_bits) {
+    SolidMask::word_type word = 0;
+    for (int k = 0; k < SolidMask::word_bits / 16; ++k) {
+      const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(luminance + x + 16 * k));
+      const __m128i is_free = _mm_cmpeq_epi8(_mm_max_epu8(v, free_from), v); // v >= 240, unsigned
+      word |= SolidMask::word_type(~_mm_movemask_epi8(is_free) & 0xffff) << (16 * k);
+    }
+    words[x / SolidMask::word_bits] = word;
+  }
+#endif
+
+  for (; x < n; x += SolidMask::word_bits) {
+    const std::size_t end = std::min<std::size_t>(n, x + SolidMask::word_bits);
+    SolidMask::word_type word = 0;
+    for (std::size_t i = x; i < end; ++i)
+      word |= SolidMask::word_type(luminance[i] < detail::luminance_free_from) << (i - x);
+    words[x / SolidMask::word_bits] = word;
+  }
+}
+
+/// Rows of width pixels, stride bytes apart.
+inline ImageMatrix imageMatrixFromLuminance(std::size_t width, std::size_t height,
+                                            const std::uint8_t* pixels, std::size_t stride)
+{
+  std::vector<ImageMatrix::CellType> cells(width * height);
+  for (std::size_t y = 0; y < height; ++y)
+    luminanceToCells(pixels + y * stride, width, cells.data() + y * width);
+
+  return ImageMatrix(width, height, std::move(cells));
+}
+
+inline SolidMask solidMaskFromLuminance(std::size_t width, std::size_t height,
+                                        const std::uint8_t* pixels, std::size_t stride)
+{
+  SolidMask mask(width, height);
+  for (std::size_t y = 0; y < height; ++y)
+    luminanceToSolidBits(pixels + y * stride, width, mask.bits_.data() + y * mask.words_per_row_);
+
+  return mask;
+}
+
+#endif // LUMINANCE_HPP
@@ -1,8 +1,14 @@
 #ifndef MARCHING_SQUARES_HPP
 #define MARCHING_SQUARES_HPP
 
+#include "parallel.hpp"
+
 #include <vector>
 
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
 
 struct ImageMatrix {
   enum CellType { FREE, SOLID, DESTROYABLE };
@@ -12,6 +18,8 @@ struct ImageMatrix {
   const std::vector<CellType> cells_;
   ImageMatrix(std::size_t w, std::size_t h, const std::vector<CellType>& c)
     : width_(w), height_(h), cells_(c) {}
+  ImageMatrix(std::size_t w, std::size_t h, std::vector<CellType>&& c) // takes over the buffer of a loader
+    : width_(w), height_(h), cells_(std::move(c)) {}
 };
 
 struct size_t2 {
@@ -22,13 +30,40 @@ struct size_t2 {
   bool operator==(const size_t2 o) const { return x == o.x && y == o.y; }
 };
 
+/**
+  Bit-plane of the solid cells of an \ref ImageMatrix: one bit per cell, set if
+  the cell is not FREE, every row padded to whole 64 bit words.
+
+  An eighth of the memory of a byte per cell and a 32nd of the enum, and the
+  2x2 masks of marching squares are evaluated 64 cells per word operation.
+*/
+struct SolidMask {
+  typedef std::uint64_t word_type;
+  enum { word_bits = 64 };
+
+  const std::size_t width_;
+  const std::size_t height_;
+  const std::size_t words_per_row_;
+  std::vector<word_type> bits_;
+
+  SolidMask(std::size_t w, std::size_t h) // all cells free
+    : width_(w), height_(h), words_per_row_((w + word_bits - 1) / word_bits), bits_(words_per_row_ * h, 0) {}
+  SolidMask(std::size_t w, std::size_t h, std::vector<word_type>&& bits) // takes over the rows of a loader
+    : width_(w), height_(h), words_per_row_((w + word_bits - 1) / word_bits), bits_(std::move(bits)) {}
+  explicit SolidMask(const ImageMatrix& image_matrix);
+
+  bool solid(std::size_t x, std::size_t y) const { return (bits_[y * words_per_row_ + x / word_bits] >> (x % word_bits)) & 1; }
+  void set(std::size_t x, std::size_t y, bool solid);
+  const word_type* row(std::size_t y) const { return bits_.data() + y * words_per_row_; }
+};
+
 
 namespace detail {
 
-  int getMaskAt(int x, int y, const ImageMatrix& image_matrix)
+  inline int getMaskAt(int x, int y, const ImageMatrix& image_matrix)
   {
     const std::size_t width = image_matrix.width_;
-    const std::vector<ImageMatrix::CellType> cells = image_matrix.cells_;
+    const std::vector<ImageMatrix::CellType>& cells = image_matrix.cells_;
 
     const ImageMatrix::CellType quad[4] = {
         cells[(y-1) * width + (x-1)], cells[(y-1) * width + x],   // TL T
@@ -42,7 +77,7 @@ namespace detail {
     return mask;
   }
 
-  void visitPoint(std::size_t x, std::size_t y,
+  inline void visitPoint(std::size_t x, std::size_t y,
                   int mask,
                   std::vector< bool >& visited,
                   std::vector< std::pair<size_t2, size_t2> >& lines,
@@ -69,9 +104,11 @@ namespace detail {
       size_t2 i(x, y);
       while (true) {
         i += size_t2(1, 0);
+        if (i.x >= width || i.y >= height)
+          break;
+
         int next_mask = getMaskAt(i.x, i.y, image_matrix);
-        if (i.x < width && i.y < height &&
-          ( (horizontal_top && next_mask == 0x3) ||
+        if (( (horizontal_top && next_mask == 0x3) ||
             (horizontal_bottom && next_mask == 0xc) ||
             (vertical_left && next_mask == 0x5) ||
             (vertical_right && next_mask == 0xa) ) &&
@@ -81,7 +118,8 @@ namespace detail {
           break;
       }
       if (i.x != x) {
-        visited[i.y*width + i.x] = false;
+        if (i.x < width)
+          visited[i.y*width + i.x] = false;
         lines.push_back(std::pair<size_t2, size_t2>(size_t2(x, y), size_t2( i.x, i.y)));
       }
     }
@@ -90,9 +128,11 @@ namespace detail {
       size_t2 i(x, y);
       while (true) {
         i += size_t2(0, 1);
+        if (i.x >= width || i.y >= height)
+          break;
+
         int next_mask = getMaskAt(i.x, i.y, image_matrix);
-        if (i.x < width && i.y < height &&
-          ( (horizontal_top && next_mask == 0x3) ||
+        if (( (horizontal_top && next_mask == 0x3) ||
             (horizontal_bottom && next_mask == 0xc) ||
             (vertical_left && next_mask == 0x5) ||
             (vertical_right && next_mask == 0xa) ) &&
@@ -102,17 +142,76 @@ namespace detail {
           break;
       }
       if (i.y != y) {
-        visited[i.y*width + i.x] = false;
+        if (i.y < height)
+          visited[i.y*width + i.x] = false;
         lines.push_back(std::pair<size_t2, size_t2>(size_t2(x, y),  size_t2( i.x, i.y)));
       }
     }
   }
 
 
+  inline int countTrailingZeros(SolidMask::word_type w)
+  {
+#ifdef __GNUC__
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    for (; (w & 1) == 0; w >>= 1)
+      ++n;
+    return n;
+#endif
+  }
+
+  /**
+    Classifies the cells (x, y) of a row against their 2x2 neighbourhood, T and X
+    being rows y-1 and y, TL and L the same shifted by one cell. Per bit:
+    - a horizontal contour lies between T and X where they differ,
+      it goes on through the cell if TL, L equal T, X (masks 0x3, 0xc), else starts there,
+    - a vertical one lies between L and X where they differ,
+      it goes on if TL, T equal L, X (masks 0x5, 0xa), else starts there.
+  */
+  inline void maskPlanes(const SolidMask::word_type* top, const SolidMask::word_type* bottom, std::size_t words,
+                         SolidMask::word_type* start_h, SolidMask::word_type* cont_h,
+                         SolidMask::word_type* start_v, SolidMask::word_type* cont_v)
+  {
+    SolidMask::word_type carry_t = 0, carry_x = 0;
+    for (std::size_t k = 0; k < words; ++k) {
+      const SolidMask::word_type t = top[k];
+      const SolidMask::word_type x = bottom[k];
+      const SolidMask::word_type tl = (t << 1) | carry_t;
+      const SolidMask::word_type l = (x << 1) | carry_x;
+      carry_t = t >> (SolidMask::word_bits - 1);
+      carry_x = x >> (SolidMask::word_bits - 1);
+
+      const SolidMask::word_type h = t ^ x;
+      const SolidMask::word_type v = l ^ x;
+      cont_h[k] = h & ~(tl ^ t) & ~v;
+      cont_v[k] = v & ~(tl ^ l) & ~h;
+      start_h[k] = h & ~cont_h[k];
+      start_v[k] = v & ~cont_v[k];
+    }
+  }
+
+  /// First x >= from whose bit is clear, width if there is none before it.
+  inline std::size_t nextClear(const SolidMask::word_type* bits, std::size_t words, std::size_t from, std::size_t width)
+  {
+    std::size_t k = from / SolidMask::word_bits;
+    if (k >= words)
+      return width;
+
+    SolidMask::word_type w = ~bits[k] & (~SolidMask::word_type(0) << (from % SolidMask::word_bits));
+    while (w == 0) {
+      if (++k == words)
+        return width;
+      w = ~bits[k];
+    }
+    return std::min(width, k * SolidMask::word_bits + countTrailingZeros(w));
+  }
+
 } // detail namespace
 
 
-std::vector< std::pair<size_t2, size_t2> > marchingSquares(const ImageMatrix& image_matrix)
+inline std::vector< std::pair<size_t2, size_t2> > marchingSquares(const ImageMatrix& image_matrix)
 {
   const std::size_t width = image_matrix.width_;
   const std::size_t height = image_matrix.height_;
@@ -137,5 +236,173 @@ std::vector< std::pair<size_t2, size_t2> > marchingSquares(const ImageMatrix& im
   return lines;
 }
 
+namespace detail {
+
+  /// Rows [y_begin, y_end) of the vertical continuation plane, y_begin >= 1.
+  inline void verticalContinuations(const SolidMask& solid_mask, std::size_t y_begin, std::size_t y_end,
+                                    std::vector<SolidMask::word_type>& cont_v)
+  {
+    const std::size_t words = solid_mask.words_per_row_;
+    std::vector<SolidMask::word_type> start_h(words), cont_h(words), start_v(words);
+    for (std::size_t y = y_begin; y < y_end; ++y)
+      maskPlanes(solid_mask.row(y - 1), solid_mask.row(y), words,
+                 start_h.data(), cont_h.data(), start_v.data(), cont_v.data() + y * words);
+  }
+
+  /// Appends the segments starting in rows [y_begin, y_end), y_begin >= 1, in row-major order.
+  /// Vertical runs are followed on the continuation plane of the whole image, past y_end too.
+  inline void segmentsOfRows(const SolidMask& solid_mask, const std::vector<SolidMask::word_type>& cont_v,
+                             std::size_t y_begin, std::size_t y_end,
+                             std::vector< std::pair<size_t2, size_t2> >& lines)
+  {
+    typedef SolidMask::word_type word_type;
+    const std::size_t width = solid_mask.width_;
+    const std::size_t height = solid_mask.height_;
+    const std::size_t words = solid_mask.words_per_row_;
+
+    // cells of column 0 and past the last column have no 2x2 neighbourhood
+    const word_type first_word_mask = ~word_type(1);
+    const word_type last_word_mask = (width % SolidMask::word_bits == 0)
+      ? ~word_type(0) : (word_type(1) << (width % SolidMask::word_bits)) - 1;
+
+    std::vector<word_type> start_h(words), cont_h(words), start_v(words), cont_v_row(words);
+    for (std::size_t y = y_begin; y < y_end; ++y) {
+      maskPlanes(solid_mask.row(y - 1), solid_mask.row(y), words,
+                 start_h.data(), cont_h.data(), start_v.data(), cont_v_row.data());
+      start_h[0] &= first_word_mask;
+      start_v[0] &= first_word_mask;
+      start_h[words - 1] &= last_word_mask;
+      start_v[words - 1] &= last_word_mask;
+
+      for (std::size_t k = 0; k < words; ++k) {
+        for (word_type w = start_h[k] | start_v[k]; w != 0; w &= w - 1) {
+          const int b = countTrailingZeros(w);
+          const std::size_t x = k * SolidMask::word_bits + b;
+
+          if ((start_h[k] >> b) & 1) {
+            const std::size_t end = nextClear(cont_h.data(), words, x + 1, width);
+            lines.push_back(std::pair<size_t2, size_t2>(size_t2(x, y), size_t2(end, y)));
+          }
+          if ((start_v[k] >> b) & 1) {
+            std::size_t end = y + 1;
+            while (end < height && ((cont_v[end * words + k] >> b) & 1))
+              ++end;
+            lines.push_back(std::pair<size_t2, size_t2>(size_t2(x, y), size_t2(x, end)));
+          }
+        }
+      }
+    }
+  }
+
+  /// Rows [y_begin, y_end) of the bit-plane from the cells.
+  inline void fillSolidRows(const ImageMatrix& image_matrix, std::size_t y_begin, std::size_t y_end, SolidMask& solid_mask)
+  {
+    const std::size_t width = solid_mask.width_;
+    const std::size_t words = solid_mask.words_per_row_;
+    for (std::size_t y = y_begin; y < y_end; ++y) {
+      const ImageMatrix::CellType* cells = image_matrix.cells_.data() + y * width;
+      SolidMask::word_type* row_bits = solid_mask.bits_.data() + y * words;
+      for (std::size_t k = 0; k < words; ++k) {
+        const std::size_t x0 = k * SolidMask::word_bits;
+        const std::size_t n = std::min<std::size_t>(SolidMask::word_bits, width - x0);
+        SolidMask::word_type w = 0;
+        for (std::size_t i = 0; i < n; ++i)
+          w |= SolidMask::word_type(cells[x0 + i] != ImageMatrix::FREE) << i;
+        row_bits[k] = w;
+      }
+    }
+  }
+
+} // detail namespace
+
+
+/// Same segments in the same order as marchingSquares(const ImageMatrix&), computed on the bit-plane.
+inline std::vector< std::pair<size_t2, size_t2> > marchingSquares(const SolidMask& solid_mask)
+{
+  std::vector< std::pair<size_t2, size_t2> > lines;
+  if (solid_mask.width_ < 2 || solid_mask.height_ < 2)
+    return lines;
+
+  // vertical runs are followed downwards, so their continuation plane is needed for every row
+  std::vector<SolidMask::word_type> cont_v(solid_mask.words_per_row_ * solid_mask.height_, 0);
+  detail::verticalContinuations(solid_mask, 1, solid_mask.height_, cont_v);
+  detail::segmentsOfRows(solid_mask, cont_v, 1, solid_mask.height_, lines);
+  return lines;
+}
+
+/**
+  marchingSquares on all cores, same result as the serial run.
+
+  The image is cut into horizontal bands of band_height rows. The continuation
+  plane is built band by band first, then every band emits the segments starting
+  in its rows. A vertical run crossing a seam is followed into the bands below on
+  that shared plane, so it comes out whole, as in the serial run, and there is
+  nothing to merge afterwards. The per band outputs are concatenated in band order.
+*/
+inline std::vector< std::pair<size_t2, size_t2> > parallelMarchingSquares(const SolidMask& solid_mask,
+                                                                          std::size_t band_height = 256)
+{
+  std::vector< std::pair<size_t2, size_t2> > lines;
+  const std::size_t height = solid_mask.height_;
+  if (solid_mask.width_ < 2 || height < 2)
+    return lines;
+
+  // bands over the rows [1, height)
+  band_height = std::max<std::size_t>(band_height, 1);
+  const std::size_t number_of_bands = (height - 1 + band_height - 1) / band_height;
+  auto bandBegin = [band_height](std::size_t band) { return 1 + band * band_height; };
+  auto bandEnd = [band_height, height](std::size_t band) { return std::min(height, 1 + (band + 1) * band_height); };
+
+  std::vector<SolidMask::word_type> cont_v(solid_mask.words_per_row_ * height, 0);
+  parallelForChunks(number_of_bands, [&](std::size_t band) {
+    detail::verticalContinuations(solid_mask, bandBegin(band), bandEnd(band), cont_v);
+  });
+
+  std::vector< std::vector< std::pair<size_t2, size_t2> > > band_lines(number_of_bands);
+  parallelForChunks(number_of_bands, [&](std::size_t band) {
+    detail::segmentsOfRows(solid_mask, cont_v, bandBegin(band), bandEnd(band), band_lines[band]);
+  });
+
+  std::size_t total = 0;
+  for (const auto& l : band_lines)
+    total += l.size();
+
+  lines.reserve(total);
+  for (const auto& l : band_lines)
+    lines.insert(lines.end(), l.begin(), l.end());
+
+  return lines;
+}
+
+/// Converts to a \ref SolidMask on all cores and runs parallelMarchingSquares on it.
+inline std::vector< std::pair<size_t2, size_t2> > parallelMarchingSquares(const ImageMatrix& image_matrix,
+                                                                          std::size_t band_height = 256)
+{
+  SolidMask solid_mask(image_matrix.width_, image_matrix.height_);
+  parallelFor(image_matrix.height_, band_height, [&](std::size_t y_begin, std::size_t y_end) {
+    detail::fillSolidRows(image_matrix, y_begin, y_end, solid_mask);
+  });
+  return parallelMarchingSquares(solid_mask, band_height);
+}
+
+
+// SolidMask implementation
+
+inline SolidMask::SolidMask(const ImageMatrix& image_matrix)
+  : width_(image_matrix.width_)
+  , height_(image_matrix.height_)
+  , words_per_row_((width_ + word_bits - 1) / word_bits)
+  , bits_(words_per_row_ * height_, 0)
+{
+  detail::fillSolidRows(image_matrix, 0, height_, *this);
+}
+
+inline void SolidMask::set(std::size_t x, std::size_t y, bool solid)
+{
+  word_type& w = bits_[y * words_per_row_ + x / word_bits];
+  const word_type bit = word_type(1) << (x % word_bits);
+  w = solid ? (w | bit) : (w & ~bit);
+}
+
 
 #endif // MARCHING_SQUARES_HPP
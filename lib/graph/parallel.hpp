@@ -0,0 +1,105 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/**
+  Minimal worker pool helpers on top of std::thread.
+
+  Work is split into chunks whose boundaries do not depend on the number of
+  threads, so a computation seeded per chunk gives the same result on any
+  machine. Link with the platform thread library (-pthread).
+*/
+
+/// Number of worker threads to use, at least 1.
+inline std::size_t numberOfThreads()
+{
+  const unsigned n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
+
+/// Calls f(chunk_index) for every chunk_index in [0, number_of_chunks), on all cores.
+template <typename F>
+void parallelForChunks(std::size_t number_of_chunks, F f)
+{
+  const std::size_t number_of_threads = std::min(numberOfThreads(), number_of_chunks);
+  if (number_of_threads <= 1) {
+    for (std::size_t c = 0; c < number_of_chunks; ++c)
+      f(c);
+    return;
+  }
+
+  std::atomic<std::size_t> next(0);
+  auto worker = [&next, number_of_chunks, &f]() {
+    for (std::size_t c = next++; c < number_of_chunks; c = next++)
+      f(c);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(number_of_threads - 1);
+  for (std::size_t t = 1; t < number_of_threads; ++t)
+    threads.push_back(std::thread(worker));
+
+  worker();
+  for (auto& t : threads)
+    t.join();
+}
+
+/// Calls f(begin, end) on consecutive ranges of at most chunk_size elements covering [0, n).
+template <typename F>
+void parallelFor(std::size_t n, std::size_t chunk_size, F f)
+{
+  chunk_size = std::max<std::size_t>(1, chunk_size);
+  const std::size_t number_of_chunks = (n + chunk_size - 1) / chunk_size;
+  parallelForChunks(number_of_chunks, [n, chunk_size, &f](std::size_t c) {
+    f(c * chunk_size, std::min(n, (c + 1) * chunk_size));
+  });
+}
+
+/// Stable LSD radix sort of the keys by their bits [low_bit, high_bit), 8 bits per
+/// pass. Every pass counts and scatters chunks of chunk_size keys in parallel.
+inline void parallelRadixSort(std::uint64_t* keys, std::size_t n, unsigned low_bit, unsigned high_bit,
+                              std::size_t chunk_size = 1 << 16)
+{
+  chunk_size = std::max<std::size_t>(1, chunk_size);
+  const std::size_t number_of_chunks = (n + chunk_size - 1) / chunk_size;
+  std::vector<std::uint64_t> buffer(n);
+  std::vector<std::size_t> offsets(number_of_chunks * 256);
+  std::uint64_t* from = keys;
+  std::uint64_t* to = buffer.data();
+
+  for (unsigned shift = low_bit; shift < high_bit; shift += 8) {
+    const std::uint64_t mask = high_bit - shift >= 8 ? 0xff : (std::uint64_t(1) << (high_bit - shift)) - 1;
+    parallelForChunks(number_of_chunks, [&](std::size_t c) {
+      std::size_t* count = offsets.data() + c * 256;
+      std::fill(count, count + 256, 0);
+      for (std::size_t i = c * chunk_size; i < std::min(n, (c + 1) * chunk_size); ++i)
+        ++count[(from[i] >> shift) & mask];
+    });
+
+    // digit major, chunk minor, so that every chunk scatters behind the chunks before it
+    std::size_t sum = 0;
+    for (std::size_t d = 0; d < 256; ++d)
+      for (std::size_t c = 0; c < number_of_chunks; ++c) {
+        const std::size_t count = offsets[c * 256 + d];
+        offsets[c * 256 + d] = sum;
+        sum += count;
+      }
+
+    parallelForChunks(number_of_chunks, [&](std::size_t c) {
+      std::size_t* offset = offsets.data() + c * 256;
+      for (std::size_t i = c * chunk_size; i < std::min(n, (c + 1) * chunk_size); ++i)
+        to[offset[(from[i] >> shift) & mask]++] = from[i];
+    });
+    std::swap(from, to);
+  }
+
+  if (from != keys)
+    std::copy(from, from + n, keys);
+}
+
+#endif // PARALLEL_HPP
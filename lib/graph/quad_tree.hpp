@@ -1,10 +1,22 @@
 #ifndef QUAD_TREE_HPP
 #define QUAD_TREE_HPP
 
+#include "parallel.hpp"
+
 #include <vector>
 #include <utility> // move
-#include <cassert>
-#include <cmath> // std::fabs
+#include <algorithm>
+#include <bitset>
+#include <cmath> // std::fabs, std::floor, std::isfinite
+#include <cstdint>
+#include <iterator>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // From wikipedia: http://en.wikipedia.org/wiki/Quadtree#Pseudo_code
 
@@ -20,53 +32,254 @@
   ~~~
  */
 
-// Axis-aligned bounding box with half dimension and center
+// Axis-aligned bounding box with center and half dimensions along x and y
 template <typename P>
 struct AABB
 {
   const P m_center;
-  const typename P::value_type m_halfDimension;
+  const typename P::value_type m_halfWidth;
+  const typename P::value_type m_halfHeight;
 
+  /// A square.
   constexpr AABB(const P& center, typename P::value_type halfDimension);
+  constexpr AABB(const P& center, typename P::value_type halfWidth, typename P::value_type halfHeight);
 
   bool containsPoint(const P& p) const;
   bool intersectsAABB(const AABB& other) const;
+  bool containsAABB(const AABB& other) const;
+  /// Slab test, touching counts.
+  bool intersectsSegment(const P& a, const P& b) const;
+};
+
+/// The smallest box holding a and b, as the one of a segment.
+template <typename P>
+AABB<P> boundingBox(const P& a, const P& b);
+
+namespace detail {
+
+constexpr std::uint32_t quad_npos = std::numeric_limits<std::uint32_t>::max();
+
+/// Points tested at once by insideMask.
+constexpr std::size_t simd_width = 8;
+
+/// Bit i is set if (xs[i], ys[i]) is inside of the box with center x, y and half
+/// dimensions hx, hy, touching counts, for the simd_width points from xs and ys on.
+/// With SSE2 or AVX the float version compares 4 or 8 points per instruction.
+template <typename T>
+unsigned insideMask(const T* xs, const T* ys, T x, T y, T hx, T hy);
+
+/// Boundary of a quad tree node, the nodes do not store it but halve it on the way down.
+template <typename P>
+struct Quad {
+  typedef typename P::value_type value_type;
+
+  value_type x, y, hx, hy; // center and half dimensions
+
+  Quad child(std::size_t i) const;
+  bool divisible() const;
+  /// Index of the child p is sorted into, a point on a center line goes to the lower side.
+  std::size_t quadrant(const P& p) const { return (p.x > x ? 1 : 0) | (p.y > y ? 2 : 0); }
+  bool contains(const P& p) const { return std::fabs(x - p.x) <= hx && std::fabs(y - p.y) <= hy; }
+  bool intersects(const AABB<P>& range) const;
+  bool inside(const AABB<P>& range) const;
+  value_type squaredDistance(const P& p) const; // 0 inside
 };
 
+/// A half dimension of a power of two, and a center on a multiple of it, so that
+/// [center - half, center + half] holds [low, high] and halving and doubling it
+/// are exact. False if that overflows.
+template <typename T>
+bool snapInterval(T low, T high, T& center, T& half);
+
+} // detail namespace
+
+
+/**
+  Point quad tree over a flat node pool.
+
+  The nodes live in one vector and refer to each other by index: the 4 children
+  of a node are consecutive, so a node only stores the index of the first one.
+  Node boundaries are not stored, they are halved on the way down, along both
+  axes: the boundary need not be square, a wide map keeps its aspect ratio in
+  every node instead of spending levels on the empty part of a square.
+
+  Points are kept in the leaves only, in blocks of leaf_capacity consecutive
+  slots of a single point vector. A full leaf is split when a point is added.
+  Their coordinates are also kept column wise, the x and y of the slots in two
+  vectors of their own, so that range queries test the points of a leaf
+  detail::simd_width at a time, without a branch per point.
+  At max_depth, or once the halved boundaries are not exact in value_type, it
+  chains a further block instead, so any number of equal points fits. Freed
+  blocks are reused.
+
+  With GROWING_BOUNDS a point outside of the boundary does not fail to insert:
+  the root is doubled towards it, the old root becoming one of the children of
+  the new one, until the point is inside. The old root has to be exactly that
+  child, which rounding breaks after a doubling or two for half dimensions that
+  are not powers of two, as 0.1 or 1/3. Then the root is snapped once: to half
+  dimensions of powers of two, centered on a multiple of them, holding all points
+  and the new one, and the points are inserted again. Doubling such a root is
+  exact, so only a point that is not finite fails, or one past max_growth levels.
+
+  Removing a point fills its slot with the last point of the leaf. A node whose
+  subtree falls below leaf_capacity points is merged back into a leaf, its
+  children and their blocks are reused by later splits.
+
+  Copies are deep, and all memory is released at once with the vectors.
+*/
 template <typename P>
 class QuadTree {
 public:
 
-  QuadTree(const AABB<P>& boundary);
-  QuadTree(const QuadTree& other);
-  QuadTree(QuadTree&& other);
-  QuadTree& operator=(const QuadTree other) { swap(other); return *this; }
-  void swap(QuadTree& other);
-  ~QuadTree();
+  typedef typename P::value_type value_type;
+  typedef std::size_t size_type;
+
+  static const size_type max_depth = 32;
+  /// Levels the root may grow on top of max_depth.
+  static const size_type max_growth = 32;
+
+  enum BoundsMode { FIXED_BOUNDS, GROWING_BOUNDS };
+
+  explicit QuadTree(const AABB<P>& boundary, size_type leaf_capacity = 8, BoundsMode mode = FIXED_BOUNDS);
 
+  /// Bulk load, the points outside of boundary are dropped. The points are
+  /// sorted along the Z-order (Morton) curve of the tree, in parallel, so that
+  /// the points of every node are a consecutive range, and the tree is built in
+  /// one pass over the sorted points, without descending from the root per point.
+  /// The codes are only as deep as an even spread needs, crowded nodes are
+  /// sorted once more below.
+  /// With GROWING_BOUNDS the root is grown to hold all points first.
+  QuadTree(const AABB<P>& boundary, const std::vector<P>& points, size_type leaf_capacity = 8,
+           BoundsMode mode = FIXED_BOUNDS);
+
+  /// False if p is outside of the boundary, and it could not be grown.
   bool insert(const P& p);
 
+  /// Removes one point equal to p, false if there is none.
+  bool remove(const P& p);
+  /// Relocates one point equal to from, in place while from and to fall into the
+  /// same leaf. With GROWING_BOUNDS the root grows for a to outside of it, as on
+  /// insert. False, with the tree unchanged, if from is not in the tree or to can
+  /// not be inserted.
+  bool move(const P& from, const P& to);
+
   std::vector<P> queryRange(const AABB<P>& range) const;
   std::vector<P> points() const;
 
+  /// Allocation free queries: the tree is walked with a fixed size stack, and
+  /// subtrees inside the range are taken without testing their points.
+  template <typename OutputIt> OutputIt queryRange(const AABB<P>& range, OutputIt out) const;
+  template <typename F> void forEachInRange(const AABB<P>& range, F f) const; // f(const P&)
+  size_type countRange(const AABB<P>& range) const;
+
+  /// Batched queries, the results of every range are the same, in the same order,
+  /// as of its own query. All ranges are answered in one walk of the tree: a node
+  /// is visited once for all the ranges reaching it, and the points of a leaf are
+  /// tested against each of them while they are in cache.
+  std::vector<std::vector<P> > queryRanges(const std::vector<AABB<P> >& ranges) const;
+  template <typename F> void forEachInRanges(const std::vector<AABB<P> >& ranges, F f) const; // f(index of the range, const P&)
+  std::vector<size_type> countRanges(const std::vector<AABB<P> >& ranges) const;
+
+  /// The k points closest to p, nearest first, fewer if the tree has less.
+  /// Best first: nodes are visited in order of their distance to p, until the
+  /// next one is farther than the k-th point found.
+  std::vector<P> nearestNeighbours(const P& p, size_type k) const;
+
+  /// Points within radius (inclusive) of center.
+  std::vector<P> queryRadius(const P& center, value_type radius) const;
+  template <typename F> void forEachInRadius(const P& center, value_type radius, F f) const; // f(const P&)
+
+  AABB<P> boundary() const { return AABB<P>(P(m_root.x, m_root.y), m_root.hx, m_root.hy); }
+  size_type size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+  size_type leafCapacity() const { return m_leaf_capacity; }
+  BoundsMode boundsMode() const { return m_mode; }
+  size_type numberOfNodes() const { return m_nodes.size() - m_number_of_free_nodes; }
+  void clear();
+
 private:
-  void subdivide();
 
-  // Arbitrary constant to indicate how many elements can be stored in this quad tree node
-  static const std::size_t m_node_capacity = 4;
+  typedef std::uint32_t index_type;
+
+  static const size_type max_height = max_depth + max_growth;
+
+  typedef detail::Quad<P> Quad;
+
+  struct Node {
+    index_type first_child; // quad_npos for a leaf
+    index_type block;       // the first one holds count % leaf_capacity points when not full
+    index_type count;       // of the subtree
+  };
+
+  struct StackEntry {
+    index_type node;
+    bool inside; // the whole quad is in the range
+    Quad quad;
+  };
+
+  struct RangesEntry {
+    index_type node;
+    Quad quad;
+    std::size_t begin, end; // the slice of the active ranges the node is tested against
+  };
+
+  /// Calls f(node, inside) for the nodes a range query has to look at: leaves
+  /// intersecting the range, and the topmost nodes inside of it.
+  template <typename F> void forEachNodeInRange(const AABB<P>& range, F f) const;
+  /// Calls f(node, index of the range, inside) for the nodes each of the range queries has to look at.
+  template <typename F> void forEachNodeInRanges(const std::vector<AABB<P> >& ranges, F f) const;
+  template <typename F> void forEachInSubtree(index_type node, F f) const;
+
+  static value_type squaredDistance(const P& a, const P& b) { return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y); }
+  static std::size_t quadrant(const Quad& q, const P& p) { return q.quadrant(p); }
+
+  /// Quadrants of p on the levels below quad, 2 bits per level, the first level in the top bits.
+  static std::uint32_t mortonCode(Quad quad, const P& p, size_type levels);
+  /// keys are code << 32 | index into points, the codes taken levels deep below quad.
+  void bulkLoad(index_type node, const Quad& quad, size_type depth, const std::vector<P>& points,
+                std::uint64_t* keys, std::size_t n);
+  void buildSorted(index_type node, const Quad& quad, size_type depth, size_type level, size_type levels,
+                   const std::vector<P>& points, std::uint64_t* keys, std::size_t n);
 
-  // Axis-aligned bounding box stored as a center with half-dimensions
-  // to represent the boundaries of this quad tree
-  const AABB<P> m_boundary;
+  /// Doubles the root towards p until it holds p, false if that is not possible.
+  bool grow(const P& p);
+  bool growTowards(const P& p);
+  /// The root of powers of two holding p and all points, which are inserted again.
+  bool snapRoot(const P& p);
 
-  // Points in this quad tree node
-  std::vector<P> m_points;
+  void append(index_type node, const P& p);
+  void split(index_type node, const Quad& quad, size_type depth);
+  void merge(index_type node);
+  /// Index of the slot in m_points holding a point equal to p, quad_npos if there is none.
+  std::size_t findInLeaf(index_type node, const P& p) const;
+  void removeFromLeaf(index_type node, std::size_t slot);
+  index_type allocateBlock();
+  void freeBlocks(index_type block);
+  /// 4 empty leaves, the index of the first one
+  index_type allocateChildren();
+  void freeChildren(index_type first_child);
 
-  // Children
-  QuadTree* m_northWest;
-  QuadTree* m_northEast;
-  QuadTree* m_southWest;
-  QuadTree* m_southEast;
+  /// Calls f(p) for every point of a leaf.
+  template <typename F> void forEachInLeaf(const Node& leaf, F f) const;
+  /// Calls f(p) for every point of a leaf inside of range.
+  template <typename F> void forEachInLeafInRange(const Node& leaf, const AABB<P>& range, F f) const;
+  size_type countInLeaf(const Node& leaf, const AABB<P>& range) const;
+  /// Bit i is set if the point in slot + i is inside of range, for detail::simd_width slots.
+  unsigned insideMask(std::size_t slot, const AABB<P>& range) const;
+  void setPoint(std::size_t slot, const P& p);
+
+  Quad m_root;
+  size_type m_leaf_capacity;
+  BoundsMode m_mode;
+  size_type m_size;
+  size_type m_height;                   // no node is deeper, nodes are counted from the root
+  std::vector<Node> m_nodes;
+  std::vector<P> m_points;              // leaf_capacity slots per block
+  std::vector<value_type> m_xs, m_ys;   // coordinates of the slots, and detail::simd_width more to read past the last one
+  std::vector<index_type> m_next_block; // chain of the blocks of a leaf, and of the free ones
+  index_type m_free_block;
+  index_type m_free_children;           // empty leaves, chained through the first_child of the first one
+  size_type m_number_of_free_nodes;
 };
 
 
@@ -76,161 +289,1006 @@ private:
 template <typename P>
 constexpr AABB<P>::AABB(const P& center, typename P::value_type halfDimension)
   : m_center(center)
-  , m_halfDimension(halfDimension) {}
+  , m_halfWidth(halfDimension)
+  , m_halfHeight(halfDimension) {}
+
+template <typename P>
+constexpr AABB<P>::AABB(const P& center, typename P::value_type halfWidth, typename P::value_type halfHeight)
+  : m_center(center)
+  , m_halfWidth(halfWidth)
+  , m_halfHeight(halfHeight) {}
 
 template <typename P>
 bool  AABB<P>::containsPoint(const P& p) const {
-  return (std::fabs(m_center.x - p.x) <= m_halfDimension) &&
-         (std::fabs(m_center.y - p.y) <= m_halfDimension);
+  return (std::fabs(m_center.x - p.x) <= m_halfWidth) &&
+         (std::fabs(m_center.y - p.y) <= m_halfHeight);
 }
 
 template <typename P>
 bool AABB<P>::intersectsAABB(const AABB& other) const {
-  return (std::fabs(m_center.x - other.m_center.x) <= m_halfDimension + other.m_halfDimension) &&
-         (std::fabs(m_center.y - other.m_center.y) <= m_halfDimension + other.m_halfDimension);
+  return (std::fabs(m_center.x - other.m_center.x) <= m_halfWidth + other.m_halfWidth) &&
+         (std::fabs(m_center.y - other.m_center.y) <= m_halfHeight + other.m_halfHeight);
 }
 
+template <typename P>
+bool AABB<P>::containsAABB(const AABB& other) const {
+  return (std::fabs(m_center.x - other.m_center.x) + other.m_halfWidth <= m_halfWidth) &&
+         (std::fabs(m_center.y - other.m_center.y) + other.m_halfHeight <= m_halfHeight);
+}
 
+template <typename P>
+bool AABB<P>::intersectsSegment(const P& a, const P& b) const {
+  const AABB box = boundingBox(a, b);
+  if (!intersectsAABB(box))
+    return false;
 
-// QuadTree implementation
+  // the boxes overlap, so the segment misses only if all 4 corners are on one side of its line,
+  // relative to the middle of the segment, to get the same for a, b and b, a
+  typedef typename P::value_type value_type;
+  const value_type dx = b.x - a.x, dy = b.y - a.y;
+  const value_type cx = m_center.x - box.m_center.x, cy = m_center.y - box.m_center.y;
+  const value_type side = dx * cy - dy * cx; // of the center
+  const value_type spread = std::fabs(dx) * m_halfHeight + std::fabs(dy) * m_halfWidth; // of the corners around it
+  return std::fabs(side) <= spread;
+}
 
 template <typename P>
-QuadTree<P>::QuadTree(const AABB<P>& boundary)
-  : m_boundary(boundary)
-  , m_points()
-  , m_northWest(0)
-  , m_northEast(0)
-  , m_southWest(0)
-  , m_southEast(0) {
-    m_points.reserve(m_node_capacity);
+AABB<P> boundingBox(const P& a, const P& b) {
+  return AABB<P>(P((a.x + b.x) / 2, (a.y + b.y) / 2), std::fabs(b.x - a.x) / 2, std::fabs(b.y - a.y) / 2);
+}
+
+
+
+// detail::insideMask implementation
+
+template <typename T>
+unsigned detail::insideMask(const T* xs, const T* ys, T x, T y, T hx, T hy)
+{
+  unsigned mask = 0;
+  for (std::size_t i = 0; i < simd_width; ++i)
+    mask |= unsigned(std::fabs(xs[i] - x) <= hx && std::fabs(ys[i] - y) <= hy) << i;
+  return mask;
+}
+
+#if defined(__AVX__)
+
+template <>
+inline unsigned detail::insideMask<float>(const float* xs, const float* ys, float x, float y, float hx, float hy)
+{
+  // the absolute value clears the sign bit, an ordered compare is false for NaN, as the scalar one
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 dx = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(xs), _mm256_set1_ps(x)));
+  const __m256 dy = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(ys), _mm256_set1_ps(y)));
+  const __m256 in = _mm256_and_ps(_mm256_cmp_ps(dx, _mm256_set1_ps(hx), _CMP_LE_OQ),
+                                  _mm256_cmp_ps(dy, _mm256_set1_ps(hy), _CMP_LE_OQ));
+  return unsigned(_mm256_movemask_ps(in));
+}
+
+#elif defined(__SSE2__)
+
+template <>
+inline unsigned detail::insideMask<float>(const float* xs, const float* ys, float x, float y, float hx, float hy)
+{
+  // the absolute value clears the sign bit, an ordered compare is false for NaN, as the scalar one
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 cx = _mm_set1_ps(x), cy = _mm_set1_ps(y), h = _mm_set1_ps(hx), v = _mm_set1_ps(hy);
+  unsigned mask = 0;
+  for (std::size_t i = 0; i < simd_width; i += 4) {
+    const __m128 dx = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(xs + i), cx));
+    const __m128 dy = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(ys + i), cy));
+    mask |= unsigned(_mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(dx, h), _mm_cmple_ps(dy, v)))) << i;
   }
+  return mask;
+}
+
+#endif
+
+
+
+// detail::Quad implementation
 
 template <typename P>
-QuadTree<P>::QuadTree(const QuadTree& other)
-  : m_boundary (other.m_boundary)
-  , m_points   (other.m_points)
-  , m_northWest(other.m_northWest)
-  , m_northEast(other.m_northEast)
-  , m_southWest(other.m_southWest)
-  , m_southEast(other.m_southEast) {}
+detail::Quad<P> detail::Quad<P>::child(std::size_t i) const
+{
+  // create four children that fully divide this quad into four quads of equal area: NW, NE, SW, SE
+  // multiplied with +-1 instead of branching, the quadrant of a point is unpredictable
+  Quad q;
+  q.hx = hx / 2;
+  q.hy = hy / 2;
+  q.x = x + q.hx * value_type(int(i & 1) * 2 - 1);
+  q.y = y + q.hy * value_type(int(i & 2) - 1);
+  return q;
+}
 
+/// The child centers are exact, so that the points sorted into a child by the
+/// comparison with the center are inside of it.
 template <typename P>
-QuadTree<P>::QuadTree(QuadTree&& other)
-  : m_boundary (std::move(other.m_boundary))
-  , m_points   (std::move(other.m_points))
-  , m_northWest(std::move(other.m_northWest))
-  , m_northEast(std::move(other.m_northEast))
-  , m_southWest(std::move(other.m_southWest))
-  , m_southEast(std::move(other.m_southEast)) {}
+bool detail::Quad<P>::divisible() const
+{
+  const value_type h = hx / 2, v = hy / 2;
+  return h > 0 && v > 0 && (x + h) - x == h && x - (x - h) == h && (y + v) - y == v && y - (y - v) == v;
+}
 
 template <typename P>
-void QuadTree<P>::swap(QuadTree& other) {
-  std::swap(m_boundary,  other.m_boundary);
-  std::swap(m_points,    other.m_points);
-  std::swap(m_northWest, other.m_northWest);
-  std::swap(m_northEast, other.m_northEast);
-  std::swap(m_southWest, other.m_southWest);
-  std::swap(m_southEast, other.m_southEast);
+bool detail::Quad<P>::intersects(const AABB<P>& range) const
+{
+  return (std::fabs(x - range.m_center.x) <= hx + range.m_halfWidth) &&
+         (std::fabs(y - range.m_center.y) <= hy + range.m_halfHeight);
 }
 
 template <typename P>
-QuadTree<P>::~QuadTree() {
-  delete m_northWest;
-  delete m_northEast;
-  delete m_southWest;
-  delete m_southEast;
+bool detail::Quad<P>::inside(const AABB<P>& range) const
+{
+  return (std::fabs(x - range.m_center.x) + hx <= range.m_halfWidth) &&
+         (std::fabs(y - range.m_center.y) + hy <= range.m_halfHeight);
+}
+
+template <typename P>
+typename detail::Quad<P>::value_type detail::Quad<P>::squaredDistance(const P& p) const
+{
+  const value_type dx = std::max<value_type>(std::fabs(p.x - x) - hx, 0);
+  const value_type dy = std::max<value_type>(std::fabs(p.y - y) - hy, 0);
+  return dx * dx + dy * dy;
+}
+
+
+
+// detail::snapInterval implementation
+
+template <typename T>
+bool detail::snapInterval(T low, T high, T& center, T& half)
+{
+  half = 1;
+  while (half < high - low)
+    half *= 2;
+  while (half / 2 >= high - low && half / 2 > 0)
+    half /= 2;
+
+  // the difference high - low is rounded, the test of the sides is not
+  while (std::isfinite(half)) {
+    center = (std::floor(low / half) + 1) * half;
+    if (std::isfinite(center) && center - half <= low && high <= center + half)
+      return true;
+    half *= 2;
+  }
+  return false;
+}
+
+
+
+// QuadTree implementation
+
+template <typename P>
+const typename QuadTree<P>::size_type QuadTree<P>::max_depth;
+
+template <typename P>
+const typename QuadTree<P>::size_type QuadTree<P>::max_growth;
+
+template <typename P>
+const typename QuadTree<P>::size_type QuadTree<P>::max_height;
+
+template <typename P>
+QuadTree<P>::QuadTree(const AABB<P>& boundary, size_type leaf_capacity, BoundsMode mode)
+  : m_root()
+  , m_leaf_capacity(std::max<size_type>(leaf_capacity, 1))
+  , m_mode(mode)
+  , m_size(0)
+  , m_height(0)
+  , m_nodes()
+  , m_points()
+  , m_xs()
+  , m_ys()
+  , m_next_block()
+  , m_free_block(detail::quad_npos)
+  , m_free_children(detail::quad_npos)
+  , m_number_of_free_nodes(0)
+{
+  m_root.x = boundary.m_center.x;
+  m_root.y = boundary.m_center.y;
+  m_root.hx = boundary.m_halfWidth;
+  m_root.hy = boundary.m_halfHeight;
+  clear();
+}
+
+template <typename P>
+QuadTree<P>::QuadTree(const AABB<P>& boundary, const std::vector<P>& points, size_type leaf_capacity,
+                      BoundsMode mode)
+  : QuadTree(boundary, leaf_capacity, mode)
+{
+  if (m_mode == GROWING_BOUNDS && !points.empty()) {
+    // the tree is empty, so growing only moves the root
+    P low = points.front(), high = points.front();
+    for (const P& p : points) {
+      low.x = std::min(low.x, p.x);
+      low.y = std::min(low.y, p.y);
+      high.x = std::max(high.x, p.x);
+      high.y = std::max(high.y, p.y);
+    }
+    grow(low);
+    grow(high);
+  }
+
+  std::vector<std::uint64_t> keys;
+  keys.reserve(points.size());
+  for (std::size_t i = 0; i < points.size(); ++i)
+    if (m_root.contains(points[i]))
+      keys.push_back(i);
+
+  m_nodes.reserve(2 * keys.size() / m_leaf_capacity + 1);
+  m_points.reserve(keys.size() + keys.size() / 2);
+  m_xs.reserve(m_points.capacity() + detail::simd_width);
+  m_ys.reserve(m_points.capacity() + detail::simd_width);
+  bulkLoad(0, m_root, 0, points, keys.data(), keys.size());
+  m_size = keys.size();
+}
+
+template <typename P>
+void QuadTree<P>::clear()
+{
+  m_size = 0;
+  m_height = 0;
+  m_nodes.assign(1, Node());
+  m_nodes[0].first_child = detail::quad_npos;
+  m_nodes[0].block = detail::quad_npos;
+  m_nodes[0].count = 0;
+  m_points.clear();
+  m_xs.assign(detail::simd_width, 0);
+  m_ys.assign(detail::simd_width, 0);
+  m_next_block.clear();
+  m_free_block = detail::quad_npos;
+  m_free_children = detail::quad_npos;
+  m_number_of_free_nodes = 0;
 }
 
 template <typename P>
 bool QuadTree<P>::insert(const P& p) {
   // Ignore objects that do not belong in this quad tree
-  if (!m_boundary.containsPoint(p))
+  if (!m_root.contains(p) && (m_mode == FIXED_BOUNDS || !grow(p)))
     return false; // object cannot be added
 
-  // If there is space in this quad tree, add the object here
-  if (m_points.size() < m_node_capacity) {
-    m_points.push_back(p);
-    return true;
+  index_type node = 0;
+  Quad quad = m_root;
+  size_type depth = 0;
+  while (true) {
+    while (m_nodes[node].first_child != detail::quad_npos) {
+      ++m_nodes[node].count;
+      const std::size_t i = quadrant(quad, p);
+      node = m_nodes[node].first_child + index_type(i);
+      quad = quad.child(i);
+      ++depth;
+    }
+
+    // If there is space in this leaf, or it can not be split any more, add the object here
+    if (m_nodes[node].count < m_leaf_capacity || depth >= max_depth || !quad.divisible()) {
+      append(node, p);
+      ++m_size;
+      return true;
+    }
+
+    // Otherwise, subdivide and then add the point to the child that will accept it
+    split(node, quad, depth);
+  }
+}
+
+template <typename P>
+bool QuadTree<P>::remove(const P& p) {
+  if (!m_root.contains(p))
+    return false;
+
+  // the internal nodes on the way down, their counts drop once the point is found
+  index_type path[max_height];
+  size_type depth = 0;
+  index_type node = 0;
+  Quad quad = m_root;
+  while (m_nodes[node].first_child != detail::quad_npos) {
+    path[depth++] = node;
+    const std::size_t i = quadrant(quad, p);
+    node = m_nodes[node].first_child + index_type(i);
+    quad = quad.child(i);
   }
 
-  // Otherwise, subdivide and then add the point to whichever node will accept it
-  if (m_northWest == 0)
-    subdivide();
+  const std::size_t slot = findInLeaf(node, p);
+  if (slot == detail::quad_npos)
+    return false;
 
-  if (m_northWest->insert(p)) return true;
-  if (m_northEast->insert(p)) return true;
-  if (m_southWest->insert(p)) return true;
-  if (m_southEast->insert(p)) return true;
+  removeFromLeaf(node, slot);
+  --m_size;
+  for (size_type d = 0; d < depth; ++d)
+    --m_nodes[path[d]].count;
 
-  // Otherwise, the point cannot be inserted for some unknown reason (this should never happen)
-  assert(!"Programming error");
-  return false;
+  // the topmost node that fell below the capacity takes over all points below it
+  for (size_type d = 0; d < depth; ++d)
+    if (m_nodes[path[d]].count < m_leaf_capacity) {
+      merge(path[d]);
+      break;
+    }
+
+  return true;
 }
 
-// create four children that fully divide this quad into four quads of equal area
 template <typename P>
-void QuadTree<P>:: subdivide() {
-  const typename P::value_type h = m_boundary.m_halfDimension / 2;
-  const typename P::value_type x = m_boundary.m_center.x;
-  const typename P::value_type y = m_boundary.m_center.y;
-  m_northWest = new QuadTree<P>(AABB<P>(P(x - h, y - h), h));
-  m_northEast = new QuadTree<P>(AABB<P>(P(x + h, y - h), h));
-  m_southWest = new QuadTree<P>(AABB<P>(P(x - h, y + h), h));
-  m_southEast = new QuadTree<P>(AABB<P>(P(x + h, y + h), h));
+bool QuadTree<P>::move(const P& from, const P& to) {
+  if (!m_root.contains(from))
+    return false;
+
+  if (!m_root.contains(to)) {
+    // growing keeps from inside, so it can be put back if to does not fit
+    if (m_mode == FIXED_BOUNDS || !remove(from))
+      return false;
+    if (insert(to))
+      return true;
+    insert(from);
+    return false;
+  }
+
+  index_type node = 0;
+  Quad quad = m_root;
+  while (m_nodes[node].first_child != detail::quad_npos) {
+    const std::size_t i = quadrant(quad, from);
+    if (quadrant(quad, to) != i)
+      return remove(from) && insert(to);
+    node = m_nodes[node].first_child + index_type(i);
+    quad = quad.child(i);
+  }
+
+  const std::size_t slot = findInLeaf(node, from);
+  if (slot == detail::quad_npos)
+    return false;
+
+  setPoint(slot, to);
+  return true;
 }
 
 template <typename P>
 std::vector<P> QuadTree<P>::queryRange(const AABB<P>& range) const {
-
-  // Prepare an array of results
   std::vector<P> pointsInRange;
-
-  // Automatically abort if the range does not intersect this quad
-  if (!m_boundary.intersectsAABB(range))
-    return pointsInRange; // empty list
-
-  // Check objects at this quad level
-  for (std::size_t p = 0; p < m_points.size(); ++p)
-    if (range.containsPoint(m_points[p]))
-      pointsInRange.push_back(m_points[p]);
-
-  // Terminate here, if there are no children
-  if (m_northWest == 0)
-    return pointsInRange;
-
-  // Otherwise, add the points from the children
-  const std::vector<P> nw = m_northWest->queryRange(range);
-  pointsInRange.insert(pointsInRange.end(), nw.begin(), nw.end());
-  const std::vector<P> ne = m_northEast->queryRange(range);
-  pointsInRange.insert(pointsInRange.end(), ne.begin(), ne.end());
-  const std::vector<P> sw = m_southWest->queryRange(range);
-  pointsInRange.insert(pointsInRange.end(), sw.begin(), sw.end());
-  const std::vector<P> se = m_southEast->queryRange(range);
-  pointsInRange.insert(pointsInRange.end(), se.begin(), se.end());
-
+  queryRange(range, std::back_inserter(pointsInRange));
   return pointsInRange;
 }
 
 template <typename P>
 std::vector<P> QuadTree<P>::points() const {
-  std::vector<P> retval(m_points.begin(), m_points.end());
+  std::vector<P> retval;
+  retval.reserve(m_size);
+  for (const Node& n : m_nodes)
+    if (n.first_child == detail::quad_npos)
+      forEachInLeaf(n, [&retval](const P& p) { retval.push_back(p); });
 
-  // Terminate here, if there are no children
-  if (m_northWest == 0)
+  return retval;
+}
+
+template <typename P>
+template <typename OutputIt>
+OutputIt QuadTree<P>::queryRange(const AABB<P>& range, OutputIt out) const {
+  forEachInRange(range, [&out](const P& p) { *out++ = p; });
+  return out;
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachInRange(const AABB<P>& range, F f) const {
+  forEachNodeInRange(range, [&](index_type node, bool inside) {
+    if (inside) {
+      forEachInSubtree(node, f);
+      return;
+    }
+    forEachInLeafInRange(m_nodes[node], range, f);
+  });
+}
+
+template <typename P>
+typename QuadTree<P>::size_type QuadTree<P>::countRange(const AABB<P>& range) const {
+  size_type count = 0;
+  forEachNodeInRange(range, [&](index_type node, bool inside) {
+    if (inside) {
+      count += m_nodes[node].count;
+      return;
+    }
+    count += countInLeaf(m_nodes[node], range);
+  });
+  return count;
+}
+
+template <typename P>
+std::vector<std::vector<P> > QuadTree<P>::queryRanges(const std::vector<AABB<P> >& ranges) const {
+  std::vector<std::vector<P> > retval(ranges.size());
+  forEachInRanges(ranges, [&retval](std::size_t r, const P& p) { retval[r].push_back(p); });
+  return retval;
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachInRanges(const std::vector<AABB<P> >& ranges, F f) const {
+  forEachNodeInRanges(ranges, [&](index_type node, std::size_t r, bool inside) {
+    auto g = [&f, r](const P& p) { f(r, p); };
+    if (inside)
+      forEachInSubtree(node, g);
+    else
+      forEachInLeafInRange(m_nodes[node], ranges[r], g);
+  });
+}
+
+template <typename P>
+std::vector<typename QuadTree<P>::size_type> QuadTree<P>::countRanges(const std::vector<AABB<P> >& ranges) const {
+  std::vector<size_type> counts(ranges.size(), 0);
+  forEachNodeInRanges(ranges, [&](index_type node, std::size_t r, bool inside) {
+    counts[r] += inside ? m_nodes[node].count : countInLeaf(m_nodes[node], ranges[r]);
+  });
+  return counts;
+}
+
+template <typename P>
+std::vector<P> QuadTree<P>::nearestNeighbours(const P& p, size_type k) const {
+  std::vector<P> retval;
+  if (k == 0 || m_size == 0)
     return retval;
 
-  // Otherwise, add the points from the children
-  const std::vector<P> nw = m_northWest->points();
-  retval.insert(retval.end(), nw.begin(), nw.end());
-  const std::vector<P> ne = m_northEast->points();
-  retval.insert(retval.end(), ne.begin(), ne.end());
-  const std::vector<P> sw = m_southWest->points();
-  retval.insert(retval.end(), sw.begin(), sw.end());
-  const std::vector<P> se = m_southEast->points();
-  retval.insert(retval.end(), se.begin(), se.end());
+  // min-heap of the nodes to visit, max-heap of the best k points so far, both by squared distance
+  typedef std::pair<value_type, index_type> node_entry;
+  typedef std::pair<value_type, const P*> point_entry;
+  std::vector<std::pair<node_entry, Quad> > nodes;
+  std::vector<point_entry> best;
+  best.reserve(k + 1);
+
+  auto nodeGreater = [](const std::pair<node_entry, Quad>& a, const std::pair<node_entry, Quad>& b) { return a.first > b.first; };
+  auto pointLess = [](const point_entry& a, const point_entry& b) { return a.first < b.first; };
 
+  nodes.push_back(std::make_pair(node_entry(m_root.squaredDistance(p), 0), m_root));
+  while (!nodes.empty()) {
+    std::pop_heap(nodes.begin(), nodes.end(), nodeGreater);
+    const value_type distance = nodes.back().first.first;
+    const index_type node = nodes.back().first.second;
+    const Quad quad = nodes.back().second;
+    nodes.pop_back();
+
+    if (best.size() == k && distance > best.front().first)
+      break; // every other point is farther
+
+    const Node& n = m_nodes[node];
+    if (n.first_child == detail::quad_npos) {
+      forEachInLeaf(n, [&](const P& q) {
+        const value_type d = squaredDistance(p, q);
+        if (best.size() == k && d >= best.front().first)
+          return;
+        best.push_back(point_entry(d, &q));
+        std::push_heap(best.begin(), best.end(), pointLess);
+        if (best.size() > k) {
+          std::pop_heap(best.begin(), best.end(), pointLess);
+          best.pop_back();
+        }
+      });
+      continue;
+    }
+
+    for (index_type i = 0; i < 4; ++i) {
+      if (m_nodes[n.first_child + i].count == 0)
+        continue;
+      const Quad child = quad.child(i);
+      nodes.push_back(std::make_pair(node_entry(child.squaredDistance(p), n.first_child + i), child));
+      std::push_heap(nodes.begin(), nodes.end(), nodeGreater);
+    }
+  }
+
+  std::sort_heap(best.begin(), best.end(), pointLess);
+  retval.reserve(best.size());
+  for (const auto& b : best)
+    retval.push_back(*b.second);
+
+  return retval;
+}
+
+template <typename P>
+std::vector<P> QuadTree<P>::queryRadius(const P& center, value_type radius) const {
+  std::vector<P> retval;
+  forEachInRadius(center, radius, [&retval](const P& p) { retval.push_back(p); });
   return retval;
 }
 
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachInRadius(const P& center, value_type radius, F f) const {
+  const value_type squared_radius = radius * radius;
+  forEachInRange(AABB<P>(center, radius), [&](const P& p) {
+    if (squaredDistance(center, p) <= squared_radius)
+      f(p);
+  });
+}
+
+template <typename P>
+std::uint32_t QuadTree<P>::mortonCode(Quad quad, const P& p, size_type levels)
+{
+  // below a quad that is not divisible the digits are arbitrary, the tree stops there anyway
+  std::uint32_t code = 0;
+  for (size_type level = 0; level < levels; ++level) {
+    const std::size_t i = quadrant(quad, p);
+    code = (code << 2) | std::uint32_t(i);
+    quad = quad.child(i);
+  }
+  return code;
+}
+
+template <typename P>
+void QuadTree<P>::bulkLoad(index_type node, const Quad& quad, size_type depth, const std::vector<P>& points,
+                           std::uint64_t* keys, std::size_t n)
+{
+  if (n <= m_leaf_capacity || depth >= max_depth || !quad.divisible()) {
+    for (std::size_t i = 0; i < n; ++i)
+      append(node, points[std::uint32_t(keys[i])]);
+    return;
+  }
+
+  // just deep enough for leaves of leaf_capacity points if they were spread evenly,
+  // the nodes still too full are sorted again with codes below them
+  size_type levels = 1;
+  while (levels < 16 && depth + levels < max_depth && (n >> (2 * levels)) > m_leaf_capacity)
+    ++levels;
+
+  parallelFor(n, 1 << 14, [&](std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+      const std::uint64_t index = std::uint32_t(keys[i]);
+      keys[i] = (std::uint64_t(mortonCode(quad, points[index], levels)) << 32) | index;
+    }
+  });
+  if (n < 1024)
+    std::sort(keys, keys + n); // the index is the tie break, the same order as the stable radix sort
+  else
+    parallelRadixSort(keys, n, 32, 32 + 2 * unsigned(levels));
+
+  buildSorted(node, quad, depth, 0, levels, points, keys, n);
+}
+
+template <typename P>
+void QuadTree<P>::buildSorted(index_type node, const Quad& quad, size_type depth, size_type level, size_type levels,
+                              const std::vector<P>& points, std::uint64_t* keys, std::size_t n)
+{
+  // same rule as insert: a leaf is split once it holds more than leaf_capacity points
+  if (level == levels || n <= m_leaf_capacity || depth >= max_depth || !quad.divisible()) {
+    bulkLoad(node, quad, depth, points, keys, n);
+    return;
+  }
+
+  const index_type first_child = allocateChildren();
+  m_nodes[node].first_child = first_child;
+  m_nodes[node].count = index_type(n);
+  m_height = std::max(m_height, depth + 1);
+
+  // the points of the children are consecutive ranges of the sorted keys
+  const std::size_t shift = 32 + 2 * (levels - 1 - level);
+  std::size_t begin = 0;
+  for (index_type i = 0; i < 4; ++i) {
+    const std::size_t end = std::partition_point(keys + begin, keys + n,
+        [shift, i](std::uint64_t k) { return ((k >> shift) & 3) <= i; }) - keys;
+    buildSorted(first_child + i, quad.child(i), depth + 1, level + 1, levels, points, keys + begin, end - begin);
+    begin = end;
+  }
+}
+
+template <typename P>
+bool QuadTree<P>::grow(const P& p)
+{
+  while (!m_root.contains(p))
+    if (!growTowards(p))
+      return false;
+
+  return true;
+}
+
+template <typename P>
+bool QuadTree<P>::growTowards(const P& p)
+{
+  if (!std::isfinite(p.x) || !std::isfinite(p.y))
+    return false;
+
+  Quad root;
+  root.hx = m_root.hx * 2;
+  root.hy = m_root.hy * 2;
+  root.x = p.x < m_root.x ? m_root.x - m_root.hx : m_root.x + m_root.hx;
+  root.y = p.y < m_root.y ? m_root.y - m_root.hy : m_root.y + m_root.hy;
+
+  // the old root has to be exactly one of the children
+  const std::size_t i = quadrant(root, P(m_root.x, m_root.y));
+  const Quad child = root.child(i);
+  if (child.x != m_root.x || child.y != m_root.y || child.hx != m_root.hx || child.hy != m_root.hy)
+    return snapRoot(p);
+  if (m_height >= max_height)
+    return false;
+
+  if (m_nodes[0].first_child != detail::quad_npos) {
+    // points on the low sides of the old root would be sorted into the lower children
+    // of the new one, so they are taken out, and inserted again below it
+    std::vector<P> on_edge;
+    const bool low_x = root.x < m_root.x, low_y = root.y < m_root.y;
+    if (low_x || low_y) {
+      StackEntry stack[3 * max_height + 4];
+      std::size_t top = 0;
+      StackEntry e = { 0, false, m_root };
+      stack[top++] = e;
+      while (top > 0) {
+        e = stack[--top];
+        const Node& n = m_nodes[e.node];
+        if (n.first_child == detail::quad_npos) {
+          forEachInLeaf(n, [&](const P& q) {
+            if ((low_x && q.x == root.x) || (low_y && q.y == root.y))
+              on_edge.push_back(q);
+          });
+          continue;
+        }
+        for (index_type c = 0; c < 4; ++c)
+          if (m_nodes[n.first_child + c].count > 0 && ((low_x && !(c & 1)) || (low_y && !(c & 2)))) {
+            const StackEntry next = { index_type(n.first_child + c), false, e.quad.child(c) };
+            stack[top++] = next;
+          }
+      }
+    }
+    for (const P& q : on_edge)
+      remove(q);
+
+    // removing may have merged the root into a leaf
+    if (m_nodes[0].first_child != detail::quad_npos) {
+      const index_type first_child = allocateChildren();
+      m_nodes[first_child + i] = m_nodes[0];
+      m_nodes[0].first_child = first_child;
+      m_nodes[0].block = detail::quad_npos;
+      ++m_height;
+    }
+    m_root = root;
+    for (const P& q : on_edge)
+      insert(q);
+    return true;
+  }
+
+  // a leaf holds its points in any order, it just gets the new boundary
+  m_root = root;
+  return true;
+}
+
+template <typename P>
+bool QuadTree<P>::snapRoot(const P& p)
+{
+  const std::vector<P> all = points();
+  P low(std::min(m_root.x - m_root.hx, p.x), std::min(m_root.y - m_root.hy, p.y));
+  P high(std::max(m_root.x + m_root.hx, p.x), std::max(m_root.y + m_root.hy, p.y));
+  for (const P& q : all) { // the sides of the old root are rounded
+    low.x = std::min(low.x, q.x);
+    low.y = std::min(low.y, q.y);
+    high.x = std::max(high.x, q.x);
+    high.y = std::max(high.y, q.y);
+  }
+
+  Quad root;
+  if (!detail::snapInterval(low.x, high.x, root.x, root.hx) || !detail::snapInterval(low.y, high.y, root.y, root.hy))
+    return false;
+
+  clear();
+  m_root = root;
+  for (const P& q : all)
+    insert(q);
+  return true;
+}
+
+template <typename P>
+void QuadTree<P>::append(index_type node, const P& p)
+{
+  Node& n = m_nodes[node];
+  const std::size_t slot = n.count % m_leaf_capacity;
+  if (slot == 0) { // the first block is full, or there is none
+    const index_type block = allocateBlock();
+    m_next_block[block] = m_nodes[node].block;
+    m_nodes[node].block = block;
+  }
+
+  setPoint(std::size_t(m_nodes[node].block) * m_leaf_capacity + slot, p);
+  ++m_nodes[node].count;
+}
+
+template <typename P>
+void QuadTree<P>::split(index_type node, const Quad& quad, size_type depth)
+{
+  const index_type first_child = allocateChildren();
+  m_height = std::max(m_height, depth + 1);
+  const Node old = m_nodes[node];
+  m_nodes[node].first_child = first_child;
+  m_nodes[node].block = detail::quad_npos;
+
+  // the children take at most 4 blocks more than the leaf, so the points read are not moved by a resize
+  const std::size_t needed = m_points.size() + ((old.count + m_leaf_capacity - 1) / m_leaf_capacity + 4) * m_leaf_capacity;
+  if (needed > m_points.capacity())
+    m_points.reserve(std::max(needed, 2 * m_points.capacity()));
+  forEachInLeaf(old, [&](const P& p) { append(first_child + index_type(quadrant(quad, p)), p); });
+  freeBlocks(old.block);
+
+  // all points in one child: that one has to be split further
+  for (index_type i = 0; i < 4; ++i)
+    if (m_nodes[first_child + i].count > m_leaf_capacity && depth + 1 < max_depth && quad.child(i).divisible())
+      split(first_child + i, quad.child(i), depth + 1);
+}
+
+template <typename P>
+void QuadTree<P>::merge(index_type node)
+{
+  // fewer than leaf_capacity points, they fit into one block
+  const index_type block = m_nodes[node].count == 0 ? detail::quad_npos : allocateBlock();
+  std::size_t slot = std::size_t(block) * m_leaf_capacity;
+  forEachInSubtree(node, [&](const P& p) { setPoint(slot++, p); });
+
+  index_type stack[3 * max_height + 4];
+  std::size_t top = 0;
+  stack[top++] = m_nodes[node].first_child;
+  while (top > 0) {
+    const index_type first_child = stack[--top];
+    for (index_type i = 0; i < 4; ++i) {
+      const Node& child = m_nodes[first_child + i];
+      if (child.first_child != detail::quad_npos)
+        stack[top++] = child.first_child;
+      else
+        freeBlocks(child.block);
+    }
+    freeChildren(first_child);
+  }
+
+  m_nodes[node].first_child = detail::quad_npos;
+  m_nodes[node].block = block;
+  if (block != detail::quad_npos)
+    m_next_block[block] = detail::quad_npos;
+  if (node == 0)
+    m_height = 0;
+}
+
+template <typename P>
+std::size_t QuadTree<P>::findInLeaf(index_type node, const P& p) const
+{
+  const Node& n = m_nodes[node];
+  std::size_t in_block = n.count == 0 ? 0 : (n.count - 1) % m_leaf_capacity + 1;
+  for (index_type block = n.block; block != detail::quad_npos; block = m_next_block[block]) {
+    const std::size_t first = std::size_t(block) * m_leaf_capacity;
+    for (std::size_t i = first; i < first + in_block; ++i)
+      if (m_points[i].x == p.x && m_points[i].y == p.y)
+        return i;
+    in_block = m_leaf_capacity;
+  }
+  return detail::quad_npos;
+}
+
+template <typename P>
+void QuadTree<P>::removeFromLeaf(index_type node, std::size_t slot)
+{
+  // the last point of the first block fills the gap
+  Node& n = m_nodes[node];
+  setPoint(slot, m_points[std::size_t(n.block) * m_leaf_capacity + (n.count - 1) % m_leaf_capacity]);
+  --n.count;
+
+  if (n.count % m_leaf_capacity == 0) { // the first block is empty now
+    const index_type block = n.block;
+    n.block = m_next_block[block];
+    m_next_block[block] = m_free_block;
+    m_free_block = block;
+  }
+}
+
+template <typename P>
+typename QuadTree<P>::index_type QuadTree<P>::allocateBlock()
+{
+  if (m_free_block != detail::quad_npos) {
+    const index_type block = m_free_block;
+    m_free_block = m_next_block[block];
+    return block;
+  }
+
+  m_points.resize(m_points.size() + m_leaf_capacity, P(0, 0));
+  m_xs.resize(m_points.size() + detail::simd_width, 0);
+  m_ys.resize(m_points.size() + detail::simd_width, 0);
+  m_next_block.push_back(detail::quad_npos);
+  return index_type(m_next_block.size() - 1);
+}
+
+template <typename P>
+void QuadTree<P>::freeBlocks(index_type block)
+{
+  while (block != detail::quad_npos) {
+    const index_type next = m_next_block[block];
+    m_next_block[block] = m_free_block;
+    m_free_block = block;
+    block = next;
+  }
+}
+
+template <typename P>
+typename QuadTree<P>::index_type QuadTree<P>::allocateChildren()
+{
+  Node leaf;
+  leaf.first_child = detail::quad_npos;
+  leaf.block = detail::quad_npos;
+  leaf.count = 0;
+
+  if (m_free_children == detail::quad_npos) {
+    m_nodes.insert(m_nodes.end(), 4, leaf);
+    return index_type(m_nodes.size() - 4);
+  }
+
+  const index_type first_child = m_free_children;
+  m_free_children = m_nodes[first_child].first_child;
+  m_number_of_free_nodes -= 4;
+  std::fill(m_nodes.begin() + first_child, m_nodes.begin() + first_child + 4, leaf);
+  return first_child;
+}
+
+template <typename P>
+void QuadTree<P>::freeChildren(index_type first_child)
+{
+  // empty, so that points() finds nothing in them
+  for (index_type i = 0; i < 4; ++i) {
+    m_nodes[first_child + i].first_child = detail::quad_npos;
+    m_nodes[first_child + i].block = detail::quad_npos;
+    m_nodes[first_child + i].count = 0;
+  }
+  m_nodes[first_child].first_child = m_free_children;
+  m_free_children = first_child;
+  m_number_of_free_nodes += 4;
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachInLeaf(const Node& leaf, F f) const
+{
+  std::size_t in_block = leaf.count == 0 ? 0 : (leaf.count - 1) % m_leaf_capacity + 1;
+  for (index_type block = leaf.block; block != detail::quad_npos; block = m_next_block[block]) {
+    const P* first = m_points.data() + block * m_leaf_capacity;
+    for (std::size_t i = 0; i < in_block; ++i)
+      f(first[i]);
+    in_block = m_leaf_capacity;
+  }
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachInLeafInRange(const Node& leaf, const AABB<P>& range, F f) const
+{
+  std::size_t in_block = leaf.count == 0 ? 0 : (leaf.count - 1) % m_leaf_capacity + 1;
+  for (index_type block = leaf.block; block != detail::quad_npos; block = m_next_block[block]) {
+    const std::size_t first = std::size_t(block) * m_leaf_capacity;
+    for (std::size_t i = 0; i < in_block; i += detail::simd_width) {
+      unsigned mask = insideMask(first + i, range);
+      if (in_block - i < detail::simd_width) // the slots after the block, or the padding
+        mask &= (1u << (in_block - i)) - 1;
+      for (std::size_t j = i; mask != 0; ++j, mask >>= 1)
+        if (mask & 1)
+          f(m_points[first + j]);
+    }
+    in_block = m_leaf_capacity;
+  }
+}
+
+template <typename P>
+typename QuadTree<P>::size_type QuadTree<P>::countInLeaf(const Node& leaf, const AABB<P>& range) const
+{
+  size_type count = 0;
+  std::size_t in_block = leaf.count == 0 ? 0 : (leaf.count - 1) % m_leaf_capacity + 1;
+  for (index_type block = leaf.block; block != detail::quad_npos; block = m_next_block[block]) {
+    const std::size_t first = std::size_t(block) * m_leaf_capacity;
+    for (std::size_t i = 0; i < in_block; i += detail::simd_width) {
+      unsigned mask = insideMask(first + i, range);
+      if (in_block - i < detail::simd_width)
+        mask &= (1u << (in_block - i)) - 1;
+      count += std::bitset<detail::simd_width>(mask).count();
+    }
+    in_block = m_leaf_capacity;
+  }
+  return count;
+}
+
+template <typename P>
+unsigned QuadTree<P>::insideMask(std::size_t slot, const AABB<P>& range) const
+{
+  return detail::insideMask(m_xs.data() + slot, m_ys.data() + slot, range.m_center.x, range.m_center.y,
+                            range.m_halfWidth, range.m_halfHeight);
+}
+
+template <typename P>
+void QuadTree<P>::setPoint(std::size_t slot, const P& p)
+{
+  m_points[slot] = p;
+  m_xs[slot] = p.x;
+  m_ys[slot] = p.y;
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachNodeInRange(const AABB<P>& range, F f) const
+{
+  if (m_size == 0)
+    return;
+
+  // depth first, a level leaves at most 3 siblings behind on the stack
+  StackEntry stack[3 * max_height + 4];
+  std::size_t top = 0;
+  StackEntry root = { 0, false, m_root };
+  stack[top++] = root;
+  while (top > 0) {
+    const StackEntry e = stack[--top];
+    const Node& n = m_nodes[e.node];
+    if (n.count == 0)
+      continue;
+
+    // Automatically abort if the range does not intersect this quad
+    if (!e.inside && !e.quad.intersects(range))
+      continue;
+
+    const bool inside = e.inside || e.quad.inside(range);
+    if (inside || n.first_child == detail::quad_npos) {
+      f(e.node, inside);
+      continue;
+    }
+
+    for (index_type i = 0; i < 4; ++i) {
+      const StackEntry child = { index_type(n.first_child + 3 - i), false, e.quad.child(3 - i) };
+      stack[top++] = child;
+    }
+  }
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachInSubtree(index_type node, F f) const
+{
+  index_type stack[3 * max_height + 4];
+  std::size_t top = 0;
+  stack[top++] = node;
+  while (top > 0) {
+    const Node& n = m_nodes[stack[--top]];
+    if (n.first_child == detail::quad_npos) {
+      forEachInLeaf(n, f);
+      continue;
+    }
+    for (index_type i = 0; i < 4; ++i)
+      if (m_nodes[n.first_child + 3 - i].count > 0)
+        stack[top++] = n.first_child + 3 - i;
+  }
+}
+
+template <typename P>
+template <typename F>
+void QuadTree<P>::forEachNodeInRanges(const std::vector<AABB<P> >& ranges, F f) const
+{
+  if (m_size == 0 || ranges.empty())
+    return;
+
+  // the ranges a node passes on to its children are appended to active, the slices of
+  // the nodes on the stack are in stack order, so a popped node drops the ones after its own
+  std::vector<std::uint32_t> active(ranges.size());
+  for (std::size_t r = 0; r < ranges.size(); ++r)
+    active[r] = std::uint32_t(r);
+
+  RangesEntry stack[3 * max_height + 4];
+  std::size_t top = 0;
+  const RangesEntry root = { 0, m_root, 0, active.size() };
+  stack[top++] = root;
+  while (top > 0) {
+    const RangesEntry e = stack[--top];
+    const Node& n = m_nodes[e.node];
+    active.resize(e.end);
+    if (n.count == 0)
+      continue;
+
+    const std::size_t begin = active.size();
+    for (std::size_t a = e.begin; a < e.end; ++a) {
+      const std::uint32_t r = active[a];
+      if (!e.quad.intersects(ranges[r]))
+        continue;
+      const bool inside = e.quad.inside(ranges[r]);
+      if (inside || n.first_child == detail::quad_npos)
+        f(e.node, std::size_t(r), inside);
+      else
+        active.push_back(r);
+    }
+    if (active.size() == begin)
+      continue;
+
+    for (index_type i = 0; i < 4; ++i) {
+      const RangesEntry child = { index_type(n.first_child + 3 - i), e.quad.child(3 - i), begin, active.size() };
+      stack[top++] = child;
+    }
+  }
+}
+
 
 #endif // QUAD_TREE_HPP
@@ -0,0 +1,199 @@
+#ifndef SPATIAL_GRAPH_HPP
+#define SPATIAL_GRAPH_HPP
+
+#include "graph.hpp"
+#include "loose_quad_tree.hpp"
+#include "quad_tree.hpp"
+
+#include <unordered_set>
+#include <vector>
+
+#include <utility>
+
+/**
+  A \ref Graph of planar vertices, with its vertices in a \ref QuadTree and its
+  edges, as segments, in a \ref LooseQuadTree, both kept in sync with every
+  change. Looking a vertex up by position is a tree query instead of a scan
+  over all vertices.
+
+  The graph is only changed through the wrapper, graph() is read only. The
+  graph itself is changed last, so the arguments may refer into it, as to
+  neighboursOf a vertex.
+
+  V is a vertex type for \ref Graph with x and y members and a V(x, y) ctor,
+  as for \ref QuadTree, and two vertices are equal if their coordinates are.
+  The vertex tree grows with the vertices, edges centered outside of the
+  initial boundary are kept in the root of the edge tree, so they are found,
+  but tested by every query.
+*/
+template <typename V>
+class SpatialGraph {
+public:
+
+  typedef typename Graph<V>::Edge Edge;
+  typedef typename QuadTree<V>::size_type size_type;
+
+  explicit SpatialGraph(const AABB<V>& boundary, size_type leaf_capacity = 8);
+  /// Indexes a copy of graph, the vertices are bulk loaded.
+  SpatialGraph(const Graph<V>& graph, const AABB<V>& boundary, size_type leaf_capacity = 8);
+
+  const Graph<V>& graph() const { return m_graph; }
+  size_type numberOfVertices() const { return m_vertices.size(); }
+  bool contains(const V& v) const;
+
+  /// False if v is not a vertex afterwards: the vertex tree can not hold it, as a
+  /// point that is not finite.
+  bool addVertex(const V& v);
+  void removeVertex(const V& v);
+  /// Moves v with its edges, nothing happens if new_v is a vertex already, or the
+  /// vertex tree can not hold it.
+  void modifyVertex(const V& old_v, const V& new_v);
+  /// Nothing happens if one of the vertices can not be added.
+  void addEdge(const V& source, const V& destination);
+  void removeEdge(const V& source, const V& destination);
+  void clear();
+
+  /// The k vertices closest to p, nearest first.
+  std::vector<V> nearestVertices(const V& p, size_type k = 1) const { return m_vertices.nearestNeighbours(p, k); }
+  std::vector<V> verticesInBox(const AABB<V>& box) const { return m_vertices.queryRange(box); }
+  /// Edges crossing or touching box, each once, in one of its directions.
+  std::vector<Edge> edgesInBox(const AABB<V>& box) const;
+
+private:
+
+  void eraseSegment(const V& a, const V& b);
+
+  Graph<V> m_graph;
+  QuadTree<V> m_vertices;
+  LooseQuadTree<V, std::pair<V, V> > m_edges;
+};
+
+
+
+// SpatialGraph implementation
+
+template <typename V>
+SpatialGraph<V>::SpatialGraph(const AABB<V>& boundary, size_type leaf_capacity)
+  : m_graph()
+  , m_vertices(boundary, leaf_capacity, QuadTree<V>::GROWING_BOUNDS)
+  , m_edges(boundary, leaf_capacity)
+{
+}
+
+template <typename V>
+SpatialGraph<V>::SpatialGraph(const Graph<V>& graph, const AABB<V>& boundary, size_type leaf_capacity)
+  : m_graph(graph)
+  , m_vertices(boundary, graph.vertices(), leaf_capacity, QuadTree<V>::GROWING_BOUNDS)
+  , m_edges(boundary, leaf_capacity)
+{
+  // both directions are stored, take an edge when its second vertex comes
+  std::unordered_set<V> visited;
+  for (const V& v : m_graph) {
+    for (const V& n : m_graph.neighboursOf(v))
+      if (visited.count(n) > 0)
+        insertSegment(m_edges, v, n);
+    visited.insert(v);
+  }
+}
+
+template <typename V>
+bool SpatialGraph<V>::contains(const V& v) const
+{
+  return m_vertices.countRange(AABB<V>(v, 0)) > 0;
+}
+
+template <typename V>
+bool SpatialGraph<V>::addVertex(const V& v)
+{
+  if (contains(v))
+    return true;
+
+  if (!m_vertices.insert(v))
+    return false;
+  m_graph.addVertex(v);
+  return true;
+}
+
+template <typename V>
+void SpatialGraph<V>::removeVertex(const V& v)
+{
+  if (!contains(v))
+    return;
+
+  for (const V& n : m_graph.neighboursOf(v))
+    eraseSegment(v, n);
+  m_vertices.remove(v);
+  m_graph.removeVertex(v);
+}
+
+template <typename V>
+void SpatialGraph<V>::modifyVertex(const V& old_v, const V& new_v)
+{
+  if (old_v == new_v || !contains(old_v) || contains(new_v))
+    return;
+
+  const std::vector<V> neighbours = m_graph.neighboursOf(old_v);
+  for (const V& n : neighbours)
+    eraseSegment(old_v, n);
+
+  const bool moved = m_vertices.move(old_v, new_v);
+  for (const V& n : neighbours)
+    insertSegment(m_edges, moved ? new_v : old_v, n);
+  if (moved)
+    m_graph.modifyVertex(old_v, new_v);
+}
+
+template <typename V>
+void SpatialGraph<V>::addEdge(const V& source, const V& destination)
+{
+  if (source == destination || connected(m_graph, source, destination))
+    return;
+
+  const bool new_source = !contains(source);
+  if (!addVertex(source))
+    return;
+  if (!addVertex(destination)) {
+    if (new_source)
+      removeVertex(source);
+    return;
+  }
+
+  insertSegment(m_edges, source, destination);
+  m_graph.addEdge(source, destination);
+}
+
+template <typename V>
+void SpatialGraph<V>::removeEdge(const V& source, const V& destination)
+{
+  if (!connected(m_graph, source, destination))
+    return;
+
+  eraseSegment(source, destination);
+  m_graph.removeEdge(source, destination);
+}
+
+template <typename V>
+void SpatialGraph<V>::clear()
+{
+  m_graph.clear();
+  m_vertices.clear();
+  m_edges.clear();
+}
+
+template <typename V>
+std::vector<typename SpatialGraph<V>::Edge> SpatialGraph<V>::edgesInBox(const AABB<V>& box) const
+{
+  std::vector<Edge> retval;
+  forEachSegmentIntersecting(m_edges, box, [&retval](const V& a, const V& b) { retval.push_back(Edge(a, b)); });
+  return retval;
+}
+
+/// An edge is kept in the direction it was added in.
+template <typename V>
+void SpatialGraph<V>::eraseSegment(const V& a, const V& b)
+{
+  if (!removeSegment(m_edges, a, b))
+    removeSegment(m_edges, b, a);
+}
+
+#endif // SPATIAL_GRAPH_HPP
@@ -0,0 +1,198 @@
+#ifndef VISIBILITY_GRAPH_HPP
+#define VISIBILITY_GRAPH_HPP
+
+#include "graphwd.hpp"
+#include "marching_squares.hpp"
+
+#include <vector>
+
+#include <algorithm>
+#include <cmath>
+
+/**
+  Reduced visibility graph of an \ref ImageMatrix, for any-angle routes.
+
+  Continuous model: a cell is a unit square, FREE ones can be crossed, the
+  others and everything outside the image are obstacles. A line of sight may
+  run along an obstacle's side but not through its inside, and not through a
+  point where two obstacle cells touch only diagonally.
+
+  The vertices are the convex corners of the obstacles: lattice points with
+  exactly one of their 4 cells blocked. A shortest route only bends at such
+  corners, and only along a line touching the obstacle there (a bitangent), so
+  two corners are joined if the line between them is tangent at both and is a
+  line of sight. The weight is the euclidean distance.
+
+  Instead of a graph per pixel, the graph has a vertex per convex obstacle
+  corner; a map with rectangular rooms and pillars has a few thousand of them.
+  Building tests all corner pairs, O(n^2) pairs times the line length, so it is
+  meant to be done once per map; start and goal of a query are added with
+  \ref addVisibilityPoint.
+
+  V is constructed from the two coordinates, and exposes them as x and y.
+*/
+
+namespace detail {
+
+/// Blocked cell, or out of the image.
+inline bool visibilityBlocked(const ImageMatrix& image, long x, long y)
+{
+  if (x < 0 || y < 0 || x >= long(image.width_) || y >= long(image.height_))
+    return true;
+
+  return image.cells_[y * image.width_ + x] != ImageMatrix::FREE;
+}
+
+/// The cells whose closure holds coordinate c: 2 on a grid line, 1 inside.
+inline void visibilityCellRange(double c, long& first, long& last)
+{
+  const double r = std::floor(c + 0.5);
+  if (std::fabs(c - r) < 1e-9) {
+    first = long(r) - 1;
+    last = long(r);
+  } else {
+    first = last = long(std::floor(c));
+  }
+}
+
+/// A convex corner, quadrant is sx * sy of the direction towards its blocked cell.
+struct VisibilityCorner {
+  long x, y;
+  int quadrant;
+};
+
+} // detail namespace
+
+
+/// True if the straight line from a to b, in cell units, stays in the free space.
+/// Walks the grid lines it crosses in order (Amanatides and Woo), without allocating.
+inline bool lineOfSight(const ImageMatrix& image, double ax, double ay, double bx, double by)
+{
+  const double dx = bx - ax, dy = by - ay;
+
+  // the next vertical and horizontal grid line the line crosses, strictly between a and b,
+  // and the parameter of the crossing, 2 once there is none left
+  double kx = dx > 0.0 ? std::floor(ax) + 1.0 : std::ceil(ax) - 1.0;
+  double ky = dy > 0.0 ? std::floor(ay) + 1.0 : std::ceil(ay) - 1.0;
+  const double step_x = dx > 0.0 ? 1.0 : -1.0, step_y = dy > 0.0 ? 1.0 : -1.0;
+  auto crossing = [](double k, double a, double b, double d) {
+    return d != 0.0 && (d > 0.0 ? k < b : k > b) ? (k - a) / d : 2.0;
+  };
+  double tx = crossing(kx, ax, bx, dx), ty = crossing(ky, ay, by, dy);
+
+  // the cells between two consecutive crossings are the ones passed
+  double t0 = 0.0;
+  for (bool last = false; !last; ) {
+    double t1 = 1.0;
+    if (tx <= ty && tx <= 1.0) {
+      t1 = tx;
+      kx += step_x;
+      tx = crossing(kx, ax, bx, dx);
+    } else if (ty <= 1.0) {
+      t1 = ty;
+      ky += step_y;
+      ty = crossing(ky, ay, by, dy);
+    } else {
+      last = true;
+    }
+
+    if (t1 - t0 < 1e-12)
+      continue;
+
+    // one of the cells touching a piece of the line has to be free
+    const double t = 0.5 * (t0 + t1);
+    long x0, x1, y0, y1;
+    detail::visibilityCellRange(ax + t * dx, x0, x1);
+    detail::visibilityCellRange(ay + t * dy, y0, y1);
+    bool passable = false;
+    for (long y = y0; y <= y1 && !passable; ++y)
+      for (long x = x0; x <= x1 && !passable; ++x)
+        passable = !detail::visibilityBlocked(image, x, y);
+    if (!passable)
+      return false;
+
+    // squeezing through a diagonal contact of two blocked cells
+    if (t1 < 1.0 - 1e-12) {
+      const double px = ax + t1 * dx, py = ay + t1 * dy;
+      const double rx = std::floor(px + 0.5), ry = std::floor(py + 0.5);
+      if (std::fabs(px - rx) < 1e-9 && std::fabs(py - ry) < 1e-9) {
+        const long x = long(rx), y = long(ry);
+        if ((detail::visibilityBlocked(image, x - 1, y - 1) && detail::visibilityBlocked(image, x, y)) ||
+            (detail::visibilityBlocked(image, x, y - 1) && detail::visibilityBlocked(image, x - 1, y)))
+          return false;
+      }
+    }
+    t0 = t1;
+  }
+
+  return true;
+}
+
+/// Lattice points with exactly one blocked cell among the 4 around them.
+inline std::vector<size_t2> visibilityCorners(const ImageMatrix& image)
+{
+  std::vector<size_t2> corners;
+  for (std::size_t y = 1; y < image.height_; ++y)
+    for (std::size_t x = 1; x < image.width_; ++x) {
+      const int blocked = detail::visibilityBlocked(image, x - 1, y - 1) + detail::visibilityBlocked(image, x, y - 1) +
+                          detail::visibilityBlocked(image, x - 1, y)     + detail::visibilityBlocked(image, x, y);
+      if (blocked == 1)
+        corners.push_back(size_t2(x, y));
+    }
+
+  return corners;
+}
+
+template <typename V>
+GraphWD<V, float> visibilityGraph(const ImageMatrix& image)
+{
+  std::vector<detail::VisibilityCorner> corners;
+  for (const size_t2& c : visibilityCorners(image)) {
+    const long x = c.x, y = c.y;
+    const int sx = detail::visibilityBlocked(image, x - 1, y - 1) || detail::visibilityBlocked(image, x - 1, y) ? -1 : 1;
+    const int sy = detail::visibilityBlocked(image, x - 1, y - 1) || detail::visibilityBlocked(image, x, y - 1) ? -1 : 1;
+    detail::VisibilityCorner corner = { x, y, sx * sy };
+    corners.push_back(corner);
+  }
+
+  std::vector<typename GraphWD<V, float>::Edge> edges;
+  for (std::size_t i = 0; i < corners.size(); ++i)
+    for (std::size_t j = i + 1; j < corners.size(); ++j) {
+      const detail::VisibilityCorner& a = corners[i];
+      const detail::VisibilityCorner& b = corners[j];
+      const long dx = b.x - a.x, dy = b.y - a.y;
+
+      // tangent at a corner: the line, in both directions, misses the open quadrant of the blocked cell
+      if (dx * dy * a.quadrant > 0 || dx * dy * b.quadrant > 0)
+        continue;
+      if (!lineOfSight(image, a.x, a.y, b.x, b.y))
+        continue;
+
+      edges.push_back(typename GraphWD<V, float>::Edge(V(a.x, a.y), V(b.x, b.y), std::sqrt(float(dx * dx + dy * dy))));
+    }
+
+  GraphWD<V, float> graph(false);
+  for (const auto& c : corners)
+    graph.addVertex(V(c.x, c.y));
+  graph.addEdges(edges);
+
+  return graph;
+}
+
+/// Adds p, like the centre of a start or goal cell, joined to every vertex it sees.
+template <typename V>
+void addVisibilityPoint(GraphWD<V, float>& graph, const ImageMatrix& image, const V& p)
+{
+  if (graph.contains(p))
+    return;
+
+  const std::vector<V> vertices = graph.vertices();
+  graph.addVertex(p);
+  for (const V& v : vertices)
+    if (lineOfSight(image, p.x, p.y, v.x, v.y)) {
+      const float dx = v.x - p.x, dy = v.y - p.y;
+      graph.addEdge(p, v, std::sqrt(dx * dx + dy * dy));
+    }
+}
+
+#endif // VISIBILITY_GRAPH_HPP
@@ -1,27 +1,93 @@
 #include "read_png_to_imagematrix.hpp"
 
+#include <graph/luminance.hpp>
+
 #include <png++/png.hpp>
 #include <cstring> // for strerror needed by png++/error.hpp
 
-ImageMatrix readPngToImageMatrix(const std::string& filename)
+#include <fstream>
+
+namespace {
+
+/**
+  Decodes the image as 8 bit gray and hands the rows to row(y, pixels) in order,
+  after size(width, height) is called once. A row buffer is all that is
+  allocated here, only interlaced images need the whole image, as every pass
+  adds pixels to all of the rows.
+*/
+template <typename SizeF, typename RowF>
+void readPngRows(const std::string& filename, SizeF size, RowF row)
 {
-  png::image<png::gray_pixel> image(filename); // throws std_error(filename);
+  std::ifstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open())
+    throw png::std_error(filename);
+
+  png::reader<std::istream> reader(stream);
+  reader.read_info();
 
-  const std::size_t width  = image.get_width();
-  const std::size_t height = image.get_height();
-  std::vector<ImageMatrix::CellType> cells(width * height);
+  const png::color_type color_type = reader.get_color_type();
+  if (color_type == png::color_type_palette)
+    reader.set_palette_to_rgb();
+  if (color_type == png::color_type_rgb || color_type == png::color_type_rgba || color_type == png::color_type_palette)
+    reader.set_rgb_to_gray();
+  if (color_type == png::color_type_gray && reader.get_bit_depth() < 8)
+    reader.set_gray_1_2_4_to_8();
+  if (reader.get_bit_depth() == 16)
+    reader.set_strip_16();
+  if (color_type & png::color_mask_alpha)
+    reader.set_strip_alpha();
 
-  for (std::size_t y = 0; y < height; ++y) {
-    const png::image<png::gray_pixel>::row_type& row = image[y];
-    for (std::size_t x = 0; x < width; ++x) {
-      ImageMatrix::CellType c; // map pixel luminance to cell type
-      if (row[x] < 16)        c = ImageMatrix::SOLID;       // black
-      else if (row[x] >= 240) c = ImageMatrix::FREE;        // white
-      else                    c = ImageMatrix::DESTROYABLE; // everything else
+  const std::size_t passes = reader.get_interlace_type() == png::interlace_none ? 1 : reader.set_interlace_handling();
+  reader.update_info();
 
-      cells.push_back(c);
+  const std::size_t width  = reader.get_width();
+  const std::size_t height = reader.get_height();
+  size(width, height);
+
+  if (passes == 1) {
+    std::vector<png::byte> pixels(width);
+    for (std::size_t y = 0; y < height; ++y) {
+      reader.read_row(pixels.data());
+      row(y, pixels.data());
     }
+  } else {
+    std::vector<png::byte> pixels(width * height);
+    for (std::size_t pass = 0; pass < passes; ++pass)
+      for (std::size_t y = 0; y < height; ++y)
+        reader.read_row(pixels.data() + y * width);
+    for (std::size_t y = 0; y < height; ++y)
+      row(y, pixels.data() + y * width);
   }
-  return ImageMatrix(width, height, cells);
+
+  reader.read_end_info();
 }
 
+} // anonym namespace
+
+
+ImageMatrix readPngToImageMatrix(const std::string& filename)
+{
+  std::size_t width = 0, height = 0;
+  std::vector<ImageMatrix::CellType> cells;
+  readPngRows(filename,
+              [&](std::size_t w, std::size_t h) { width = w; height = h; cells.resize(w * h); },
+              [&](std::size_t y, const png::byte* pixels) { luminanceToCells(pixels, width, cells.data() + y * width); });
+
+  return ImageMatrix(width, height, std::move(cells));
+}
+
+SolidMask readPngToSolidMask(const std::string& filename)
+{
+  std::vector<SolidMask::word_type> bits;
+  std::size_t width = 0, height = 0, words_per_row = 0;
+  readPngRows(filename,
+              [&](std::size_t w, std::size_t h) {
+                width = w;
+                height = h;
+                words_per_row = (w + SolidMask::word_bits - 1) / SolidMask::word_bits;
+                bits.resize(words_per_row * h);
+              },
+              [&](std::size_t y, const png::byte* pixels) { luminanceToSolidBits(pixels, width, bits.data() + y * words_per_row); });
+
+  return SolidMask(width, height, std::move(bits));
+}
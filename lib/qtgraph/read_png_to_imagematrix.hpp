@@ -1,21 +1,16 @@
 #ifndef READ_PNG_TO_IMAGE_MATRIX_HPP
 #define READ_PNG_TO_IMAGE_MATRIX_HPP
 
-#include <string>
-#include <vector>
-
+#include <graph/marching_squares.hpp>
 
-struct ImageMatrix {
-  enum CellType { FREE, SOLID, DESTROYABLE };
+#include <string>
 
-  const std::size_t width_;
-  const std::size_t height_;
-  const std::vector<CellType> cells_;
-  ImageMatrix(std::size_t w, std::size_t h, const std::vector<CellType>& c)
-    : width_(w), height_(h), cells_(c) {}
-};
 
+/// Pixel luminance to cell type as in graph/luminance.hpp, any PNG color type is converted to gray.
 ImageMatrix readPngToImageMatrix(const std::string& filename); // throws std_error(filename);
 
+/// Only the not FREE bits, an eighth of the memory of a byte per pixel.
+SolidMask readPngToSolidMask(const std::string& filename); // throws std_error(filename);
+
 
 #endif // READ_PNG_TO_IMAGE_MATRIX_HPP
@@ -2,8 +2,10 @@
 #define GRAPH_TEST_FIXTURE_HPP
 
 #include <graph/graph.hpp>
+#include <graph/marching_squares.hpp>
 
 #include <cmath>
+#include <functional>
 #include <iomanip>
 #include <sstream>
 
@@ -207,4 +209,15 @@ template<class V> bool Fixture<V>::m_initialized = false;
 template<class V> std::vector<V>* Fixture<V>::m_vertices = 0;
 template<class V> std::vector<typename Graph<V>::Edge>* Fixture<V>::m_edges = 0;
 
+/// Grid map from text rows of equal length, '#' is SOLID, anything else FREE.
+inline ImageMatrix parseMap(const std::vector<std::string>& rows)
+{
+  std::vector<ImageMatrix::CellType> cells;
+  for (const std::string& row : rows)
+    for (const char c : row)
+      cells.push_back(c == '#' ? ImageMatrix::SOLID : ImageMatrix::FREE);
+
+  return ImageMatrix(rows.empty() ? 0 : rows.front().size(), rows.size(), cells);
+}
+
 #endif // GRAPH_TEST_FIXTURE_HPP
@@ -0,0 +1,150 @@
+#include <graph/compressed_graph.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <iterator>
+
+
+namespace {
+
+/// Input iterator generating the edges of a ring of n vertices on the fly, sorted by source.
+class RingEdges : public std::iterator<std::input_iterator_tag, std::pair<std::size_t, std::size_t>>
+{
+public:
+  RingEdges(std::size_t n, std::size_t i) : m_n(n), m_i(i) {}
+
+  value_type operator*() const {
+    const std::size_t source = m_i / 2;
+    return value_type(source, m_i % 2 == 0 ? (source + m_n - 1) % m_n : (source + 1) % m_n);
+  }
+  RingEdges& operator++() { ++m_i; return *this; }
+  bool operator==(const RingEdges& o) const { return m_i == o.m_i; }
+  bool operator!=(const RingEdges& o) const { return m_i != o.m_i; }
+
+private:
+  std::size_t m_n, m_i;
+};
+
+} // namespace
+
+
+TEST_CASE( "Compressed graph", "[compressed_graph][data_structure]" ) {
+
+  SECTION("empty") {
+    const CompressedGraph<int> cg;
+    REQUIRE( cg.empty() == true );
+    REQUIRE( cg.numberOfVertices() == 0 );
+    REQUIRE( cg.numberOfEdges() == 0 );
+
+    const CompressedGraph<int> cg2((Graph<int>()));
+    REQUIRE( cg2.empty() == true );
+    REQUIRE( cg2.numberOfEdges() == 0 );
+  }
+
+  SECTION("neighbours are sorted ids") {
+    const std::vector<int> order { 10, 20, 30, 40 };
+    const Graph<int> g = { {10, 40}, {10, 20}, {10, 30}, {30, 40} };
+    const CompressedGraph<int> cg(g, order);
+
+    REQUIRE( cg.numberOfVertices() == 4 );
+    REQUIRE( cg.numberOfEdges() == numberOfEdges(g) );
+    REQUIRE( cg.id(30) == 2 );
+    REQUIRE( cg.vertex(3) == 40 );
+
+    std::vector<std::size_t> n0(cg.neighbourIds(0).begin(), cg.neighbourIds(0).end());
+    REQUIRE( n0 == std::vector<std::size_t>({1, 2, 3}) );
+    std::vector<std::size_t> n3(cg.neighbourIds(3).begin(), cg.neighbourIds(3).end());
+    REQUIRE( n3 == std::vector<std::size_t>({0, 2}) );
+    REQUIRE( cg.degree(0) == 3 );
+    REQUIRE( cg.degree(1) == 1 );
+
+    REQUIRE( cg.neighboursOf(40) == std::vector<int>({10, 30}) );
+    REQUIRE( cg.neighboursOf(50).empty() == true );
+    REQUIRE( cg.contains(50) == false );
+    CHECK_THROWS( cg.id(50) );
+    REQUIRE( cg.find(50) == CompressedGraph<int>::npos );
+    REQUIRE( cg.find(cg.vertex(2)) == 2 );
+  }
+
+  SECTION("isolated vertex") {
+    const Graph<int> g = { 1, 2 };
+    const CompressedGraph<int> cg(g);
+    REQUIRE( cg.degree(cg.id(1)) == 0 );
+    REQUIRE( cg.neighbourIds(cg.id(1)).begin() == cg.neighbourIds(cg.id(1)).end() );
+  }
+
+  SECTION("id edge list with large gaps and duplicates") {
+    std::vector<std::size_t> vertices;
+    for (std::size_t i = 0; i < 100000; ++i)
+      vertices.push_back(i);
+
+    std::vector<CompressedGraph<std::size_t>::id_edge> edges {
+      {50000, 0}, {50000, 99999}, {50000, 50001}, {50000, 49999}, {50000, 99999}, {7, 8} };
+    const CompressedGraph<std::size_t> cg(vertices, edges);
+
+    REQUIRE( cg.numberOfEdges() == 5 );
+    std::vector<std::size_t> n(cg.neighbourIds(50000).begin(), cg.neighbourIds(50000).end());
+    REQUIRE( n == std::vector<std::size_t>({0, 49999, 50001, 99999}) );
+    REQUIRE( cg.degree(7) == 1 );
+    REQUIRE( *cg.neighbourIds(7).begin() == 8 );
+  }
+
+  SECTION("id edge list out of range") {
+    const std::vector<int> vertices { 10, 20 };
+    typedef std::vector<CompressedGraph<int>::id_edge> id_edges;
+    CHECK_THROWS( CompressedGraph<int>(vertices, id_edges({ {0, 1}, {2, 0} })) );
+    CHECK_THROWS( CompressedGraph<int>(vertices, id_edges({ {0, 2} })) );
+
+    const CompressedGraph<int> cg(vertices, id_edges({ {1, 0}, {1, 0} }));
+    REQUIRE( cg.numberOfEdges() == 1 );
+    REQUIRE( cg.neighboursOf(20) == std::vector<int>({10}) );
+  }
+
+  SECTION("streamed edge range") {
+    const std::size_t n = 100000;
+    std::vector<std::size_t> vertices;
+    for (std::size_t i = 0; i < n; ++i)
+      vertices.push_back(i * 10);
+
+    const CompressedGraph<std::size_t> cg(vertices, RingEdges(n, 0), RingEdges(n, 2 * n));
+
+    REQUIRE( cg.numberOfVertices() == n );
+    REQUIRE( cg.numberOfEdges() == 2 * n );
+    REQUIRE( cg.compressedSize() < 3 * n ); // one byte per gap but for the wrap around
+    REQUIRE( cg.neighboursOf(0) == std::vector<std::size_t>({10, (n - 1) * 10}) );
+    REQUIRE( cg.neighboursOf(500) == std::vector<std::size_t>({490, 510}) );
+  }
+
+  SECTION("streamed edge range with gaps and bad input") {
+    const std::vector<int> vertices { 10, 20, 30, 40 };
+    typedef std::vector<CompressedGraph<int>::id_edge> id_edges;
+
+    const id_edges sparse { {1, 3}, {1, 0}, {1, 3}, {3, 2} };
+    const CompressedGraph<int> cg(vertices, sparse.begin(), sparse.end());
+    REQUIRE( cg.numberOfEdges() == 3 );
+    REQUIRE( cg.degree(0) == 0 );
+    REQUIRE( cg.neighboursOf(20) == std::vector<int>({10, 40}) );
+    REQUIRE( cg.degree(2) == 0 );
+    REQUIRE( cg.neighboursOf(40) == std::vector<int>({30}) );
+
+    const id_edges unsorted { {2, 0}, {1, 0} };
+    CHECK_THROWS( CompressedGraph<int>(vertices, unsorted.begin(), unsorted.end()) );
+    const id_edges out_of_range { {0, 1}, {4, 0} };
+    CHECK_THROWS( CompressedGraph<int>(vertices, out_of_range.begin(), out_of_range.end()) );
+  }
+
+  SECTION("grid round trip") {
+    const std::vector<typename Graph<float2>::Edge>* edges = createEdges<float2>(20, 20);
+    const Graph<float2> g(*edges);
+    const CompressedGraph<float2> cg(g);
+
+    REQUIRE( cg.numberOfVertices() == numberOfVertices(g) );
+    REQUIRE( cg.numberOfEdges() == numberOfEdges(g) );
+    REQUIRE( cg.compressedSize() < cg.numberOfEdges() * sizeof(float2) );
+    REQUIRE( cg.decompress() == g );
+
+    delete edges;
+  }
+}
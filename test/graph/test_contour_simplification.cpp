@@ -0,0 +1,115 @@
+#include <graph/contour_simplification.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+double perimeter(const Contour& c)
+{
+  double length = 0.0;
+  for (std::size_t i = 0; i + 1 < c.points.size(); ++i)
+    length += detail::distanceToSegment(c.points[i], c.points[i + 1], c.points[i + 1]);
+  if (c.closed)
+    length += detail::distanceToSegment(c.points.back(), c.points.front(), c.points.front());
+
+  return length;
+}
+
+SolidMask block(std::size_t w, std::size_t h, std::size_t x0, std::size_t y0, std::size_t x1, std::size_t y1)
+{
+  SolidMask mask(w, h);
+  for (std::size_t y = y0; y < y1; ++y)
+    for (std::size_t x = x0; x < x1; ++x)
+      mask.set(x, y, true);
+
+  return mask;
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Contour simplification", "[contour_simplification][algorithm]" ) {
+
+  SECTION("empty") {
+    REQUIRE ( chainSegments(std::vector< std::pair<size_t2, size_t2> >()).empty() );
+  }
+
+  SECTION("rectangle is one closed polygon of 4 corners") {
+    const std::vector<Contour> contours = chainSegments(marchingSquares(block(10, 10, 2, 3, 7, 6)));
+    REQUIRE ( contours.size() == 1 );
+    REQUIRE ( contours[0].closed == true );
+
+    const Contour simplified = simplifyContour(contours[0]);
+    REQUIRE ( simplified.points.size() == 4 );
+    REQUIRE ( perimeter(simplified) == Approx(2 * (5 + 3)) );
+    REQUIRE ( std::find(simplified.points.begin(), simplified.points.end(), size_t2(2, 3)) != simplified.points.end() );
+    REQUIRE ( std::find(simplified.points.begin(), simplified.points.end(), size_t2(7, 6)) != simplified.points.end() );
+  }
+
+  SECTION("contour running into the border is open") {
+    const std::vector<Contour> contours = chainSegments(marchingSquares(block(10, 10, 3, 0, 6, 4)));
+    REQUIRE ( contours.size() == 1 );
+    REQUIRE ( contours[0].closed == false );
+
+    // masks start at row 1, so the sides touching row 0 are not part of the contour
+    const Contour simplified = simplifyContour(contours[0]);
+    REQUIRE ( simplified.points.size() == 2 );
+    REQUIRE ( std::find(simplified.points.begin(), simplified.points.end(), size_t2(3, 4)) != simplified.points.end() );
+    REQUIRE ( std::find(simplified.points.begin(), simplified.points.end(), size_t2(6, 4)) != simplified.points.end() );
+  }
+
+  SECTION("staircase collapses with tolerance") {
+    SolidMask mask(30, 30);
+    for (std::size_t y = 1; y < 29; ++y)
+      for (std::size_t x = 1; x <= y; ++x)
+        mask.set(x, y, true);
+
+    const std::vector<Contour> contours = chainSegments(marchingSquares(mask));
+    REQUIRE ( contours.size() == 1 );
+    REQUIRE ( contours[0].points.size() > 50 );
+
+    const Contour exact = simplifyContour(contours[0], 0.0);
+    REQUIRE ( exact.points.size() > 50 );
+    const Contour triangle = simplifyContour(contours[0], 1.0);
+    REQUIRE ( triangle.points.size() == 3 );
+  }
+
+  SECTION("random maps: same outline, fewer vertices") {
+    std::srand(13);
+    const std::size_t w = 80, h = 60;
+    SolidMask mask(w, h);
+    for (int r = 0; r < 25; ++r) {
+      const std::size_t x0 = std::rand() % w, y0 = std::rand() % h;
+      const std::size_t x1 = std::min(w, x0 + 1 + std::rand() % 12), y1 = std::min(h, y0 + 1 + std::rand() % 12);
+      for (std::size_t y = y0; y < y1; ++y)
+        for (std::size_t x = x0; x < x1; ++x)
+          mask.set(x, y, true);
+    }
+
+    const std::vector< std::pair<size_t2, size_t2> > segments = marchingSquares(mask);
+    double segment_length = 0.0;
+    for (const auto& s : segments)
+      segment_length += detail::distanceToSegment(s.first, s.second, s.second);
+
+    const std::vector<Contour> contours = chainSegments(segments);
+    const std::vector<Contour> simplified = simplifyContours(contours);
+    double contour_length = 0.0;
+    std::size_t number_of_edges = 0;
+    for (const auto& c : simplified) {
+      contour_length += perimeter(c);
+      number_of_edges += c.closed ? c.points.size() : c.points.size() - 1;
+    }
+    REQUIRE ( contour_length == Approx(segment_length) );
+    REQUIRE ( number_of_edges <= segments.size() );
+
+    const Graph<float2> raw = contourGraph<float2>(contours);
+    const Graph<float2> reduced = contourGraph<float2>(simplifyContours(contours, 1.5));
+    REQUIRE ( numberOfVertices(reduced) < numberOfVertices(raw) );
+    REQUIRE ( numberOfVertices(reduced) > 0 );
+  }
+}
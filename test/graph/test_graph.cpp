@@ -319,6 +319,13 @@ TEST_CASE( "Graph adding edges", "[graph][data_structure]" ) {
     REQUIRE( connected(g, 4, 3) == false ); // not anymore
     REQUIRE( connected(g, 4, 4) == false );
     REQUIRE( connected(g, 4, 5) == true );
+
+    // 5 is no vertex and 3 -> 4 has no back edge anymore
+    g.removeVertex(4);
+    REQUIRE( numberOfVertices(g) == 3 );
+    REQUIRE( g.neighboursOf(3) == std::vector<int>({1}) );
+    REQUIRE( g.neighboursOf(4).empty() == true );
+    REQUIRE( numberOfEdges(g) == 2*2 );
   }
 
   SECTION("get array of edges") {
@@ -365,6 +372,38 @@ TEST_CASE( "Graph specials", "[graph][data_structure]" ) {
     g.addEdge(2, 2);
     REQUIRE( numberOfEdges(g) == 2 );
   }
+
+  SECTION("bulk add edges, no multi or self edges") {
+    Graph<int> g;
+    g.addEdges({ {1, 2}, {2, 1}, {1, 2}, {3, 3}, {2, 3} });
+    REQUIRE( numberOfVertices(g) == 3 );
+    REQUIRE( numberOfEdges(g) == 2*2 );
+    REQUIRE( g == Graph<int>({ {1, 2}, {2, 3} }) );
+
+    // into a non-empty graph
+    g.addEdges({ {3, 2}, {3, 4} });
+    REQUIRE( numberOfEdges(g) == 3*2 );
+    REQUIRE( connected(g, 4, 3) == true );
+
+    // lists the call does not append to are left as they are
+    g.setEdges(7, {8, 8});
+    g.addEdges({ {4, 1}, {1, 4} });
+    REQUIRE( g.neighboursOf(7) == std::vector<int>({8, 8}) );
+    REQUIRE( g.neighboursOf(1) == std::vector<int>({2, 4}) );
+    REQUIRE( g.neighboursOf(4) == std::vector<int>({3, 1}) );
+  }
+
+  SECTION("bulk add edges to a hub") {
+    std::vector<Graph<int>::Edge> e;
+    for (int i = 1; i <= 100; ++i) {
+      e.push_back(Graph<int>::Edge(0, i));
+      e.push_back(Graph<int>::Edge(i, 0));
+    }
+    Graph<int> g;
+    g.addEdges(e);
+    REQUIRE( g.neighboursOf(0).size() == 100 );
+    REQUIRE( numberOfEdges(g) == 100*2 );
+  }
 }
 
 TEST_CASE( "Graph std::string vertices", "[graph][data_structure]" ) {
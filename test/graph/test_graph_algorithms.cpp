@@ -1,11 +1,15 @@
 #include <graph/graph.hpp>
 #include <graph/graph_algorithms.hpp>
+#include <graph/compressed_graph.hpp>
+#include <graph/graph_generators.hpp>
 
 #include "../catch.hpp"
 
 #include "fixture.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
 
 void printPath(std::size_t number_of_rows,
                std::size_t number_of_columns,
@@ -70,6 +74,16 @@ TEST_CASE("Graph algorithms, small", "[graph][algorithm][dijkstra]" ) {
     REQUIRE( shortestPath.size() == 0 );
   }
 
+  SECTION("nonexisting source or destination in a CompressedGraph") {
+    const CompressedGraph<int> g(Graph<int>({ {1, 2}, {1, 3}, {1, 4}, {2, 4}, {3, 4} }));
+    REQUIRE( dijkstraShortestPath(g, 10, 1).empty() );
+    REQUIRE( dijkstraShortestPath(g, 1, 10).empty() );
+    REQUIRE( dijkstraShortestPath(g, 10, 10) == std::vector<int>(1, 10) );
+    REQUIRE( dijkstraShortestPath(g, 1, 2) == std::vector<int>({1, 2}) );
+    REQUIRE( shortestPathsFrom(g, 10).size() == 1 );
+    REQUIRE( shortestPathsFrom(g, 2).at(3).first == 2 );
+  }
+
   SECTION("not connected source and destination") {
     Graph<int> g = { {1, 2}, {3, 4} };
     const int source(1);
@@ -126,3 +140,116 @@ TEST_CASE_METHOD(Fixture<float2>, "Graph algorithms, big graph", "[graph][algori
   }
 
 }
+
+TEST_CASE("Shortest paths with weight accessors", "[graph][algorithm][dijkstra][astar]" ) {
+
+  SECTION("stored weights of a GraphWD") {
+    // the direct edge is heavier than the detour
+    GraphWD<int, float> g;
+    g.addEdge(0, 1, 5.0f);
+    g.addEdge(0, 2, 1.0f);
+    g.addEdge(2, 1, 1.5f);
+    g.addEdge(1, 3, 1.0f);
+    REQUIRE( dijkstraShortestPath(g, 0, 3) == std::vector<int>({0, 2, 1, 3}) );
+    REQUIRE( dijkstraShortestPath(g, 3, 0).empty() ); // directed
+    REQUIRE( dijkstraShortestPath(g, 2, 2) == std::vector<int>({2}) );
+
+    const auto labels = shortestPathsFrom(g, 0);
+    REQUIRE( labels.size() == 4 );
+    REQUIRE( labels.at(0) == std::make_pair(0.0f, 0) );
+    REQUIRE( labels.at(1) == std::make_pair(2.5f, 2) );
+    REQUIRE( labels.at(3) == std::make_pair(3.5f, 1) );
+  }
+
+  SECTION("unweighted Graph, stored weights count the edges") {
+    Graph<int> g = { {0, 1}, {1, 2}, {2, 3}, {0, 4}, {4, 3} };
+    REQUIRE( dijkstraShortestPath(g, 0, 3) == std::vector<int>({0, 4, 3}) );
+    REQUIRE( shortestPathsFrom(g, 0).at(2).first == 2 );
+    REQUIRE( dijkstraShortestPath(g, 0, 7).empty() );
+  }
+
+  SECTION("computed weights, zero weight edges") {
+    Graph<int> g = { {0, 1}, {1, 2}, {0, 2} };
+    // 0 -> 1 and 1 -> 2 are free
+    const auto weight = computedWeight([](int u, int v) { return u + v == 1 || u + v == 3 ? 0 : 10; });
+    REQUIRE( dijkstraShortestPath(g, 0, 2, weight) == std::vector<int>({0, 1, 2}) );
+    REQUIRE( shortestPathsFrom(g, 2, weight).at(0).first == 0 );
+  }
+
+  SECTION("same lengths as the std::function version, A*, both GraphWD layouts and CompressedGraph") {
+    const std::vector<Graph<float2>::Edge> edges = randomGeometricEdges<float2>(600, 1.5, 11);
+    const Graph<float2> g(edges);
+    GraphWD<float2, float> wd(false);
+    GraphWD<float2, float, SPLIT_LAYOUT> split(false);
+    fillGraph(wd, edges, std::distanceOf2float2s());
+    fillGraph(split, edges, std::distanceOf2float2s());
+    const CompressedGraph<float2> csr(g);
+
+    // a path of edges of g from source to dest, and its length
+    auto length = [&g](const std::vector<float2>& path, const float2& source, const float2& dest) {
+      REQUIRE( path.front() == source );
+      REQUIRE( path.back() == dest );
+      float sum = 0;
+      for (std::size_t i = 0; i + 1 < path.size(); ++i) {
+        const std::vector<float2>& n = g.neighboursOf(path[i]);
+        REQUIRE( std::find(n.begin(), n.end(), path[i + 1]) != n.end() );
+        sum += distance(path[i], path[i + 1]);
+      }
+      return sum;
+    };
+
+    // Bellman-Ford over the edge list as the independent reference
+    auto bellmanFord = [&edges](const float2& source) {
+      std::unordered_map<float2, double> dist;
+      dist[source] = 0;
+      for (bool relaxed = true; relaxed; ) {
+        relaxed = false;
+        for (const auto& e : edges)
+          for (int dir = 0; dir < 2; ++dir) {
+            const float2& u = dir == 0 ? e.source : e.destination;
+            const float2& v = dir == 0 ? e.destination : e.source;
+            const auto u_it = dist.find(u);
+            if (u_it == dist.end())
+              continue;
+            const double d = u_it->second + distance(u, v);
+            const auto v_it = dist.find(v);
+            if (v_it == dist.end() || d < v_it->second) {
+              dist[v] = d;
+              relaxed = true;
+            }
+          }
+      }
+      return dist;
+    };
+
+    const std::vector<float2> vertices = g.vertices();
+    for (std::size_t i = 0; i < 20; ++i) {
+      const float2 source = vertices[i * 7 % vertices.size()];
+      const float2 dest = vertices[i * 13 % vertices.size()];
+      const std::unordered_map<float2, double> dist = bellmanFord(source);
+      const std::vector<float2> by_function = dijkstra_shortest_path_to(g, source, dest, std::distanceOf2float2s());
+      const std::vector<float2> computed = dijkstraShortestPath(g, source, dest, computedWeight(std::distanceOf2float2s()));
+      const std::vector<float2> stored = dijkstraShortestPath(wd, source, dest);
+      const std::vector<float2> stored_split = dijkstraShortestPath(split, source, dest);
+      const std::vector<float2> a_star = aStarShortestPath(split, source, dest, [&dest](const float2& v) { return distance(v, dest); });
+      const std::vector<float2> compressed = dijkstraShortestPath(csr, source, dest, computedWeight(std::distanceOf2float2s()));
+
+      REQUIRE( stored_split == stored );
+      if (dist.find(dest) == dist.end()) {
+        REQUIRE( by_function.empty() );
+        REQUIRE( computed.empty() );
+        REQUIRE( stored.empty() );
+        REQUIRE( a_star.empty() );
+        REQUIRE( compressed.empty() );
+        continue;
+      }
+      const double expected = dist.at(dest);
+      REQUIRE( length(by_function, source, dest) == Approx(expected) );
+      REQUIRE( length(computed, source, dest) == Approx(expected) );
+      REQUIRE( length(stored, source, dest) == Approx(expected) );
+      REQUIRE( length(a_star, source, dest) == Approx(expected) );
+      REQUIRE( length(compressed, source, dest) == Approx(expected) );
+      REQUIRE( shortestPathsFrom(split, source).at(dest).first == Approx(expected) );
+    }
+  }
+}
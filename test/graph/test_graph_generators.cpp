@@ -0,0 +1,104 @@
+#include <graph/graph_generators.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+namespace {
+
+template <typename V>
+bool simple(const std::vector<typename Graph<V>::Edge>& edges)
+{
+  for (const auto& e : edges)
+    if (e.source == e.destination)
+      return false;
+
+  return true;
+}
+
+} // anonym namespace
+
+
+TEST_CASE( "Graph generators", "[graph][generators]" ) {
+
+  SECTION("Erdos-Renyi") {
+    REQUIRE( erdosRenyiEdges<int>(100, 0.0, 1).empty() == true );
+    REQUIRE( erdosRenyiEdges<int>(10, 1.0, 1).size() == 10*9/2 );
+
+    const auto e = erdosRenyiEdges<int>(2000, 0.01, 7);
+    REQUIRE( simple<int>(e) );
+    REQUIRE( e.size() > 2000*1999/2 * 0.009 );
+    REQUIRE( e.size() < 2000*1999/2 * 0.011 );
+    REQUIRE( e == erdosRenyiEdges<int>(2000, 0.01, 7) );
+    REQUIRE( e != erdosRenyiEdges<int>(2000, 0.01, 8) );
+
+    Graph<int> g;
+    fillGraph(g, e);
+    REQUIRE( numberOfEdges(g) == e.size() * 2 );
+  }
+
+  SECTION("Barabasi-Albert") {
+    const auto e = barabasiAlbertEdges<int>(1000, 3, 1);
+    REQUIRE( simple<int>(e) );
+    REQUIRE( e.size() == 4*3/2 + (1000 - 4) * 3 );
+    REQUIRE( e == barabasiAlbertEdges<int>(1000, 3, 1) );
+
+    Graph<int> g;
+    fillGraph(g, e);
+    REQUIRE( numberOfVertices(g) == 1000 );
+    REQUIRE( numberOfEdges(g) == e.size() * 2 ); // no multiedges generated
+
+    std::size_t max_degree = 0;
+    for (const auto& v : g)
+      max_degree = std::max(max_degree, g.neighboursOf(v).size());
+    REQUIRE( max_degree > 30 ); // hubs
+  }
+
+  SECTION("R-MAT") {
+    const auto e = rmatEdges<int>(10, 8, 3);
+    REQUIRE( simple<int>(e) );
+    REQUIRE( e.size() <= 8 * 1024 );
+    REQUIRE( e == rmatEdges<int>(10, 8, 3) );
+
+    Graph<int> g;
+    fillGraph(g, e);
+    REQUIRE( numberOfEdges(g) == e.size() * 2 );
+  }
+
+  SECTION("grid") {
+    const auto e = gridEdges<float2>(4, 3);
+    REQUIRE( e.size() == 3*3 + 4*2 );
+    REQUIRE( gridEdges<float2>(4, 3, true).size() == 3*3 + 4*2 + 2*3*2 );
+
+    const std::vector<typename Graph<float2>::Edge>* fixture_edges = createEdges<float2>(5, 5);
+    REQUIRE( Graph<float2>(gridEdges<float2>(5, 5, true)) == Graph<float2>(*fixture_edges) );
+    delete fixture_edges;
+  }
+
+  SECTION("random geometric") {
+    const double radius = 1.5;
+    const auto e = randomGeometricEdges<float2>(2000, radius, 5);
+    REQUIRE( simple<float2>(e) );
+    REQUIRE( e == randomGeometricEdges<float2>(2000, radius, 5) );
+    for (const auto& edge : e)
+      REQUIRE( distance(edge.source, edge.destination) < radius + 1e-4 );
+
+    const Graph<float2> g(e);
+    REQUIRE( numberOfEdges(g) == e.size() * 2 );
+
+    REQUIRE( randomGeometricEdges<float2>(100, 0.0, 5).empty() );
+    REQUIRE( randomGeometricEdges<float2>(100, -1.0, 5).empty() );
+    REQUIRE( randomGeometricEdges<float2>(100, 1e-300, 5).empty() ); // no cells*cells blow up
+  }
+
+  SECTION("weighted") {
+    GraphWD<int, float> directed;
+    fillGraph(directed, erdosRenyiEdges<int>(10, 1.0, 1), [](int a, int b) { return float(a + b); });
+    REQUIRE( directed.numberOfEdges() == 10*9/2 );
+    REQUIRE( directed.weights(3, 1) == std::vector<float>({4.0f}) );
+
+    GraphWD<int, float> undirected(false);
+    fillGraph(undirected, erdosRenyiEdges<int>(10, 1.0, 1), [](int, int) { return 1.0f; });
+    REQUIRE( undirected.numberOfEdges() == 10*9 );
+  }
+}
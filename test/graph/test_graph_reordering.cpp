@@ -0,0 +1,100 @@
+#include <graph/graph_reordering.hpp>
+#include <graph/graphwd.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+namespace {
+
+template <typename V>
+bool isPermutation(const Graph<V>& g, std::vector<V> order)
+{
+  std::vector<V> v = g.vertices();
+  std::sort(v.begin(), v.end());
+  std::sort(order.begin(), order.end());
+  return v == order;
+}
+
+} // anonym namespace
+
+
+TEST_CASE( "Graph reordering", "[graph][reordering]" ) {
+
+  SECTION("empty") {
+    const Graph<int> g;
+    REQUIRE( reverseCuthillMcKeeOrder(g).empty() == true );
+    REQUIRE( degreeSortOrder(g).empty() == true );
+
+    const OrderingMetrics m = orderingMetrics(g, std::vector<int>());
+    REQUIRE( m.bandwidth == 0 );
+    REQUIRE( m.average_gap == 0.0 );
+  }
+
+  SECTION("metrics") {
+    const Graph<int> g = { {1, 2}, {1, 3} };
+    const OrderingMetrics m = orderingMetrics(g, std::vector<int>({2, 1, 3}));
+    REQUIRE( m.bandwidth == 1 );
+    REQUIRE( m.average_gap == 1.0 );
+
+    const OrderingMetrics m2 = orderingMetrics(g, std::vector<int>({1, 2, 3}));
+    REQUIRE( m2.bandwidth == 2 );
+    REQUIRE( m2.average_gap == 1.5 );
+  }
+
+  SECTION("RCM on a path has bandwidth 1") {
+    const Graph<int> g = { {5, 3}, {3, 9}, {9, 1}, {1, 7}, {7, 2}, {2, 8} };
+    const std::vector<int> order = reverseCuthillMcKeeOrder(g);
+    REQUIRE( isPermutation(g, order) );
+    REQUIRE( orderingMetrics(g, order).bandwidth == 1 );
+  }
+
+  SECTION("RCM covers every component") {
+    const Graph<int> g = { {1, 2}, {3, 4}, {4, 5} };
+    Graph<int> g2(g);
+    g2.addVertex(6);
+    REQUIRE( isPermutation(g2, reverseCuthillMcKeeOrder(g2)) );
+  }
+
+  SECTION("degree sort") {
+    const Graph<int> g = { {1, 2}, {3, 4}, {4, 5}, {4, 6} };
+    const std::vector<int> order = degreeSortOrder(g);
+    REQUIRE( isPermutation(g, order) );
+    REQUIRE( order.front() == 4 );
+  }
+
+  SECTION("same orders over a CompressedGraph and a GraphWD") {
+    const Graph<int> g = { {1, 2}, {2, 3}, {3, 4}, {2, 5}, {5, 6}, {7, 8} };
+    // the dense ids in the iteration order of g, where the ties are kept
+    const CompressedGraph<int> c(g, g.vertices());
+    REQUIRE( reverseCuthillMcKeeOrder(c) == reverseCuthillMcKeeOrder(g) );
+    REQUIRE( degreeSortOrder(c) == degreeSortOrder(g) );
+    REQUIRE( orderingMetrics(c, c.vertices()).bandwidth == orderingMetrics(g, g.vertices()).bandwidth );
+
+    GraphWD<int, float> wd; // edges(g) has both directions
+    for (const auto& e : edges(g))
+      wd.addEdge(e.source, e.destination, 1.0f);
+    const std::vector<int> order = reverseCuthillMcKeeOrder(wd);
+    REQUIRE( isPermutation(g, order) );
+    REQUIRE( orderingMetrics(wd, order).bandwidth == orderingMetrics(g, order).bandwidth );
+  }
+
+  SECTION("grid") {
+    constexpr std::size_t number_of_rows = 30;
+    const std::vector<typename Graph<float2>::Edge>* edges = createEdges<float2>(number_of_rows, number_of_rows);
+    const Graph<float2> g(*edges);
+
+    const Reordering<float2> rcm = reorder(g, reverseCuthillMcKeeOrder(g));
+    REQUIRE( rcm.after.bandwidth <= 2 * number_of_rows + 1 );
+    REQUIRE( rcm.after.bandwidth < rcm.before.bandwidth );
+    REQUIRE( rcm.after.average_gap < rcm.before.average_gap );
+    REQUIRE( rcm.graph.numberOfEdges() == numberOfEdges(g) );
+    REQUIRE( rcm.graph.decompress() == g );
+
+    const std::vector<float2> hilbert = hilbertOrder(g);
+    REQUIRE( isPermutation(g, hilbert) );
+    REQUIRE( orderingMetrics(g, hilbert).average_gap < orderingMetrics(g, g.vertices()).average_gap );
+
+    delete edges;
+  }
+}
@@ -0,0 +1,105 @@
+#include <graph/graph_traits.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+template <typename G>
+std::vector<int> verticesOf(const G& g)
+{
+  std::vector<int> retval;
+  graph_traits<G>::forEachVertex(g, [&retval](int v) { retval.push_back(v); });
+  std::sort(retval.begin(), retval.end());
+  return retval;
+}
+
+/// As (destination, stored weight).
+template <typename G>
+std::vector<std::tuple<int, typename graph_traits<G>::weight_type> > outEdgesOf(const G& g, int u)
+{
+  typedef typename graph_traits<G>::weight_type W;
+  std::vector<std::tuple<int, W> > retval;
+  graph_traits<G>::forEachOutEdge(g, u, [&retval](int v, const W& w) { retval.push_back(std::make_tuple(v, w)); });
+  std::sort(retval.begin(), retval.end());
+  return retval;
+}
+
+/// Every vertex gets a distinct index in [0, numberOfVertices()).
+template <typename G>
+void requireDenseIndex(const G& g)
+{
+  const typename graph_traits<G>::index_map index = graph_traits<G>::indexMap(g);
+  REQUIRE ( index.size() == graph_traits<G>::numberOfVertices(g) );
+
+  std::vector<bool> taken(index.size(), false);
+  graph_traits<G>::forEachVertex(g, [&](int v) {
+    REQUIRE ( index(v) < taken.size() );
+    REQUIRE ( taken[index(v)] == false );
+    taken[index(v)] = true;
+  });
+}
+
+} // anonym namespace
+
+TEST_CASE( "Graph traits", "[graph][traits]" ) {
+
+  const Graph<int> g = { {1, 2}, {1, 3}, {3, 4} };
+
+  SECTION("Graph") {
+    typedef graph_traits<Graph<int> > traits;
+    REQUIRE ( traits::numberOfVertices(g) == 4 );
+    REQUIRE ( verticesOf(g) == std::vector<int>({1, 2, 3, 4}) );
+    const std::vector<std::tuple<int, int> > expected = { std::make_tuple(2, 1), std::make_tuple(3, 1) };
+    REQUIRE ( outEdgesOf(g, 1) == expected );
+    REQUIRE ( outEdgesOf(g, 5).empty() );
+    REQUIRE ( traits::outDegree(g, 3) == 2 );
+    requireDenseIndex(g);
+  }
+
+  SECTION("GraphWD, both layouts") {
+    typedef graph_traits<GraphWD<int, float> > traits;
+    GraphWD<int, float> wd; // edges(g) has both directions
+    GraphWD<int, float, SPLIT_LAYOUT> split;
+    for (const auto& e : edges(g)) {
+      wd.addEdge(e.source, e.destination, float(e.source + e.destination));
+      split.addEdge(e.source, e.destination, float(e.source + e.destination));
+    }
+    wd.addEdge(1, 2, 0.5f); // parallel edges are all visited
+    split.addEdge(1, 2, 0.5f);
+
+    REQUIRE ( verticesOf(wd) == verticesOf(g) );
+    REQUIRE ( verticesOf(split) == verticesOf(g) );
+    const std::vector<std::tuple<int, float> > expected =
+      { std::make_tuple(2, 0.5f), std::make_tuple(2, 3.0f), std::make_tuple(3, 4.0f) };
+    REQUIRE ( outEdgesOf(wd, 1) == expected );
+    REQUIRE ( outEdgesOf(split, 1) == expected );
+    REQUIRE ( traits::outDegree(wd, 1) == 3 );
+    REQUIRE ( traits::outDegree(wd, 5) == 0 );
+    requireDenseIndex(wd);
+    requireDenseIndex(split);
+  }
+
+  SECTION("CompressedGraph") {
+    typedef graph_traits<CompressedGraph<int> > traits;
+    const CompressedGraph<int> c(g, std::vector<int>({4, 3, 2, 1}));
+    REQUIRE ( traits::numberOfVertices(c) == 4 );
+    REQUIRE ( verticesOf(c) == verticesOf(g) );
+    for (const int v : g.vertices()) {
+      REQUIRE ( outEdgesOf(c, v) == outEdgesOf(g, v) );
+      REQUIRE ( traits::outDegree(c, v) == graph_traits<Graph<int> >::outDegree(g, v) );
+    }
+    REQUIRE ( outEdgesOf(c, 5).empty() );
+    REQUIRE ( traits::outDegree(c, 5) == 0 );
+
+    // the dense ids of the given order
+    REQUIRE ( traits::indexMap(c)(4) == 0 );
+    REQUIRE ( traits::indexMap(c)(1) == 3 );
+    requireDenseIndex(c);
+  }
+}
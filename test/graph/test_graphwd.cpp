@@ -0,0 +1,198 @@
+#include <graph/graphwd.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <numeric>
+#include <tuple>
+
+namespace {
+
+/// As (source, destination, weight), the edge types of the layouts differ.
+template <typename G>
+std::vector<std::tuple<int, int, float> > sortedEdges(const G& g)
+{
+  std::vector<std::tuple<int, int, float> > retval;
+  for (const auto& e : g.edges())
+    retval.push_back(std::make_tuple(e.source, e.destination, e.weight));
+  std::sort(retval.begin(), retval.end());
+  return retval;
+}
+
+/// Same mutations on a graph of each layout, the same edges after every one.
+void requireSameAsEdgeToLayout(bool directed)
+{
+  GraphWD<int, float> reference(directed);
+  GraphWD<int, float, SPLIT_LAYOUT> split(directed);
+  std::srand(directed ? 5 : 6);
+  for (int step = 0; step < 2000; ++step) {
+    const int a = std::rand() % 40, b = std::rand() % 40;
+    const float w = float(std::rand() % 4);
+    switch (step % 7) {
+      case 0: reference.removeVertex(a); split.removeVertex(a); break;
+      case 1: reference.removeEdge(a, b, w); split.removeEdge(a, b, w); break;
+      case 2: reference.removeEdges(a, b); split.removeEdges(a, b); break;
+      default: reference.addEdge(a, b, w); split.addEdge(a, b, w); break;
+    }
+
+    REQUIRE ( split.numberOfVertices() == reference.numberOfVertices() );
+    REQUIRE ( split.numberOfEdges() == reference.numberOfEdges() );
+  }
+
+  REQUIRE ( sortedEdges(split) == sortedEdges(reference) );
+  for (const int v : reference.vertices()) {
+    REQUIRE ( split.neighboursOf(v) == reference.neighboursOf(v) );
+    REQUIRE ( split.destinationsFrom(v).size() == split.weightsFrom(v).size() );
+    for (const int n : reference.neighboursOf(v))
+      REQUIRE ( split.weights(v, n) == reference.weights(v, n) );
+  }
+}
+
+/// After the collapse weight(v, n) is the merge of what weights(v, n) was, one edge each.
+template <GraphWDLayout L>
+void requireCollapsed(bool directed, ParallelEdgeMerge merge)
+{
+  GraphWD<int, int, L> g(directed);
+  std::srand(directed ? 7 : 8);
+  for (int i = 0; i < 3000; ++i)
+    g.addEdge(std::rand() % 60, std::rand() % 60, std::rand() % 100);
+  const GraphWD<int, int, L> reference(g);
+
+  g.collapseParallelEdges(merge);
+  std::size_t number_of_edges = 0;
+  for (const int v : reference.vertices()) {
+    REQUIRE ( g.neighboursOf(v).size() == reference.neighboursOf(v).size() );
+    for (const int n : reference.neighboursOf(v)) {
+      const std::vector<int> w = reference.weights(v, n);
+      int expected = w.front();
+      for (const int x : w)
+        expected = merge == KEEP_MIN_WEIGHT ? std::min(expected, x) :
+                   merge == KEEP_MAX_WEIGHT ? std::max(expected, x) : expected;
+      if (merge == SUM_WEIGHTS)
+        expected = std::accumulate(w.begin(), w.end(), 0);
+
+      REQUIRE ( g.weights(v, n) == std::vector<int>({expected}) );
+      REQUIRE ( g.weight(v, n) != nullptr );
+      REQUIRE ( *g.weight(v, n) == expected );
+      if (!directed)
+        REQUIRE ( *g.weight(n, v) == expected );
+      ++number_of_edges;
+    }
+    REQUIRE ( g.weight(v, 60) == nullptr );
+  }
+  REQUIRE ( g.numberOfEdges() == number_of_edges );
+}
+
+} // anonym namespace
+
+TEST_CASE( "GraphWD split layout", "[graphwd][data_structure]" ) {
+
+  SECTION("edges of a vertex are parallel arrays") {
+    GraphWD<int, float, SPLIT_LAYOUT> g;
+    g.addEdge(1, 2, 0.5f);
+    g.addEdge(1, 3, 1.5f);
+    g.addEdge(1, 2, 2.5f);
+    REQUIRE ( g.destinationsFrom(1) == std::vector<int>({2, 3, 2}) );
+    REQUIRE ( g.weightsFrom(1) == std::vector<float>({0.5f, 1.5f, 2.5f}) );
+    REQUIRE ( g.destinationsFrom(2).empty() );
+    REQUIRE ( g.weightsFrom(4).empty() );
+    REQUIRE ( g.weights(1, 2) == std::vector<float>({0.5f, 2.5f}) );
+    REQUIRE ( g.neighboursOf(1) == std::vector<int>({2, 3}) );
+
+    g.removeEdge(1, 2, 0.5f);
+    REQUIRE ( g.destinationsFrom(1) == std::vector<int>({3, 2}) );
+    REQUIRE ( g.weightsFrom(1) == std::vector<float>({1.5f, 2.5f}) );
+
+    std::vector<float> visited;
+    g.forEachEdgeFrom(1, [&visited](int, float w) { visited.push_back(w); });
+    REQUIRE ( visited == g.weightsFrom(1) );
+  }
+
+  SECTION("undirected, self edges") {
+    GraphWD<int, int, SPLIT_LAYOUT> g(false);
+    g.addEdge(1, 1, 7);
+    g.addEdge(1, 2, 3);
+    REQUIRE ( g.numberOfEdges() == 3 );
+    REQUIRE ( g.weightsFrom(2) == std::vector<int>({3}) );
+
+    g.removeVertex(1);
+    REQUIRE ( g.numberOfVertices() == 1 );
+    REQUIRE ( g.numberOfEdges() == 0 );
+  }
+
+  SECTION("copies are independent") {
+    GraphWD<int, int, SPLIT_LAYOUT> g(false);
+    g.addEdge(1, 2, 3);
+    GraphWD<int, int, SPLIT_LAYOUT> copy(g);
+    g.clear();
+    REQUIRE ( copy.weights(2, 1) == std::vector<int>({3}) );
+    REQUIRE ( copy.edges().size() == 2 );
+  }
+
+  SECTION("same as the edge to layout, directed") {
+    requireSameAsEdgeToLayout(true);
+  }
+
+  SECTION("same as the edge to layout, undirected") {
+    requireSameAsEdgeToLayout(false);
+  }
+}
+
+TEST_CASE( "GraphWD collapsed parallel edges", "[graphwd][data_structure]" ) {
+
+  SECTION("min, max and sum") {
+    GraphWD<int, float> g;
+    g.addEdge(1, 2, 3.0f);
+    g.addEdge(1, 3, 1.0f);
+    g.addEdge(1, 2, 0.5f);
+    g.addEdge(1, 2, 2.0f);
+    REQUIRE ( *g.weight(1, 2) == 3.0f ); // the first of the parallel edges
+    REQUIRE ( g.weight(2, 1) == nullptr );
+    REQUIRE ( g.weight(4, 1) == nullptr );
+
+    GraphWD<int, float> max(g), sum(g);
+    g.collapseParallelEdges();
+    max.collapseParallelEdges(KEEP_MAX_WEIGHT);
+    sum.collapseParallelEdges(SUM_WEIGHTS);
+    REQUIRE ( g.numberOfEdges() == 2 );
+    REQUIRE ( *g.weight(1, 2) == 0.5f );
+    REQUIRE ( *g.weight(1, 3) == 1.0f );
+    REQUIRE ( *max.weight(1, 2) == 3.0f );
+    REQUIRE ( *sum.weight(1, 2) == 5.5f );
+
+    std::size_t visited = 0;
+    g.forEachEdgeFrom(1, [&visited](int, float) { ++visited; });
+    REQUIRE ( visited == 2 );
+  }
+
+  SECTION("edges added after the collapse are found") {
+    GraphWD<int, int, SPLIT_LAYOUT> g;
+    for (int i = 0; i < 50; ++i)
+      g.addEdge(0, i, i);
+    g.collapseParallelEdges();
+    g.addEdge(0, 100, 7);
+    g.addEdge(0, 3, 1);
+    REQUIRE ( *g.weight(0, 100) == 7 );
+    REQUIRE ( *g.weight(0, 3) == 3 );
+    REQUIRE ( g.destinationsFrom(0).size() == 52 );
+
+    g.removeEdges(0, 100);
+    g.collapseParallelEdges();
+    REQUIRE ( *g.weight(0, 3) == 1 );
+    REQUIRE ( g.weight(0, 100) == nullptr );
+    REQUIRE ( g.destinationsFrom(0).size() == 50 );
+  }
+
+  SECTION("against weights(), directed and undirected, both layouts") {
+    const ParallelEdgeMerge merges[] = { KEEP_MIN_WEIGHT, KEEP_MAX_WEIGHT, SUM_WEIGHTS };
+    for (const ParallelEdgeMerge merge : merges) {
+      requireCollapsed<EDGE_TO_LAYOUT>(true, merge);
+      requireCollapsed<EDGE_TO_LAYOUT>(false, merge);
+      requireCollapsed<SPLIT_LAYOUT>(true, merge);
+      requireCollapsed<SPLIT_LAYOUT>(false, merge);
+    }
+  }
+}
@@ -0,0 +1,205 @@
+#include <graph/hierarchical_pathfinding.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <cstdlib>
+#include <type_traits>
+
+namespace {
+
+bool validPath(const std::vector<size_t2>& path, const ImageMatrix& m)
+{
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    if (m.cells_[path[i].y * m.width_ + path[i].x] != ImageMatrix::FREE)
+      return false;
+    if (i == 0)
+      continue;
+
+    const std::size_t dx = path[i].x > path[i-1].x ? path[i].x - path[i-1].x : path[i-1].x - path[i].x;
+    const std::size_t dy = path[i].y > path[i-1].y ? path[i].y - path[i-1].y : path[i-1].y - path[i].y;
+    if (dx > 1 || dy > 1 || dx + dy == 0)
+      return false;
+    if (dx == 1 && dy == 1 &&
+        (m.cells_[path[i-1].y * m.width_ + path[i].x] != ImageMatrix::FREE ||
+         m.cells_[path[i].y * m.width_ + path[i-1].x] != ImageMatrix::FREE))
+      return false;
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Hierarchical pathfinding", "[hierarchical_pathfinding][algorithm]" ) {
+
+  SECTION("open map") {
+    const ImageMatrix m(40, 40, std::vector<ImageMatrix::CellType>(40 * 40, ImageMatrix::FREE));
+    HierarchicalPathfinder hpa(m, 8);
+
+    REQUIRE( hpa.abstractGraph().empty() == false );
+
+    const std::vector<size_t2> path = hpa.findPath(size_t2(1, 2), size_t2(37, 30));
+    REQUIRE( path.empty() == false );
+    REQUIRE( path.front() == size_t2(1, 2) );
+    REQUIRE( path.back() == size_t2(37, 30) );
+    REQUIRE( validPath(path, m) );
+
+    // near-optimal: within 10% of the octile distance
+    const float optimal = 28 * std::sqrt(2.0f) + 8;
+    REQUIRE( HierarchicalPathfinder::pathLength(path) >= optimal - 1e-3f );
+    REQUIRE( HierarchicalPathfinder::pathLength(path) <= optimal * 1.1f );
+  }
+
+  SECTION("same cell and same cluster") {
+    const ImageMatrix m(16, 16, std::vector<ImageMatrix::CellType>(16 * 16, ImageMatrix::FREE));
+    HierarchicalPathfinder hpa(m, 8);
+
+    const std::vector<size_t2> single = hpa.findPath(size_t2(3, 3), size_t2(3, 3));
+    REQUIRE( single.size() == 1 );
+
+    const std::vector<size_t2> local = hpa.findPath(size_t2(1, 1), size_t2(6, 1));
+    REQUIRE( local.size() == 6 );
+    REQUIRE( validPath(local, m) );
+  }
+
+  SECTION("detour through a gap") {
+    const ImageMatrix m = parseMap({
+      "............",
+      "............",
+      "............",
+      "............",
+      "#########...",
+      "............",
+      "............",
+      "............" });
+    HierarchicalPathfinder hpa(m, 4);
+
+    const std::vector<size_t2> path = hpa.findPath(size_t2(0, 0), size_t2(0, 7));
+    REQUIRE( path.empty() == false );
+    REQUIRE( validPath(path, m) );
+    REQUIRE( path.back() == size_t2(0, 7) );
+  }
+
+  SECTION("leaving the cluster to reach a goal inside it") {
+    const ImageMatrix m = parseMap({
+      "..#.....",
+      "..#.....",
+      "..#.....",
+      "..#.....",
+      "........",
+      "........",
+      "........",
+      "........" });
+    HierarchicalPathfinder hpa(m, 4);
+
+    const std::vector<size_t2> path = hpa.findPath(size_t2(0, 0), size_t2(3, 0));
+    REQUIRE( path.empty() == false );
+    REQUIRE( validPath(path, m) );
+  }
+
+  SECTION("unreachable and blocked endpoints") {
+    const ImageMatrix m = parseMap({
+      "....#....",
+      "....#....",
+      "....#....",
+      "....#...." });
+    HierarchicalPathfinder hpa(m, 3);
+
+    REQUIRE( hpa.findPath(size_t2(0, 0), size_t2(8, 3)).empty() == true );
+    REQUIRE( hpa.findPath(size_t2(0, 0), size_t2(4, 0)).empty() == true );
+    REQUIRE( hpa.findPath(size_t2(0, 0), size_t2(9, 0)).empty() == true );
+    REQUIRE( hpa.findPath(size_t2(0, 0), size_t2(3, 3)).empty() == false );
+  }
+
+  SECTION("random maps are solved whenever a path exists") {
+    std::srand(7);
+    const std::size_t w = 48, h = 32;
+    std::vector<ImageMatrix::CellType> cells(w * h);
+    for (auto& c : cells)
+      c = (std::rand() % 4 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+    cells[0] = ImageMatrix::FREE;
+    const ImageMatrix m(w, h, cells);
+    HierarchicalPathfinder hpa(m, 8);
+
+    // flood fill from (0, 0) with the same movement rules
+    std::vector<bool> reached(w * h, false);
+    std::vector<std::size_t> stack(1, 0);
+    reached[0] = true;
+    while (!stack.empty()) {
+      const std::size_t u = stack.back();
+      stack.pop_back();
+      const std::size_t ux = u % w, uy = u / w;
+      for (int dy = -1; dy <= 1; ++dy)
+        for (int dx = -1; dx <= 1; ++dx) {
+          const std::size_t vx = ux + dx, vy = uy + dy;
+          if (vx >= w || vy >= h || reached[vy * w + vx] || cells[vy * w + vx] != ImageMatrix::FREE)
+            continue;
+          if (dx != 0 && dy != 0 && (cells[uy * w + vx] != ImageMatrix::FREE || cells[vy * w + ux] != ImageMatrix::FREE))
+            continue;
+          reached[vy * w + vx] = true;
+          stack.push_back(vy * w + vx);
+        }
+    }
+
+    for (std::size_t i = 1; i < w * h; i += 37) {
+      if (cells[i] != ImageMatrix::FREE)
+        continue;
+      const std::vector<size_t2> path = hpa.findPath(size_t2(0, 0), size_t2(i % w, i / w));
+      REQUIRE( path.empty() == !reached[i] );
+      REQUIRE( validPath(path, m) );
+    }
+  }
+
+  SECTION("stored cluster paths are walked both ways") {
+    std::srand(3);
+    const std::size_t w = 96, h = 96;
+    std::vector<ImageMatrix::CellType> cells(w * h);
+    for (auto& c : cells)
+      c = (std::rand() % 5 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+    const ImageMatrix m(w, h, cells);
+    HierarchicalPathfinder hpa(m, 8);
+
+    for (int i = 0; i < 60; ++i) {
+      const size_t2 a(std::rand() % w, std::rand() % h);
+      const size_t2 b(std::rand() % w, std::rand() % h);
+      const std::vector<size_t2> there = hpa.findPath(a, b);
+      const std::vector<size_t2> back = hpa.findPath(b, a);
+      REQUIRE( there.empty() == back.empty() );
+      if (there.empty())
+        continue;
+
+      REQUIRE( validPath(there, m) );
+      REQUIRE( validPath(back, m) );
+      REQUIRE( there.front() == a );
+      REQUIRE( there.back() == b );
+      REQUIRE( back.front() == b );
+      REQUIRE( back.back() == a );
+    }
+  }
+
+  SECTION("a query does not see the state of the previous ones") {
+    std::srand(11);
+    const std::size_t w = 64, h = 64;
+    std::vector<ImageMatrix::CellType> cells(w * h);
+    for (auto& c : cells)
+      c = (std::rand() % 5 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+    const ImageMatrix m(w, h, cells);
+    HierarchicalPathfinder reused(m, 8);
+
+    for (int i = 0; i < 40; ++i) {
+      const size_t2 start(std::rand() % w, std::rand() % h);
+      const size_t2 goal(std::rand() % w, std::rand() % h);
+      HierarchicalPathfinder fresh(m, 8);
+      REQUIRE( reused.findPath(start, goal) == fresh.findPath(start, goal) );
+    }
+  }
+
+  SECTION("the image is referenced, a temporary is rejected") {
+    static_assert(!std::is_constructible<HierarchicalPathfinder, ImageMatrix&&>::value,
+                  "built from a temporary image");
+    static_assert(std::is_constructible<HierarchicalPathfinder, const ImageMatrix&>::value,
+                  "built from an image");
+  }
+}
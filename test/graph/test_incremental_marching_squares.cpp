@@ -0,0 +1,119 @@
+#include <graph/incremental_marching_squares.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <cstdlib>
+
+namespace {
+
+Graph<float2> contourGraph(const std::vector< std::pair<size_t2, size_t2> >& segments)
+{
+  Graph<float2> g;
+  for (const auto& s : segments)
+    g.addEdge(float2(s.first.x, s.first.y), float2(s.second.x, s.second.y));
+
+  return g;
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Incremental marching squares", "[marching_squares][algorithm]" ) {
+
+  SECTION("initial contour") {
+    const std::vector<ImageMatrix::CellType> dot_v {
+      ImageMatrix::FREE, ImageMatrix::FREE,  ImageMatrix::FREE,
+      ImageMatrix::FREE, ImageMatrix::SOLID, ImageMatrix::FREE,
+      ImageMatrix::FREE, ImageMatrix::FREE,  ImageMatrix::FREE
+    };
+    const ImageMatrix dot_i(3, 3, dot_v);
+    const IncrementalMarchingSquares ims(dot_i);
+    REQUIRE ( ims.numberOfSegments() == 4 );
+    REQUIRE ( ims.segments() == marchingSquares(dot_i) );
+  }
+
+  SECTION("growing a dot into a line") {
+    SolidMask mask(6, 3);
+    mask.set(1, 1, true);
+    IncrementalMarchingSquares ims(mask);
+
+    const ContourDiff diff = ims.setCell(size_t2(2, 1), ImageMatrix::DESTROYABLE);
+    REQUIRE ( diff.removed.size() == 3 );
+    REQUIRE ( diff.added.size() == 3 );
+    REQUIRE ( std::find(diff.added.begin(), diff.added.end(), ContourDiff::segment(size_t2(1, 1), size_t2(3, 1))) != diff.added.end() );
+    REQUIRE ( std::find(diff.removed.begin(), diff.removed.end(), ContourDiff::segment(size_t2(1, 1), size_t2(1, 2))) == diff.removed.end() );
+
+    const ContourDiff unchanged = ims.setCell(size_t2(2, 1), ImageMatrix::SOLID);
+    REQUIRE ( unchanged.added.empty() );
+    REQUIRE ( unchanged.removed.empty() );
+  }
+
+  SECTION("random edits match a full recomputation") {
+    std::srand(9);
+    const std::size_t w = 70, h = 40;
+    std::vector<ImageMatrix::CellType> cells(w * h);
+    for (auto& c : cells)
+      c = (std::rand() % 4 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+    const ImageMatrix image(w, h, cells);
+
+    IncrementalMarchingSquares ims(image);
+    SolidMask reference(image);
+    Graph<float2> g = contourGraph(marchingSquares(image));
+
+    for (int edit = 0; edit < 200; ++edit) {
+      std::vector<IncrementalMarchingSquares::cell_change> changes;
+      const std::size_t n = 1 + std::rand() % 5;
+      for (std::size_t i = 0; i < n; ++i) {
+        const size_t2 c(std::rand() % w, std::rand() % h);
+        const bool solid = std::rand() % 2 == 0;
+        changes.push_back(IncrementalMarchingSquares::cell_change(c, solid ? ImageMatrix::SOLID : ImageMatrix::FREE));
+        reference.set(c.x, c.y, solid);
+      }
+
+      const ContourDiff diff = ims.setCells(changes);
+      const std::vector< std::pair<size_t2, size_t2> > expected = marchingSquares(reference);
+      REQUIRE ( ims.segments() == expected );
+
+      applyContourDiff(g, diff);
+      REQUIRE ( g == contourGraph(expected) );
+    }
+  }
+
+  SECTION("edits split and merge long runs") {
+    std::srand(13);
+    const std::size_t w = 120, h = 40;
+    std::vector<ImageMatrix::CellType> cells(w * h, ImageMatrix::FREE);
+    for (std::size_t y = 0; y < h; ++y)
+      for (std::size_t x = 0; x < w; ++x)
+        if ((y >= 10 && y < 20) || (x >= 50 && x < 56))
+          cells[y * w + x] = ImageMatrix::SOLID;
+    const ImageMatrix image(w, h, cells);
+
+    IncrementalMarchingSquares ims(image);
+    SolidMask reference(image);
+    Graph<float2> g = contourGraph(marchingSquares(image));
+
+    for (int edit = 0; edit < 300; ++edit) {
+      // a short horizontal or vertical streak near the band borders, sometimes undone later
+      std::vector<IncrementalMarchingSquares::cell_change> changes;
+      const bool along_x = std::rand() % 2 == 0;
+      const std::size_t x0 = along_x ? std::rand() % w : 48 + std::rand() % 10;
+      const std::size_t y0 = along_x ? 8 + std::rand() % 14 : std::rand() % h;
+      const bool solid = std::rand() % 2 == 0;
+      for (std::size_t i = 0, n = 1 + std::rand() % 4; i < n; ++i) {
+        const size_t2 c(along_x ? (x0 + i) % w : x0, along_x ? y0 : (y0 + i) % h);
+        changes.push_back(IncrementalMarchingSquares::cell_change(c, solid ? ImageMatrix::SOLID : ImageMatrix::FREE));
+        reference.set(c.x, c.y, solid);
+      }
+
+      const ContourDiff diff = ims.setCells(changes);
+      const std::vector< std::pair<size_t2, size_t2> > expected = marchingSquares(reference);
+      REQUIRE ( ims.segments() == expected );
+
+      applyContourDiff(g, diff);
+      REQUIRE ( g == contourGraph(expected) );
+    }
+  }
+}
@@ -0,0 +1,164 @@
+#include <graph/jump_point_search.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <cstdlib>
+
+namespace {
+
+bool free(const ImageMatrix& m, std::size_t x, std::size_t y)
+{
+  return x < m.width_ && y < m.height_ && m.cells_[y * m.width_ + x] == ImageMatrix::FREE;
+}
+
+/// Length of the expanded path, negative if it is not a valid walk on the grid.
+float pathLength(const std::vector<size_t2>& jump_points, const ImageMatrix& m)
+{
+  const std::vector<size_t2> path = expandJumpPath(jump_points);
+  float length = 0.0f;
+  for (std::size_t i = 0; i < path.size(); ++i) {
+    if (!free(m, path[i].x, path[i].y))
+      return -1.0f;
+    if (i == 0)
+      continue;
+
+    const bool diagonal = path[i].x != path[i-1].x && path[i].y != path[i-1].y;
+    if (diagonal && (!free(m, path[i-1].x, path[i].y) || !free(m, path[i].x, path[i-1].y)))
+      return -1.0f;
+    length += diagonal ? std::sqrt(2.0f) : 1.0f;
+  }
+  return length;
+}
+
+/// Reference: Dijkstra on the cells, same movement rules.
+float gridDistance(const ImageMatrix& m, const size_t2& start, const size_t2& goal)
+{
+  std::vector<float> dist(m.width_ * m.height_, std::numeric_limits<float>::infinity());
+  std::priority_queue<std::pair<float, std::size_t>, std::vector<std::pair<float, std::size_t> >,
+                      std::greater<std::pair<float, std::size_t> > > q;
+  dist[start.y * m.width_ + start.x] = 0.0f;
+  q.push(std::make_pair(0.0f, start.y * m.width_ + start.x));
+  while (!q.empty()) {
+    const std::pair<float, std::size_t> top = q.top();
+    q.pop();
+    if (top.first > dist[top.second])
+      continue;
+
+    const std::size_t ux = top.second % m.width_, uy = top.second / m.width_;
+    for (int dy = -1; dy <= 1; ++dy)
+      for (int dx = -1; dx <= 1; ++dx) {
+        const std::size_t vx = ux + dx, vy = uy + dy;
+        if ((dx == 0 && dy == 0) || !free(m, vx, vy))
+          continue;
+        if (dx != 0 && dy != 0 && (!free(m, vx, uy) || !free(m, ux, vy)))
+          continue;
+
+        const float alt = top.first + ((dx != 0 && dy != 0) ? std::sqrt(2.0f) : 1.0f);
+        if (alt < dist[vy * m.width_ + vx]) {
+          dist[vy * m.width_ + vx] = alt;
+          q.push(std::make_pair(alt, vy * m.width_ + vx));
+        }
+      }
+  }
+  return dist[goal.y * m.width_ + goal.x];
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Jump point search", "[jump_point_search][algorithm]" ) {
+
+  SECTION("open map needs only a few jump points") {
+    const ImageMatrix m(64, 64, std::vector<ImageMatrix::CellType>(64 * 64, ImageMatrix::FREE));
+    const JumpPointSearch jps(m);
+    const JumpPointSearchPlus jps_plus(m);
+
+    const std::vector<size_t2> path = jps.findPath(size_t2(1, 1), size_t2(60, 20));
+    REQUIRE( path.size() <= 3 );
+    REQUIRE( path.front() == size_t2(1, 1) );
+    REQUIRE( path.back() == size_t2(60, 20) );
+    REQUIRE( pathLength(path, m) == Approx(19 * std::sqrt(2.0f) + 40) );
+
+    const std::vector<size_t2> path_plus = jps_plus.findPath(size_t2(1, 1), size_t2(60, 20));
+    REQUIRE( path_plus.size() <= 3 );
+    REQUIRE( pathLength(path_plus, m) == Approx(pathLength(path, m)) );
+  }
+
+  SECTION("start is goal") {
+    const ImageMatrix m(4, 4, std::vector<ImageMatrix::CellType>(4 * 4, ImageMatrix::FREE));
+    REQUIRE( JumpPointSearch(m).findPath(size_t2(2, 2), size_t2(2, 2)).size() == 1 );
+    REQUIRE( JumpPointSearchPlus(m).findPath(size_t2(2, 2), size_t2(2, 2)).size() == 1 );
+  }
+
+  SECTION("no corner cutting") {
+    const ImageMatrix m = parseMap({
+      "..#",
+      "#..",
+      "..." });
+    const JumpPointSearch jps(m);
+    const JumpPointSearchPlus jps_plus(m);
+
+    REQUIRE( pathLength(jps.findPath(size_t2(0, 0), size_t2(2, 1)), m) == Approx(3.0f) );
+    REQUIRE( pathLength(jps_plus.findPath(size_t2(0, 0), size_t2(2, 1)), m) == Approx(3.0f) );
+  }
+
+  SECTION("jump distances") {
+    const ImageMatrix m = parseMap({
+      ".....",
+      "...#.",
+      "....." });
+    const JumpPointSearchPlus jps_plus(m);
+
+    REQUIRE( jps_plus.jumpDistance(0, 0, 2) == 4 );   // east: (4, 0) has a forced neighbour below
+    REQUIRE( jps_plus.jumpDistance(0, 1, 2) == -2 );  // east: wall after 2 steps
+    REQUIRE( jps_plus.jumpDistance(4, 1, 2) == 0 );   // east: border
+    REQUIRE( jps_plus.jumpDistance(0, 1, 0) == -1 );  // north
+  }
+
+  SECTION("unreachable and blocked endpoints") {
+    const ImageMatrix m = parseMap({
+      "..#..",
+      "..#..",
+      "..#.." });
+    const JumpPointSearch jps(m);
+    const JumpPointSearchPlus jps_plus(m);
+
+    REQUIRE( jps.findPath(size_t2(0, 0), size_t2(4, 2)).empty() == true );
+    REQUIRE( jps_plus.findPath(size_t2(0, 0), size_t2(4, 2)).empty() == true );
+    REQUIRE( jps.findPath(size_t2(0, 0), size_t2(2, 0)).empty() == true );
+    REQUIRE( jps_plus.findPath(size_t2(0, 0), size_t2(5, 0)).empty() == true );
+  }
+
+  SECTION("random maps give optimal paths") {
+    std::srand(11);
+    for (int map = 0; map < 5; ++map) {
+      const std::size_t w = 40, h = 30;
+      std::vector<ImageMatrix::CellType> cells(w * h);
+      for (auto& c : cells)
+        c = (std::rand() % 3 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+      const ImageMatrix m(w, h, cells);
+      const JumpPointSearch jps(m);
+      const JumpPointSearchPlus jps_plus(m);
+
+      for (int query = 0; query < 40; ++query) {
+        const size_t2 start(std::rand() % w, std::rand() % h);
+        const size_t2 goal(std::rand() % w, std::rand() % h);
+        if (!free(m, start.x, start.y) || !free(m, goal.x, goal.y))
+          continue;
+
+        const float expected = gridDistance(m, start, goal);
+        const std::vector<size_t2> path = jps.findPath(start, goal);
+        const std::vector<size_t2> path_plus = jps_plus.findPath(start, goal);
+        if (expected == std::numeric_limits<float>::infinity()) {
+          REQUIRE( path.empty() == true );
+          REQUIRE( path_plus.empty() == true );
+        } else {
+          REQUIRE( pathLength(path, m) == Approx(expected) );
+          REQUIRE( pathLength(path_plus, m) == Approx(expected) );
+        }
+      }
+    }
+  }
+}
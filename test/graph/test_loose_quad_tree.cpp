@@ -0,0 +1,169 @@
+#include <graph/loose_quad_tree.hpp>
+#include <graph/marching_squares.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+struct Box {
+  float x, y, half;
+  int id;
+};
+
+bool boxesIntersect(const Box& b, const AABB<float2>& range)
+{
+  return std::fabs(b.x - range.m_center.x) <= b.half + range.m_halfWidth &&
+         std::fabs(b.y - range.m_center.y) <= b.half + range.m_halfHeight;
+}
+
+std::vector<int> sorted(std::vector<int> v)
+{
+  std::sort(v.begin(), v.end());
+  return v;
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Loose quad tree", "[loose_quad_tree][quad_tree][data_structure]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 100);
+
+  SECTION("empty") {
+    const LooseQuadTree<float2, int> t(boundary);
+    REQUIRE ( t.empty() );
+    REQUIRE ( t.queryRange(boundary).empty() );
+    REQUIRE ( t.numberOfNodes() == 1 );
+  }
+
+  SECTION("an object is found from every side it overlaps") {
+    LooseQuadTree<float2, int> t(boundary, 1);
+    for (int i = 0; i < 20; ++i)
+      t.insert(AABB<float2>(float2(-90 + 9 * i, -90 + 9 * i), 0.5f), i);
+    // across the center lines of the root and of its children
+    t.insert(AABB<float2>(float2(0.5f, -0.5f), 3), 100);
+    REQUIRE ( t.numberOfNodes() > 1 );
+
+    REQUIRE ( t.queryRange(AABB<float2>(float2(3, -3), 0.1f)) == std::vector<int>(1, 100) );
+    REQUIRE ( t.queryRange(AABB<float2>(float2(-2.4f, 2.4f), 0.1f)) == std::vector<int>(1, 100) );
+    REQUIRE ( t.queryRange(AABB<float2>(float2(-3, 3), 0.4f)).empty() );
+  }
+
+  SECTION("objects outside of the boundary are kept") {
+    LooseQuadTree<float2, int> t(boundary, 2);
+    t.insert(AABB<float2>(float2(500, 0), 1), 1);
+    t.insert(AABB<float2>(float2(0, 0), 1000), 2);
+    for (int i = 0; i < 10; ++i)
+      t.insert(AABB<float2>(float2(i, i), 0), 10 + i);
+    REQUIRE ( t.size() == 12 );
+    REQUIRE ( sorted(t.queryRange(AABB<float2>(float2(500, 0), 0))) == std::vector<int>({ 1, 2 }) );
+    REQUIRE ( t.remove(AABB<float2>(float2(500, 0), 1), 1) == true );
+    REQUIRE ( t.queryRange(AABB<float2>(float2(500, 0), 0)) == std::vector<int>(1, 2) );
+  }
+
+  SECTION("remove needs the same box and value") {
+    LooseQuadTree<float2, int> t(boundary, 2);
+    t.insert(AABB<float2>(float2(1, 1), 1), 7);
+    REQUIRE ( t.remove(AABB<float2>(float2(1, 1), 1), 8) == false );
+    REQUIRE ( t.remove(AABB<float2>(float2(1, 1), 2), 7) == false );
+    REQUIRE ( t.remove(AABB<float2>(float2(1, 1), 1), 7) == true );
+    REQUIRE ( t.empty() );
+  }
+
+  SECTION("random boxes, same queries as a linear scan") {
+    std::srand(23);
+    for (const std::size_t capacity : { 1, 4, 16 }) {
+      LooseQuadTree<float2, int> t(boundary, capacity);
+      std::vector<Box> boxes;
+      for (int i = 0; i < 1500; ++i) {
+        // mostly small, some large
+        const Box b = { float(std::rand() % 2001) / 10 - 100, float(std::rand() % 2001) / 10 - 100,
+                        float(std::rand() % (i % 10 == 0 ? 400 : 20)) / 10, i };
+        boxes.push_back(b);
+        t.insert(AABB<float2>(float2(b.x, b.y), b.half), b.id);
+      }
+
+      for (int round = 0; round < 2; ++round) {
+        for (int q = 0; q < 30; ++q) {
+          const AABB<float2> range(float2(std::rand() % 200 - 100, std::rand() % 200 - 100), std::rand() % 30);
+          std::vector<int> expected;
+          for (const auto& b : boxes)
+            if (boxesIntersect(b, range))
+              expected.push_back(b.id);
+          REQUIRE ( sorted(t.queryRange(range)) == sorted(expected) );
+        }
+
+        // remove most, the nodes get merged
+        const std::size_t nodes = t.numberOfNodes();
+        while (boxes.size() > 100) {
+          const std::size_t i = std::rand() % boxes.size();
+          const Box& b = boxes[i];
+          REQUIRE ( t.remove(AABB<float2>(float2(b.x, b.y), b.half), b.id) == true );
+          boxes[i] = boxes.back();
+          boxes.pop_back();
+        }
+        REQUIRE ( t.size() == boxes.size() );
+        REQUIRE ( t.numberOfNodes() <= nodes );
+      }
+    }
+  }
+}
+
+TEST_CASE( "Loose quad tree of segments", "[loose_quad_tree][quad_tree][data_structure]" ) {
+
+  SECTION("rectangular objects") {
+    LooseQuadTree<float2, int> t(AABB<float2>(float2(0, 0), 100, 10), 1);
+    for (int i = 0; i < 30; ++i)
+      t.insert(AABB<float2>(float2(-95 + 6 * i, 0), 2, 0.5f), i);
+    t.insert(AABB<float2>(float2(0, 0), 80, 0.1f), 100); // long and thin
+    REQUIRE ( t.boundary().m_halfHeight == 10 );
+    REQUIRE ( sorted(t.queryRange(AABB<float2>(float2(-70, 0), 0.5f, 5))) == std::vector<int>({ 4, 100 }) );
+    REQUIRE ( sorted(t.queryRange(AABB<float2>(float2(-70, 5), 0.5f, 4))) == std::vector<int>() );
+  }
+
+  SECTION("marching squares edges, same as a linear scan") {
+    std::srand(29);
+    const std::size_t w = 120, h = 40;
+    SolidMask mask(w, h);
+    for (int r = 0; r < 30; ++r) {
+      const std::size_t x0 = std::rand() % w, y0 = std::rand() % h;
+      for (std::size_t y = y0; y < std::min(h, y0 + 1 + std::rand() % 6); ++y)
+        for (std::size_t x = x0; x < std::min(w, x0 + 1 + std::rand() % 12); ++x)
+          mask.set(x, y, true);
+    }
+
+    std::vector< std::pair<float2, float2> > edges;
+    for (const auto& s : marchingSquares(mask))
+      edges.push_back(std::make_pair(float2(s.first.x, s.first.y), float2(s.second.x, s.second.y)));
+    REQUIRE ( edges.size() > 50 );
+
+    LooseQuadTree<float2, std::pair<float2, float2> > t(AABB<float2>(float2(w / 2.0f, h / 2.0f), w / 2.0f, h / 2.0f), 4);
+    for (const auto& e : edges)
+      insertSegment(t, e.first, e.second);
+    REQUIRE ( t.size() == edges.size() );
+
+    for (int q = 0; q < 50; ++q) {
+      const AABB<float2> range(float2(std::rand() % 1200 / 10.0f, std::rand() % 400 / 10.0f),
+                               std::rand() % 40 / 10.0f, std::rand() % 20 / 10.0f);
+      std::size_t expected = 0;
+      for (const auto& e : edges)
+        expected += range.intersectsSegment(e.first, e.second) ? 1 : 0;
+      std::size_t found = 0;
+      forEachSegmentIntersecting(t, range, [&](const float2& a, const float2& b) {
+        REQUIRE ( range.intersectsSegment(a, b) );
+        ++found;
+      });
+      REQUIRE ( found == expected );
+    }
+
+    for (const auto& e : edges)
+      REQUIRE ( removeSegment(t, e.first, e.second) == true );
+    REQUIRE ( t.empty() );
+    REQUIRE ( t.numberOfNodes() == 1 );
+  }
+}
@@ -0,0 +1,60 @@
+#include <graph/luminance.hpp>
+
+#include "../catch.hpp"
+
+#include <cstdlib>
+
+
+TEST_CASE( "Luminance threshold", "[luminance]" ) {
+
+  SECTION("cell types") {
+    REQUIRE( cellOfLuminance(0) == ImageMatrix::SOLID );
+    REQUIRE( cellOfLuminance(15) == ImageMatrix::SOLID );
+    REQUIRE( cellOfLuminance(16) == ImageMatrix::DESTROYABLE );
+    REQUIRE( cellOfLuminance(239) == ImageMatrix::DESTROYABLE );
+    REQUIRE( cellOfLuminance(240) == ImageMatrix::FREE );
+    REQUIRE( cellOfLuminance(255) == ImageMatrix::FREE );
+
+    std::vector<std::uint8_t> row(256);
+    for (std::size_t i = 0; i < row.size(); ++i)
+      row[i] = std::uint8_t(i);
+    std::vector<ImageMatrix::CellType> cells(row.size());
+    luminanceToCells(row.data(), row.size(), cells.data());
+    for (std::size_t i = 0; i < row.size(); ++i)
+      REQUIRE( cells[i] == cellOfLuminance(row[i]) );
+  }
+
+  SECTION("solid bits of rows of any width") {
+    std::srand(5);
+    for (const std::size_t n : { 1, 15, 16, 63, 64, 65, 130, 200 }) {
+      std::vector<std::uint8_t> row(n);
+      for (auto& l : row)
+        l = std::uint8_t(std::rand() % 4 == 0 ? 235 + std::rand() % 21 : std::rand() % 256);
+
+      std::vector<SolidMask::word_type> words((n + 63) / 64, ~SolidMask::word_type(0));
+      luminanceToSolidBits(row.data(), n, words.data());
+      for (std::size_t x = 0; x < words.size() * 64; ++x) {
+        const bool bit = (words[x / 64] >> (x % 64)) & 1;
+        REQUIRE( bit == (x < n && cellOfLuminance(row[x]) != ImageMatrix::FREE) );
+      }
+    }
+  }
+
+  SECTION("images from strided pixels") {
+    std::srand(6);
+    const std::size_t width = 77, height = 9, stride = 80;
+    std::vector<std::uint8_t> pixels(stride * height);
+    for (auto& l : pixels)
+      l = std::uint8_t(std::rand() % 256);
+
+    const ImageMatrix image = imageMatrixFromLuminance(width, height, pixels.data(), stride);
+    REQUIRE( image.width_ == width );
+    REQUIRE( image.height_ == height );
+    for (std::size_t y = 0; y < height; ++y)
+      for (std::size_t x = 0; x < width; ++x)
+        REQUIRE( image.cells_[y * width + x] == cellOfLuminance(pixels[y * stride + x]) );
+
+    const SolidMask mask = solidMaskFromLuminance(width, height, pixels.data(), stride);
+    REQUIRE( mask.bits_ == SolidMask(image).bits_ );
+  }
+}
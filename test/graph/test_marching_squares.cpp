@@ -4,6 +4,8 @@
 
 #include "fixture.hpp"
 
+#include <cstdlib>
+
 
 TEST_CASE( "Marching squares", "[marching_squares][algorithm]" ) {
 
@@ -47,3 +49,70 @@ TEST_CASE( "Marching squares", "[marching_squares][algorithm]" ) {
 
 }
 
+
+TEST_CASE( "Marching squares on a solid mask", "[marching_squares][algorithm]" ) {
+
+  SECTION("empty and degenerate") {
+    REQUIRE ( marchingSquares(SolidMask(0, 0)).empty() );
+    REQUIRE ( marchingSquares(SolidMask(1, 5)).empty() );
+    REQUIRE ( marchingSquares(SolidMask(70, 3)).empty() );
+  }
+
+  SECTION("bits") {
+    SolidMask mask(130, 2);
+    mask.set(129, 1, true);
+    mask.set(64, 0, true);
+    REQUIRE ( mask.solid(129, 1) == true );
+    REQUIRE ( mask.solid(64, 0) == true );
+    REQUIRE ( mask.solid(63, 0) == false );
+    mask.set(64, 0, false);
+    REQUIRE ( mask.solid(64, 0) == false );
+  }
+
+  SECTION("same segments in the same order as on the image") {
+    std::srand(3);
+    const std::size_t sizes[][2] = { {3, 3}, {5, 3}, {63, 7}, {64, 9}, {65, 8}, {130, 40}, {200, 1} };
+    for (const auto& size : sizes) {
+      for (int density = 1; density < 4; ++density) {
+        std::vector<ImageMatrix::CellType> cells(size[0] * size[1]);
+        for (auto& c : cells) {
+          const int r = std::rand() % 8;
+          c = r < density ? ImageMatrix::SOLID : (r == density ? ImageMatrix::DESTROYABLE : ImageMatrix::FREE);
+        }
+        const ImageMatrix image(size[0], size[1], cells);
+        REQUIRE ( marchingSquares(SolidMask(image)) == marchingSquares(image) );
+      }
+    }
+  }
+}
+
+TEST_CASE( "Parallel marching squares", "[marching_squares][algorithm]" ) {
+
+  SECTION("empty") {
+    REQUIRE ( parallelMarchingSquares(SolidMask(0, 0)).empty() );
+    REQUIRE ( parallelMarchingSquares(SolidMask(8, 1), 1).empty() );
+  }
+
+  SECTION("vertical runs crossing seams are not split") {
+    SolidMask mask(4, 20);
+    for (std::size_t y = 2; y < 18; ++y)
+      mask.set(2, y, true);
+
+    const std::vector< std::pair<size_t2, size_t2> > result = parallelMarchingSquares(mask, 3);
+    REQUIRE ( result == marchingSquares(mask) );
+    REQUIRE ( std::find(result.begin(), result.end(), std::pair<size_t2, size_t2>(size_t2(2, 2), size_t2(2, 18)) ) != result.end() );
+  }
+
+  SECTION("same result as the serial run for any band height") {
+    std::srand(5);
+    const std::size_t w = 150, h = 97;
+    std::vector<ImageMatrix::CellType> cells(w * h);
+    for (auto& c : cells)
+      c = (std::rand() % 3 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+    const ImageMatrix image(w, h, cells);
+    const std::vector< std::pair<size_t2, size_t2> > serial = marchingSquares(image);
+
+    for (const std::size_t band_height : { 1, 2, 7, 64, 96, 97, 256 })
+      REQUIRE ( parallelMarchingSquares(image, band_height) == serial );
+  }
+}
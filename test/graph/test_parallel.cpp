@@ -0,0 +1,40 @@
+#include <graph/parallel.hpp>
+
+#include "../catch.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+
+TEST_CASE( "Parallel helpers", "[parallel]" ) {
+
+  SECTION("parallelFor covers the range once") {
+    std::vector<int> hits(1000, 0);
+    parallelFor(hits.size(), 64, [&hits](std::size_t begin, std::size_t end) {
+      for (std::size_t i = begin; i < end; ++i)
+        ++hits[i];
+    });
+    REQUIRE ( std::count(hits.begin(), hits.end(), 1) == 1000 );
+  }
+
+  SECTION("parallelRadixSort sorts by the bit range, stable") {
+    std::srand(8);
+    for (const std::size_t chunk_size : { 1, 7, 64, 100000 }) {
+      std::vector<std::uint64_t> keys(1000);
+      for (std::size_t i = 0; i < keys.size(); ++i)
+        keys[i] = (std::uint64_t(std::rand() % 3000) << 32) | i;
+      std::vector<std::uint64_t> expected(keys);
+      std::sort(expected.begin(), expected.end());
+
+      parallelRadixSort(keys.data(), keys.size(), 32, 44, chunk_size);
+      REQUIRE ( keys == expected );
+    }
+
+    std::vector<std::uint64_t> keys = { 0x35, 0x14, 0x26, 0x17 };
+    parallelRadixSort(keys.data(), keys.size(), 4, 8);
+    REQUIRE ( keys == std::vector<std::uint64_t>({ 0x14, 0x17, 0x26, 0x35 }) );
+
+    parallelRadixSort(nullptr, 0, 0, 64);
+  }
+}
@@ -4,7 +4,10 @@
 
 #include "fixture.hpp"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <limits>
 
 TEST_CASE( "Quad tree, AABB", "[quad_tree][data_structure][AABB]" ) {
 
@@ -82,6 +85,33 @@ TEST_CASE( "Quad tree, AABB", "[quad_tree][data_structure][AABB]" ) {
       const AABB<float2> boundary2(float2(-3.75, -8.75), 1.25);
       REQUIRE( boundary2.containsPoint(float2(-2, -8)) == false);
     }
+
+  SECTION("rectangles") {
+    const AABB<float2> wide(float2(0, 0), 10, 2);
+    REQUIRE( wide.containsPoint(float2(9, 2)) == true );
+    REQUIRE( wide.containsPoint(float2(9, 3)) == false );
+    REQUIRE( wide.intersectsAABB(AABB<float2>(float2(0, 5), 2, 3)) == true );
+    REQUIRE( wide.intersectsAABB(AABB<float2>(float2(0, 5), 3, 2)) == false );
+    REQUIRE( boundary.containsAABB(wide) == true );
+    REQUIRE( wide.containsAABB(boundary) == false );
+    REQUIRE( wide.containsAABB(AABB<float2>(float2(8, 0), 2, 1)) == true );
+
+    const AABB<float2> box = boundingBox(float2(4, -1), float2(-2, 3));
+    REQUIRE( box.m_center == float2(1, 1) );
+    REQUIRE( box.m_halfWidth == 3 );
+    REQUIRE( box.m_halfHeight == 2 );
+  }
+
+  SECTION("intersectsSegment") {
+    const AABB<float2> box(float2(0, 0), 2, 1);
+    REQUIRE( box.intersectsSegment(float2(-5, 0), float2(5, 0)) == true );   // through
+    REQUIRE( box.intersectsSegment(float2(0, 0), float2(0, 0)) == true );    // a point inside
+    REQUIRE( box.intersectsSegment(float2(-5, 1), float2(5, 1)) == true );   // along a side
+    REQUIRE( box.intersectsSegment(float2(0, 3), float2(3, 0)) == true );    // through the corner (2, 1)
+    REQUIRE( box.intersectsSegment(float2(1, 3), float2(4, 0)) == false );   // past the corner, boxes overlap
+    REQUIRE( box.intersectsSegment(float2(3, -5), float2(3, 5)) == false );
+    REQUIRE( box.intersectsSegment(float2(-3, -2), float2(3, 2)) == true );  // diagonal
+  }
 }
 
 TEST_CASE( "Quad tree", "[quad_tree][data_structure]" ) {
@@ -179,3 +209,525 @@ TEST_CASE( "Quad tree", "[quad_tree][data_structure]" ) {
         REQUIRE ( std::find(points.begin(), points.end(), float2(center.x + r, center.y + c)) != points.end() );
   }
 }
+
+TEST_CASE( "Quad tree node pool", "[quad_tree][data_structure]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 100);
+
+  SECTION("leaf capacity") {
+    QuadTree<float2> t1(boundary, 1);
+    QuadTree<float2> t64(boundary, 64);
+    for (int i = 0; i < 64; ++i) {
+      REQUIRE ( t1.insert(float2(i - 32, 32 - i)) == true );
+      REQUIRE ( t64.insert(float2(i - 32, 32 - i)) == true );
+    }
+    REQUIRE ( t1.leafCapacity() == 1 );
+    REQUIRE ( t1.size() == 64 );
+    REQUIRE ( t1.numberOfNodes() > 64 );
+    REQUIRE ( t64.numberOfNodes() == 1 );
+    REQUIRE ( t1.points().size() == 64 );
+    REQUIRE ( t64.points().size() == 64 );
+  }
+
+  SECTION("equal points beyond the leaf capacity") {
+    QuadTree<float2> t(boundary, 2);
+    for (int i = 0; i < 100; ++i)
+      REQUIRE ( t.insert(float2(1, 1)) == true );
+    REQUIRE ( t.size() == 100 );
+    REQUIRE ( t.queryRange(AABB<float2>(float2(1, 1), 0)).size() == 100 );
+    REQUIRE ( t.numberOfNodes() <= 4 * QuadTree<float2>::max_depth + 1 );
+  }
+
+  SECTION("copies are deep") {
+    QuadTree<float2> t(boundary, 4);
+    for (int i = 0; i < 20; ++i)
+      t.insert(float2(i, i));
+
+    QuadTree<float2> copy(t);
+    for (int i = 0; i < 20; ++i)
+      copy.insert(float2(-i, i));
+    REQUIRE ( t.size() == 20 );
+    REQUIRE ( t.points().size() == 20 );
+    REQUIRE ( copy.points().size() == 40 );
+
+    t = copy;
+    t.clear();
+    REQUIRE ( t.empty() );
+    REQUIRE ( t.points().empty() );
+    REQUIRE ( copy.size() == 40 );
+  }
+
+  SECTION("same points as a linear scan") {
+    std::srand(3);
+    for (const std::size_t capacity : { 1, 3, 8, 32 }) {
+      QuadTree<float2> t(boundary, capacity);
+      std::vector<float2> all;
+      for (int i = 0; i < 2000; ++i) {
+        const float2 p(std::rand() % 2001 / 10.0f - 100.0f, std::rand() % 2001 / 10.0f - 100.0f);
+        all.push_back(p);
+        REQUIRE ( t.insert(p) == true );
+      }
+
+      for (int q = 0; q < 20; ++q) {
+        const AABB<float2> range(float2(std::rand() % 200 - 100, std::rand() % 200 - 100), std::rand() % 40);
+        std::size_t expected = 0;
+        for (const auto& p : all)
+          expected += range.containsPoint(p) ? 1 : 0;
+        REQUIRE ( t.queryRange(range).size() == expected );
+        REQUIRE ( t.countRange(range) == expected );
+
+        std::vector<float2> found(expected + 1, float2(1000, 1000));
+        REQUIRE ( t.queryRange(range, found.begin()) == found.begin() + expected );
+        REQUIRE ( found.back() == float2(1000, 1000) );
+        for (std::size_t i = 0; i < expected; ++i)
+          REQUIRE ( range.containsPoint(found[i]) );
+
+        std::size_t visited = 0;
+        t.forEachInRange(range, [&](const float2& p) { visited += range.containsPoint(p) ? 1 : 0; });
+        REQUIRE ( visited == expected );
+      }
+      REQUIRE ( t.countRange(boundary) == all.size() );
+      REQUIRE ( t.countRange(AABB<float2>(float2(0, 0), 1000)) == all.size() );
+    }
+  }
+}
+
+TEST_CASE( "Quad tree nearest neighbours", "[quad_tree][data_structure]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 100);
+  QuadTree<float2> t(boundary, 4);
+
+  SECTION("empty tree") {
+    REQUIRE ( t.nearestNeighbours(float2(0, 0), 3).empty() );
+    REQUIRE ( t.queryRadius(float2(0, 0), 10).empty() );
+  }
+
+  SECTION("fewer points than k") {
+    t.insert(float2(1, 1));
+    t.insert(float2(-50, 50));
+    const std::vector<float2> n = t.nearestNeighbours(float2(-40, 40), 5);
+    REQUIRE ( n.size() == 2 );
+    REQUIRE ( n[0] == float2(-50, 50) );
+    REQUIRE ( n[1] == float2(1, 1) );
+  }
+
+  SECTION("query point outside of the tree") {
+    t.insert(float2(90, 90));
+    t.insert(float2(-90, -90));
+    REQUIRE ( t.nearestNeighbours(float2(500, 500), 1) == std::vector<float2>(1, float2(90, 90)) );
+  }
+
+  SECTION("same distances as a linear scan") {
+    std::srand(4);
+    std::vector<float2> all;
+    for (int i = 0; i < 3000; ++i) {
+      const float2 p(std::rand() % 2001 / 10.0f - 100.0f, std::rand() % 2001 / 10.0f - 100.0f);
+      all.push_back(p);
+      t.insert(p);
+    }
+
+    for (int q = 0; q < 30; ++q) {
+      const float2 c(std::rand() % 240 - 120, std::rand() % 240 - 120);
+      std::vector<float> distances;
+      for (const auto& p : all)
+        distances.push_back(distance(c, p));
+      std::sort(distances.begin(), distances.end());
+
+      for (const std::size_t k : { 1, 7, 60 }) {
+        const std::vector<float2> n = t.nearestNeighbours(c, k);
+        REQUIRE ( n.size() == k );
+        for (std::size_t i = 0; i < k; ++i)
+          REQUIRE ( distance(c, n[i]) == Approx(distances[i]) );
+      }
+
+      const float radius = std::rand() % 30;
+      const std::vector<float2> in_radius = t.queryRadius(c, radius);
+      std::size_t expected = 0;
+      for (const auto& p : all)
+        expected += pow2(p.x - c.x) + pow2(p.y - c.y) <= radius * radius ? 1 : 0;
+      REQUIRE ( in_radius.size() == expected );
+    }
+  }
+}
+
+TEST_CASE( "Quad tree bulk load", "[quad_tree][data_structure]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 100);
+
+  SECTION("empty") {
+    const QuadTree<float2> t(boundary, std::vector<float2>());
+    REQUIRE ( t.empty() );
+    REQUIRE ( t.numberOfNodes() == 1 );
+  }
+
+  SECTION("points outside are dropped") {
+    const QuadTree<float2> t(boundary, { float2(0, 0), float2(200, 0), float2(100, 100) });
+    REQUIRE ( t.size() == 2 );
+  }
+
+  SECTION("equal points") {
+    const QuadTree<float2> t(boundary, std::vector<float2>(50, float2(-3, 7)), 4);
+    REQUIRE ( t.size() == 50 );
+    REQUIRE ( t.countRange(AABB<float2>(float2(-3, 7), 0)) == 50 );
+  }
+
+  SECTION("same queries as inserting one by one") {
+    std::srand(11);
+    std::vector<float2> all;
+    for (int i = 0; i < 5000; ++i) // on a grid, so that many lie on node boundaries
+      all.push_back(float2(std::rand() % 201 - 100, std::rand() % 201 - 100));
+
+    for (const std::size_t capacity : { 1, 6, 16 }) {
+      const QuadTree<float2> bulk(boundary, all, capacity);
+      QuadTree<float2> inserted(boundary, capacity);
+      for (const auto& p : all)
+        inserted.insert(p);
+
+      REQUIRE ( bulk.size() == all.size() );
+      REQUIRE ( bulk.numberOfNodes() <= inserted.numberOfNodes() );
+      for (int q = 0; q < 30; ++q) {
+        const AABB<float2> range(float2(std::rand() % 200 - 100, std::rand() % 200 - 100), std::rand() % 30);
+        REQUIRE ( bulk.countRange(range) == inserted.countRange(range) );
+        REQUIRE ( bulk.queryRange(range).size() == inserted.countRange(range) );
+      }
+
+      QuadTree<float2> grown(bulk);
+      for (int i = 0; i < 100; ++i)
+        REQUIRE ( grown.insert(float2(i - 50, 0.5f)) == true );
+      REQUIRE ( grown.countRange(AABB<float2>(float2(0, 0.5f), 0)) == 1 );
+      REQUIRE ( grown.points().size() == all.size() + 100 );
+    }
+  }
+}
+
+TEST_CASE( "Quad tree removal", "[quad_tree][data_structure]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 100);
+
+  SECTION("missing points") {
+    QuadTree<float2> t(boundary, 2);
+    REQUIRE ( t.remove(float2(1, 1)) == false );
+    t.insert(float2(1, 1));
+    REQUIRE ( t.remove(float2(1, 2)) == false );
+    REQUIRE ( t.remove(float2(200, 0)) == false );
+    REQUIRE ( t.move(float2(1, 2), float2(3, 3)) == false );
+    REQUIRE ( t.move(float2(1, 1), float2(300, 3)) == false );
+    REQUIRE ( t.size() == 1 );
+    REQUIRE ( t.points() == std::vector<float2>(1, float2(1, 1)) );
+  }
+
+  SECTION("removing everything merges back into the root") {
+    QuadTree<float2> t(boundary, 3);
+    std::vector<float2> all;
+    for (int i = 0; i < 200; ++i)
+      all.push_back(float2(i - 100, (i * 37) % 200 - 100));
+    for (const auto& p : all)
+      t.insert(p);
+    const std::size_t nodes = t.numberOfNodes();
+    REQUIRE ( nodes > 50 );
+
+    for (std::size_t i = 0; i < all.size(); ++i) {
+      REQUIRE ( t.remove(all[i]) == true );
+      REQUIRE ( t.size() == all.size() - i - 1 );
+      REQUIRE ( t.countRange(boundary) == t.size() );
+    }
+    REQUIRE ( t.empty() );
+    REQUIRE ( t.numberOfNodes() == 1 );
+
+    // the freed nodes are reused
+    for (const auto& p : all)
+      t.insert(p);
+    REQUIRE ( t.numberOfNodes() == nodes );
+    REQUIRE ( t.points().size() == all.size() );
+  }
+
+  SECTION("equal points") {
+    QuadTree<float2> t(boundary, 2);
+    for (int i = 0; i < 30; ++i)
+      t.insert(float2(5, 5));
+    t.insert(float2(-5, -5));
+    for (int i = 0; i < 29; ++i)
+      REQUIRE ( t.remove(float2(5, 5)) == true );
+    REQUIRE ( t.countRange(AABB<float2>(float2(5, 5), 0)) == 1 );
+    REQUIRE ( t.remove(float2(5, 5)) == true );
+    REQUIRE ( t.numberOfNodes() == 1 );
+    REQUIRE ( t.remove(float2(5, 5)) == false );
+    REQUIRE ( t.points() == std::vector<float2>(1, float2(-5, -5)) );
+  }
+
+  SECTION("random moves and removals, same queries as a linear scan") {
+    std::srand(17);
+    std::vector<float2> all;
+    for (int i = 0; i < 3000; ++i)
+      all.push_back(float2(std::rand() % 201 - 100, std::rand() % 201 - 100));
+
+    for (const std::size_t capacity : { 1, 4, 16 }) {
+      std::vector<float2> live(all);
+      QuadTree<float2> t(boundary, live, capacity);
+      for (int step = 0; step < 3000; ++step) {
+        const std::size_t i = std::rand() % live.size();
+        if (step % 3 == 0) {
+          REQUIRE ( t.remove(live[i]) == true );
+          live[i] = live.back();
+          live.pop_back();
+        } else {
+          // mostly short steps, as when dragging
+          const float2 to(std::max(-100.0f, std::min(100.0f, live[i].x + std::rand() % 5 - 2)),
+                          std::max(-100.0f, std::min(100.0f, live[i].y + std::rand() % (step % 7 == 0 ? 201 : 5) - 2)));
+          REQUIRE ( t.move(live[i], to) == true );
+          live[i] = to;
+        }
+      }
+
+      REQUIRE ( t.size() == live.size() );
+      REQUIRE ( t.points().size() == live.size() );
+      for (int q = 0; q < 30; ++q) {
+        const AABB<float2> range(float2(std::rand() % 200 - 100, std::rand() % 200 - 100), std::rand() % 30);
+        std::size_t expected = 0;
+        for (const auto& p : live)
+          expected += range.containsPoint(p) ? 1 : 0;
+        REQUIRE ( t.countRange(range) == expected );
+        REQUIRE ( t.queryRange(range).size() == expected );
+      }
+
+      const float2 p(std::rand() % 200 - 100, std::rand() % 200 - 100);
+      const std::vector<float2> nearest = t.nearestNeighbours(p, 5);
+      std::vector<float> distances;
+      for (const auto& q : live)
+        distances.push_back((q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y));
+      std::sort(distances.begin(), distances.end());
+      REQUIRE ( nearest.size() == 5 );
+      const float dx = nearest.back().x - p.x, dy = nearest.back().y - p.y;
+      const float distance = dx * dx + dy * dy;
+      REQUIRE ( distance == distances[4] );
+    }
+  }
+}
+
+TEST_CASE( "Quad tree growing bounds", "[quad_tree][data_structure]" ) {
+
+  SECTION("fixed bounds drop outside points") {
+    QuadTree<float2> t(AABB<float2>(float2(0, 0), 1));
+    REQUIRE ( t.boundsMode() == QuadTree<float2>::FIXED_BOUNDS );
+    REQUIRE ( t.insert(float2(5, 5)) == false );
+  }
+
+  SECTION("the root doubles towards outside points") {
+    QuadTree<float2> t(AABB<float2>(float2(0, 0), 1), 2, QuadTree<float2>::GROWING_BOUNDS);
+    REQUIRE ( t.insert(float2(0.5f, 0.5f)) == true );
+    REQUIRE ( t.insert(float2(5, 5)) == true );
+    REQUIRE ( t.boundary().containsPoint(float2(5, 5)) );
+    REQUIRE ( t.boundary().containsPoint(float2(0.5f, 0.5f)) );
+    REQUIRE ( t.boundary().m_halfWidth == 4 ); // centered at (3, 3)
+    REQUIRE ( t.boundary().m_halfHeight == 4 );
+    REQUIRE ( t.insert(float2(-1000, 3)) == true );
+    REQUIRE ( t.size() == 3 );
+    REQUIRE ( t.countRange(AABB<float2>(float2(-1000, 3), 0)) == 1 );
+
+    REQUIRE ( t.insert(float2(std::numeric_limits<float>::infinity(), 0)) == false );
+    REQUIRE ( t.insert(float2(std::numeric_limits<float>::quiet_NaN(), 0)) == false );
+    REQUIRE ( t.size() == 3 );
+  }
+
+  SECTION("streamed points, some on the sides of the old roots") {
+    std::srand(5);
+    for (const std::size_t capacity : { 1, 3, 8 }) {
+      QuadTree<float2> t(AABB<float2>(float2(0, 0), 1), capacity, QuadTree<float2>::GROWING_BOUNDS);
+      std::vector<float2> all;
+      for (int i = 0; i < 2000; ++i) {
+        // a random walk, on a grid, spreading out
+        const float2 last = all.empty() ? float2(0, 0) : all.back();
+        const int step = 1 + i / 200;
+        const float2 p(last.x + std::rand() % (2 * step + 1) - step, last.y + std::rand() % (2 * step + 1) - step);
+        all.push_back(p);
+        REQUIRE ( t.insert(p) == true );
+      }
+      REQUIRE ( t.size() == all.size() );
+
+      for (int q = 0; q < 30; ++q) {
+        const float2& c = all[std::rand() % all.size()];
+        const AABB<float2> range(c, std::rand() % 20);
+        std::size_t expected = 0;
+        for (const auto& p : all)
+          expected += range.containsPoint(p) ? 1 : 0;
+        REQUIRE ( t.countRange(range) == expected );
+      }
+
+      // removal descends like insertion, so it finds every point
+      for (const auto& p : all)
+        REQUIRE ( t.remove(p) == true );
+      REQUIRE ( t.empty() );
+      REQUIRE ( t.numberOfNodes() == 1 );
+    }
+  }
+
+  SECTION("moving outside of the root grows it") {
+    QuadTree<float2> t(AABB<float2>(float2(0, 0), 8), 1, QuadTree<float2>::GROWING_BOUNDS);
+    for (int i = -3; i <= 3; ++i)
+      REQUIRE ( t.insert(float2(i, i)) == true );
+    REQUIRE ( t.move(float2(1, 1), float2(100, 100)) == true );
+    REQUIRE ( t.boundary().containsPoint(float2(100, 100)) );
+    REQUIRE ( t.nearestNeighbours(float2(100, 100), 1) == std::vector<float2>(1, float2(100, 100)) );
+    REQUIRE ( t.countRange(AABB<float2>(float2(1, 1), 0)) == 0 );
+    REQUIRE ( t.size() == 7 );
+
+    REQUIRE ( t.move(float2(50, 50), float2(-200, 0)) == false ); // not in the tree
+    REQUIRE ( t.move(float2(2, 2), float2(std::numeric_limits<float>::infinity(), 0)) == false );
+    REQUIRE ( t.countRange(AABB<float2>(float2(2, 2), 0)) == 1 );
+    REQUIRE ( t.size() == 7 );
+
+    QuadTree<float2> fixed(AABB<float2>(float2(0, 0), 8));
+    REQUIRE ( fixed.insert(float2(1, 1)) == true );
+    REQUIRE ( fixed.move(float2(1, 1), float2(100, 100)) == false );
+    REQUIRE ( fixed.countRange(AABB<float2>(float2(1, 1), 0)) == 1 );
+  }
+
+  SECTION("half dimensions that are not powers of two") {
+    // doubling them is rounded after a step or two, the root is snapped then
+    std::srand(17);
+    for (const float half : { 0.1f, 1.0f / 3, 0.3f }) {
+      for (const std::size_t capacity : { 1, 8 }) {
+        QuadTree<float2> t(AABB<float2>(float2(0, 0), half), capacity, QuadTree<float2>::GROWING_BOUNDS);
+        std::vector<float2> all = { float2(0.05f, -0.05f), float2(0.7f, -1.3f) };
+        for (int i = 0; i < 199; ++i)
+          all.push_back(float2((std::rand() % 2001 - 1000) / 7.0f, (std::rand() % 2001 - 1000) / 3.0f));
+        for (const auto& p : all)
+          REQUIRE ( t.insert(p) == true );
+        REQUIRE ( t.size() == all.size() );
+
+        for (const auto& p : all) {
+          REQUIRE ( t.boundary().containsPoint(p) );
+          REQUIRE ( t.countRange(AABB<float2>(p, 0)) >= 1 );
+        }
+        for (const auto& p : all)
+          REQUIRE ( t.remove(p) == true );
+        REQUIRE ( t.empty() );
+      }
+
+      const std::vector<float2> bulk_points = { float2(0.7f, -1.3f), float2(-90.1f, 45.3f) };
+      const QuadTree<float2> bulk(AABB<float2>(float2(0, 0), half), bulk_points, 1, QuadTree<float2>::GROWING_BOUNDS);
+      REQUIRE ( bulk.size() == 2 );
+    }
+  }
+
+  SECTION("bulk load") {
+    const std::vector<float2> all = { float2(-300, 2), float2(0, 0), float2(40, 900), float2(40, 900) };
+    const QuadTree<float2> t(AABB<float2>(float2(0, 0), 1), all, 1, QuadTree<float2>::GROWING_BOUNDS);
+    REQUIRE ( t.size() == 4 );
+    for (const auto& p : all)
+      REQUIRE ( t.boundary().containsPoint(p) );
+  }
+}
+
+TEST_CASE( "Quad tree with a rectangular boundary", "[quad_tree][data_structure]" ) {
+
+  // a wide map: 1000 x 20
+  const AABB<float2> boundary(float2(500, 10), 500, 10);
+  std::srand(31);
+  std::vector<float2> all;
+  for (int i = 0; i < 3000; ++i)
+    all.push_back(float2(std::rand() % 1001, std::rand() % 201 / 10.0f));
+
+  for (const std::size_t capacity : { 1, 8 }) {
+    QuadTree<float2> t(boundary, capacity);
+    for (const auto& p : all)
+      REQUIRE ( t.insert(p) == true );
+    REQUIRE ( t.insert(float2(500, 25)) == false );
+    REQUIRE ( t.boundary().m_halfWidth == 500 );
+    REQUIRE ( t.boundary().m_halfHeight == 10 );
+
+    const QuadTree<float2> bulk(boundary, all, capacity);
+    for (int q = 0; q < 30; ++q) {
+      // viewports wider than high
+      const AABB<float2> range(float2(std::rand() % 1000, std::rand() % 20), std::rand() % 100, std::rand() % 5);
+      std::size_t expected = 0;
+      for (const auto& p : all)
+        expected += range.containsPoint(p) ? 1 : 0;
+      REQUIRE ( t.countRange(range) == expected );
+      REQUIRE ( t.queryRange(range).size() == expected );
+      REQUIRE ( bulk.countRange(range) == expected );
+    }
+
+    const float2 p(std::rand() % 1000, std::rand() % 20);
+    std::vector<float> distances;
+    for (const auto& q : all)
+      distances.push_back((q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y));
+    std::sort(distances.begin(), distances.end());
+    const std::vector<float2> nearest = t.nearestNeighbours(p, 3);
+    const float dx = nearest.back().x - p.x, dy = nearest.back().y - p.y;
+    const float distance = dx * dx + dy * dy;
+    REQUIRE ( distance == distances[2] );
+  }
+
+  SECTION("growing keeps the aspect ratio") {
+    QuadTree<float2> t(AABB<float2>(float2(0, 0), 4, 1), 2, QuadTree<float2>::GROWING_BOUNDS);
+    REQUIRE ( t.insert(float2(-30, 0.5f)) == true );
+    REQUIRE ( t.boundary().m_halfWidth == 4 * t.boundary().m_halfHeight );
+    REQUIRE ( t.boundary().containsPoint(float2(-30, 0.5f)) );
+  }
+}
+
+TEST_CASE( "Quad tree batched range queries", "[quad_tree][data_structure]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 100);
+
+  SECTION("insideMask as containsPoint") {
+    // on the sides, just outside, far away and NaN
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const AABB<float2> box(float2(1.5f, -2), 3, 0.5f);
+    const std::vector<float> xs = { 4.5f, -1.5f, 4.5001f, -1.5001f, 1.5f, 1000, nan, 0, 1, 2, 3, 4, -1, -1.5f, 4.5f, 0 };
+    const std::vector<float> ys = { -2, -1.5f, -2, -2, -2.5001f, -2, -2, nan, -1.5f, -2.5f, -1.49f, -2, -2, -2.5f, -1.5f, -2.51f };
+    for (std::size_t first = 0; first < xs.size(); first += detail::simd_width) {
+      const unsigned mask = detail::insideMask(xs.data() + first, ys.data() + first, box.m_center.x, box.m_center.y,
+                                               box.m_halfWidth, box.m_halfHeight);
+      for (std::size_t i = 0; i < detail::simd_width; ++i) {
+        const bool inside = (mask >> i) & 1;
+        REQUIRE ( inside == box.containsPoint(float2(xs[first + i], ys[first + i])) );
+      }
+    }
+  }
+
+  SECTION("empty") {
+    const QuadTree<float2> t(boundary);
+    REQUIRE ( t.countRanges(std::vector<AABB<float2> >(3, boundary)) == std::vector<std::size_t>(3, 0) );
+    REQUIRE ( t.queryRanges(std::vector<AABB<float2> >()).empty() );
+  }
+
+  SECTION("same results as one query per range") {
+    std::srand(29);
+    std::vector<float2> all;
+    for (int i = 0; i < 3000; ++i)
+      all.push_back(float2(std::rand() % 201 - 100, std::rand() % 201 - 100));
+
+    std::vector<AABB<float2> > ranges;
+    for (int q = 0; q < 200; ++q)
+      ranges.push_back(AABB<float2>(float2(std::rand() % 240 - 120, std::rand() % 240 - 120), std::rand() % 40, std::rand() % 40));
+    ranges.push_back(boundary);
+    ranges.push_back(AABB<float2>(float2(0, 0), 1000));
+    ranges.push_back(AABB<float2>(all.front(), 0));
+    ranges.push_back(AABB<float2>(float2(500, 500), 10));
+
+    // leaves of sizes that are no multiple of detail::simd_width, and long chains of equal points
+    for (const std::size_t capacity : { 1, 3, 8, 13, 64 }) {
+      QuadTree<float2> t(boundary, all, capacity);
+      for (int i = 0; i < 100; ++i)
+        t.insert(float2(7, 7));
+      for (int i = 0; i < 1000; ++i)
+        t.remove(all[i]);
+
+      const std::vector<std::size_t> counts = t.countRanges(ranges);
+      const std::vector<std::vector<float2> > found = t.queryRanges(ranges);
+      REQUIRE ( counts.size() == ranges.size() );
+      REQUIRE ( found.size() == ranges.size() );
+      for (std::size_t r = 0; r < ranges.size(); ++r) {
+        const std::vector<float2> expected = t.queryRange(ranges[r]);
+        REQUIRE ( found[r] == expected );
+        REQUIRE ( counts[r] == expected.size() );
+      }
+
+      std::vector<std::size_t> visited(ranges.size(), 0);
+      t.forEachInRanges(ranges, [&](std::size_t r, const float2& p) { visited[r] += ranges[r].containsPoint(p) ? 1 : 0; });
+      REQUIRE ( visited == counts );
+    }
+  }
+}
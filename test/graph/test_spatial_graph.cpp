@@ -0,0 +1,145 @@
+#include <graph/spatial_graph.hpp>
+#include <graph/graph_generators.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+/// Both indexes answer like scans over the graph.
+void requireInSync(const SpatialGraph<float2>& s, const AABB<float2>& range)
+{
+  const Graph<float2>& g = s.graph();
+  REQUIRE ( s.numberOfVertices() == numberOfVertices(g) );
+
+  std::size_t vertices = 0;
+  for (const auto& v : g)
+    vertices += range.containsPoint(v) ? 1 : 0;
+  REQUIRE ( s.verticesInBox(range).size() == vertices );
+
+  std::size_t edges = 0;
+  for (const auto& e : ::edges(g))
+    edges += range.intersectsSegment(e.source, e.destination) ? 1 : 0;
+  const std::vector<Graph<float2>::Edge> found = s.edgesInBox(range);
+  REQUIRE ( found.size() == edges / 2 ); // stored in both directions
+  for (const auto& e : found)
+    REQUIRE ( connected(g, e.source, e.destination) );
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Spatial graph", "[spatial_graph][quad_tree]" ) {
+
+  const AABB<float2> boundary(float2(0, 0), 10);
+
+  SECTION("mutations") {
+    SpatialGraph<float2> s(boundary, 2);
+    s.addEdge(float2(0, 0), float2(4, 0));
+    s.addEdge(float2(4, 0), float2(4, 4));
+    s.addEdge(float2(4, 0), float2(0, 0)); // multiedge
+    s.addVertex(float2(-3, -3));
+    s.addVertex(float2(-3, -3));
+    REQUIRE ( s.numberOfVertices() == 4 );
+    REQUIRE ( s.contains(float2(4, 4)) );
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(2, 0), 0.5f)).size() == 1 );
+
+    REQUIRE ( s.nearestVertices(float2(3, 3)) == std::vector<float2>(1, float2(4, 4)) );
+    REQUIRE ( s.nearestVertices(float2(-1, -1), 2) == std::vector<float2>({ float2(0, 0), float2(-3, -3) }) );
+
+    // moving takes the edges along
+    s.modifyVertex(float2(4, 4), float2(8, 8));
+    REQUIRE ( !s.contains(float2(4, 4)) );
+    REQUIRE ( connected(s.graph(), float2(4, 0), float2(8, 8)) );
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(6, 4), 0.1f)).size() == 1 );
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(4, 2), 0.1f)).empty() );
+    s.modifyVertex(float2(8, 8), float2(0, 0)); // taken
+    REQUIRE ( s.contains(float2(8, 8)) );
+
+    // outside of the boundary
+    s.addEdge(float2(8, 8), float2(50, 8));
+    REQUIRE ( s.verticesInBox(AABB<float2>(float2(50, 8), 1)).size() == 1 );
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(30, 8), 1)).size() == 1 );
+
+    s.removeEdge(float2(0, 0), float2(4, 0));
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(2, 0), 0.5f)).empty() );
+    s.removeVertex(float2(4, 0));
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(6, 4), 0.1f)).empty() );
+    REQUIRE ( s.numberOfVertices() == 4 );
+    requireInSync(s, AABB<float2>(float2(0, 0), 100));
+
+    s.clear();
+    REQUIRE ( s.numberOfVertices() == 0 );
+    REQUIRE ( s.nearestVertices(float2(0, 0)).empty() );
+  }
+
+  SECTION("outside of the initial boundary") {
+    SpatialGraph<float2> s(AABB<float2>(float2(0, 0), 8), 2);
+    s.addEdge(float2(1, 1), float2(2, 2));
+    s.addEdge(float2(2, 2), float2(-1, 3));
+    s.modifyVertex(float2(1, 1), float2(100, 100));
+    REQUIRE ( s.contains(float2(100, 100)) );
+    REQUIRE ( !s.contains(float2(1, 1)) );
+    REQUIRE ( s.nearestVertices(float2(100, 100)) == std::vector<float2>(1, float2(100, 100)) );
+    REQUIRE ( s.edgesInBox(AABB<float2>(float2(51, 51), 0.5f)).size() == 1 );
+
+    REQUIRE ( s.addVertex(float2(-300, 40)) == true );
+    REQUIRE ( s.nearestVertices(float2(-290, 40)) == std::vector<float2>(1, float2(-300, 40)) );
+    s.modifyVertex(float2(-300, 40), float2(0.1f, -700.3f));
+    REQUIRE ( s.contains(float2(0.1f, -700.3f)) );
+    requireInSync(s, AABB<float2>(float2(0, 0), 1000));
+
+    // the vertex tree can not hold these, the graph is left as it is
+    const float inf = std::numeric_limits<float>::infinity();
+    REQUIRE ( s.addVertex(float2(inf, 0)) == false );
+    s.modifyVertex(float2(2, 2), float2(0, inf));
+    REQUIRE ( s.contains(float2(2, 2)) );
+    s.addEdge(float2(5, 5), float2(inf, inf));
+    REQUIRE ( !s.contains(float2(5, 5)) );
+    REQUIRE ( s.numberOfVertices() == 4 );
+    REQUIRE ( numberOfVertices(s.graph()) == 4 );
+    requireInSync(s, AABB<float2>(float2(0, 0), 1000));
+  }
+
+  SECTION("random graph, random changes") {
+    const std::vector<Graph<float2>::Edge> edges = randomGeometricEdges<float2>(400, 1.5, 7);
+    const Graph<float2> g(edges);
+    float extent = 0;
+    for (const auto& v : g)
+      extent = std::max(extent, std::max(std::fabs(v.x), std::fabs(v.y)));
+
+    SpatialGraph<float2> s(g, AABB<float2>(float2(extent / 2, extent / 2), extent / 2 + 1), 4);
+    REQUIRE ( s.graph() == g );
+
+    std::srand(19);
+    for (int step = 0; step < 300; ++step) {
+      const std::vector<float2> vertices = s.graph().vertices();
+      const float2 v = vertices[std::rand() % vertices.size()];
+      const float2 u = vertices[std::rand() % vertices.size()];
+      switch (step % 4) {
+        case 0: s.modifyVertex(v, float2(v.x + (std::rand() % 21 - 10) / 10.0f, v.y + (std::rand() % 21 - 10) / 10.0f)); break;
+        case 1: s.addEdge(v, u); break;
+        case 2: s.removeEdge(v, s.graph().neighboursOf(v).empty() ? u : s.graph().neighboursOf(v).front()); break;
+        case 3: s.removeVertex(v); s.addVertex(float2(u.x + 0.5f, u.y - 0.25f)); break;
+      }
+      if (step % 50 == 0)
+        requireInSync(s, AABB<float2>(float2(extent / 2, extent / 2), extent));
+    }
+
+    for (int q = 0; q < 20; ++q) {
+      const AABB<float2> range(float2(std::rand() % int(extent), std::rand() % int(extent)), std::rand() % 5 + 0.5f, std::rand() % 3 + 0.5f);
+      requireInSync(s, range);
+
+      const float2 p(std::rand() % int(extent), std::rand() % int(extent));
+      float best = std::numeric_limits<float>::max();
+      for (const auto& v : s.graph())
+        best = std::min(best, distance(p, v));
+      REQUIRE ( distance(p, s.nearestVertices(p).front()) == best );
+    }
+  }
+}
@@ -0,0 +1,197 @@
+#include <graph/visibility_graph.hpp>
+#include <graph/jump_point_search.hpp>
+
+#include "../catch.hpp"
+
+#include "fixture.hpp"
+
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace {
+
+/// Shortest route between the centres of two cells, infinite if there is none.
+float routeLength(const ImageMatrix& m, const size_t2& start, const size_t2& goal)
+{
+  GraphWD<float2, float> g = visibilityGraph<float2>(m);
+  const float2 s(start.x + 0.5f, start.y + 0.5f), t(goal.x + 0.5f, goal.y + 0.5f);
+  addVisibilityPoint(g, m, s);
+  addVisibilityPoint(g, m, t);
+
+  typedef std::pair<float, float2> entry;
+  std::priority_queue<entry, std::vector<entry>, std::greater<entry> > q;
+  std::unordered_map<float2, float> dist;
+  dist[s] = 0.0f;
+  q.push(entry(0.0f, s));
+  while (!q.empty()) {
+    const entry top = q.top();
+    q.pop();
+    if (top.second == t)
+      return top.first;
+    if (top.first > dist[top.second])
+      continue;
+
+    g.forEachEdgeFrom(top.second, [&](const float2& v, float w) {
+      const auto it = dist.find(v);
+      if (it == dist.end() || top.first + w < it->second) {
+        dist[v] = top.first + w;
+        q.push(entry(top.first + w, v));
+      }
+    });
+  }
+  return std::numeric_limits<float>::infinity();
+}
+
+/// Reference line of sight: all grid line crossings collected and sorted up front.
+bool lineOfSightBySorting(const ImageMatrix& m, double ax, double ay, double bx, double by)
+{
+  const double dx = bx - ax, dy = by - ay;
+  std::vector<double> ts { 0.0, 1.0 };
+  if (dx != 0.0)
+    for (double k = std::floor(std::min(ax, bx)) + 1.0; k < std::max(ax, bx); k += 1.0)
+      ts.push_back((k - ax) / dx);
+  if (dy != 0.0)
+    for (double k = std::floor(std::min(ay, by)) + 1.0; k < std::max(ay, by); k += 1.0)
+      ts.push_back((k - ay) / dy);
+  std::sort(ts.begin(), ts.end());
+
+  for (std::size_t i = 0; i + 1 < ts.size(); ++i) {
+    if (ts[i + 1] - ts[i] < 1e-12)
+      continue;
+    const double t = 0.5 * (ts[i] + ts[i + 1]);
+    long x0, x1, y0, y1;
+    detail::visibilityCellRange(ax + t * dx, x0, x1);
+    detail::visibilityCellRange(ay + t * dy, y0, y1);
+    bool passable = false;
+    for (long y = y0; y <= y1; ++y)
+      for (long x = x0; x <= x1; ++x)
+        passable = passable || !detail::visibilityBlocked(m, x, y);
+    if (!passable)
+      return false;
+
+    if (ts[i + 1] < 1.0 - 1e-12) {
+      const double px = ax + ts[i + 1] * dx, py = ay + ts[i + 1] * dy;
+      const double rx = std::floor(px + 0.5), ry = std::floor(py + 0.5);
+      if (std::fabs(px - rx) < 1e-9 && std::fabs(py - ry) < 1e-9) {
+        const long x = long(rx), y = long(ry);
+        if ((detail::visibilityBlocked(m, x - 1, y - 1) && detail::visibilityBlocked(m, x, y)) ||
+            (detail::visibilityBlocked(m, x, y - 1) && detail::visibilityBlocked(m, x - 1, y)))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+float gridLength(const ImageMatrix& m, const size_t2& start, const size_t2& goal)
+{
+  const std::vector<size_t2> path = expandJumpPath(JumpPointSearch(m).findPath(start, goal));
+  if (path.empty())
+    return std::numeric_limits<float>::infinity();
+
+  float length = 0.0f;
+  for (std::size_t i = 1; i < path.size(); ++i)
+    length += (path[i].x != path[i-1].x && path[i].y != path[i-1].y) ? std::sqrt(2.0f) : 1.0f;
+  return length;
+}
+
+} // anonymous namespace
+
+
+TEST_CASE( "Visibility graph", "[visibility_graph][algorithm]" ) {
+
+  SECTION("line of sight") {
+    const ImageMatrix m = parseMap({
+      "....",
+      ".#..",
+      "..#.",
+      "...." });
+
+    REQUIRE( lineOfSight(m, 0.5, 0.5, 3.5, 0.5) == true );
+    REQUIRE( lineOfSight(m, 0.5, 1.5, 3.5, 1.5) == false );
+    REQUIRE( lineOfSight(m, 1.0, 0.0, 1.0, 4.0) == true );  // along the side of an obstacle
+    REQUIRE( lineOfSight(m, 0.0, 1.0, 4.0, 1.0) == true );
+    REQUIRE( lineOfSight(m, 3.0, 1.0, 1.0, 3.0) == false ); // through the diagonal contact
+    REQUIRE( lineOfSight(m, 0.5, 3.5, 3.5, 0.5) == false );
+    REQUIRE( lineOfSight(m, 3.5, 0.5, 3.5, 3.5) == true );
+    REQUIRE( lineOfSight(m, -0.5, 0.5, 0.5, 0.5) == false );
+  }
+
+  SECTION("line of sight agrees with sorting all crossings") {
+    std::srand(5);
+    const std::size_t w = 12, h = 10;
+    std::vector<ImageMatrix::CellType> cells(w * h);
+    for (auto& c : cells)
+      c = (std::rand() % 4 == 0) ? ImageMatrix::SOLID : ImageMatrix::FREE;
+    const ImageMatrix m(w, h, cells);
+
+    // lattice points, cell centres and quarters, so lines through corners are common
+    auto coordinate = [](std::size_t extent) { return (std::rand() % (4 * extent + 1)) / 4.0; };
+    for (int i = 0; i < 4000; ++i) {
+      const double ax = coordinate(w), ay = coordinate(h), bx = coordinate(w), by = coordinate(h);
+      REQUIRE( lineOfSight(m, ax, ay, bx, by) == lineOfSightBySorting(m, ax, ay, bx, by) );
+    }
+  }
+
+  SECTION("corners and bitangents") {
+    const ImageMatrix m = parseMap({
+      "........",
+      "..####..",
+      "........" });
+
+    REQUIRE( visibilityCorners(m).size() == 4 );
+
+    const GraphWD<float2, float> g = visibilityGraph<float2>(m);
+    REQUIRE( g.numberOfVertices() == 4 );
+    REQUIRE( g.weights(float2(2, 1), float2(6, 1)) == std::vector<float>(1, 4.0f) );
+    REQUIRE( g.weights(float2(2, 1), float2(2, 2)) == std::vector<float>(1, 1.0f) );
+    REQUIRE( g.weights(float2(2, 1), float2(6, 2)).empty() ); // through the wall
+
+    REQUIRE( routeLength(m, size_t2(0, 1), size_t2(7, 1)) == Approx(4.0f + 2 * std::sqrt(1.5f * 1.5f + 0.5f * 0.5f)) );
+    REQUIRE( routeLength(m, size_t2(0, 0), size_t2(7, 0)) == Approx(7.0f) );
+  }
+
+  SECTION("unreachable") {
+    const ImageMatrix m = parseMap({
+      "..#..",
+      "..#..",
+      "..#.." });
+    REQUIRE( routeLength(m, size_t2(0, 1), size_t2(4, 1)) == std::numeric_limits<float>::infinity() );
+  }
+
+  SECTION("random maps: between the straight line and the grid path") {
+    std::srand(21);
+    for (int map = 0; map < 10; ++map) {
+      const std::size_t w = 24, h = 18;
+      std::vector<ImageMatrix::CellType> cells(w * h, ImageMatrix::FREE);
+      for (int r = 0; r < 12; ++r) {
+        const std::size_t x0 = std::rand() % w, y0 = std::rand() % h;
+        const std::size_t x1 = std::min(w, x0 + 1 + std::rand() % 5), y1 = std::min(h, y0 + 1 + std::rand() % 5);
+        for (std::size_t y = y0; y < y1; ++y)
+          for (std::size_t x = x0; x < x1; ++x)
+            cells[y * w + x] = ImageMatrix::SOLID;
+      }
+      const ImageMatrix m(w, h, cells);
+
+      for (int query = 0; query < 10; ++query) {
+        const size_t2 s(std::rand() % w, std::rand() % h), t(std::rand() % w, std::rand() % h);
+        if (cells[s.y * w + s.x] != ImageMatrix::FREE || cells[t.y * w + t.x] != ImageMatrix::FREE)
+          continue;
+
+        const float grid = gridLength(m, s, t);
+        const float route = routeLength(m, s, t);
+        if (grid == std::numeric_limits<float>::infinity()) {
+          REQUIRE( route == std::numeric_limits<float>::infinity() );
+          continue;
+        }
+
+        const float dx = float(t.x) - float(s.x), dy = float(t.y) - float(s.y);
+        REQUIRE( route >= std::sqrt(dx * dx + dy * dy) - 1e-4f );
+        REQUIRE( route <= grid + 1e-4f );
+      }
+    }
+  }
+}